@@ -0,0 +1,122 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// Shared parts of the vstruct_bench runtime microbenchmark.
+///
+#ifndef BENCH_BENCH_H_
+#define BENCH_BENCH_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "vstruct.h"
+
+namespace vstruct_bench {
+
+using vstruct::pbuf_type;
+using vstruct::internals::IndexList;
+using vstruct::internals::MakeIndexList;
+
+enum : size_t {
+  fields = 1024,  // fields per pass
+  repeats = 5
+};
+
+struct Result {
+  std::string group;
+  std::string impl;
+  std::string op;
+  size_t Sz;
+  size_t offset;
+  double ns;  // per element
+};
+
+extern std::vector<Result> results;
+extern double min_ns;  // time per repeat
+extern volatile uint64_t sink;  // results of the get loops end here
+extern volatile size_t opaque_zero;  // hides offsets from the optimizer
+
+/// measure - fastest ns per element of pass(), each pass handles fields elements
+template <typename Pass>
+double measure(Pass pass) {
+  typedef std::chrono::steady_clock clock;
+  double best = 0;
+  for (size_t r = 0; r < repeats; r++) {
+    size_t passes = 0;
+    clock::time_point start = clock::now();
+    double elapsed = 0;
+    do {
+      for (size_t i = 0; i < 16; i++) {
+        sink = sink + pass();
+      }
+      passes += 16;
+      elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    } while (elapsed < min_ns);
+    double ns = elapsed / (passes * fields);
+    best = (r == 0 || ns < best) ? ns : best;
+  }
+  return best;
+}
+
+inline void add(const char* group, const char* impl, const char* op, size_t Sz, size_t offset, double ns) {
+  results.push_back(Result{group, impl, op, Sz, offset, ns});
+}
+
+/// Rand - xorshift, the same sequence on every run
+struct Rand {
+  uint64_t x = 0x9E3779B97F4A7C15ull;
+  uint64_t next() {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return x;
+  }
+};
+
+inline std::vector<size_t> random_indices(size_t n) {
+  Rand rand;
+  std::vector<size_t> indices(fields);
+  for (size_t& i : indices) {
+    i = static_cast<size_t>(rand.next() % n);
+  }
+  return indices;
+}
+
+/// hand written shift and mask of Sz bits at bit
+template <size_t Sz>
+uint64_t hand_get(const pbuf_type* p, size_t bit) {
+  uint64_t x;
+  memcpy(&x, p + (bit >> 3), 8);
+  x >>= (bit & 7);
+  if ((bit & 7) + Sz > 64) {
+    x |= static_cast<uint64_t>(p[(bit >> 3) + 8]) << (64 - (bit & 7));
+  }
+  return x & vstruct::internals::low_mask<uint64_t>(Sz);
+}
+
+template <size_t Sz>
+void hand_set(pbuf_type* p, size_t bit, uint64_t value) {
+  const uint64_t mask = vstruct::internals::low_mask<uint64_t>(Sz);
+  size_t shift = bit & 7;
+  uint64_t x;
+  memcpy(&x, p + (bit >> 3), 8);
+  x = (x & ~(mask << shift)) | ((value & mask) << shift);
+  memcpy(p + (bit >> 3), &x, 8);
+  if (shift + Sz > 64) {
+    pbuf_type spill_mask = static_cast<pbuf_type>(mask >> (64 - shift));
+    p[(bit >> 3) + 8] = (p[(bit >> 3) + 8] & ~spill_mask) | static_cast<pbuf_type>((value & mask) >> (64 - shift));
+  }
+}
+
+/// bench_leorder_sizes - LEOrder cases for Sz first_sz to first_sz + 15, one translation unit per range
+template <size_t first_sz>
+void bench_leorder_sizes();
+
+}  // namespace vstruct_bench
+
+#endif  // BENCH_BENCH_H_
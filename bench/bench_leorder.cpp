@@ -0,0 +1,160 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// LEOrder cases of vstruct_bench. Built once per range of 16 sizes, VSTRUCT_BENCH_FIRST_SZ is the first size,
+/// so the ranges compile in parallel.
+///
+#include <stdint.h>
+#include <type_traits>
+#include "./bench.h"
+
+#ifndef VSTRUCT_BENCH_FIRST_SZ
+#define VSTRUCT_BENCH_FIRST_SZ 1
+#endif
+
+namespace vstruct_bench {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// LEOrder, Sz 1 to 64 at offsets 0 to 7
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Unsigned - smallest unsigned type holding Sz bits
+template <size_t Sz>
+using Unsigned = typename std::conditional<(Sz <= 8), uint8_t,
+                 typename std::conditional<(Sz <= 16), uint16_t,
+                 typename std::conditional<(Sz <= 32), uint32_t, uint64_t>::type>::type>::type;
+
+/// BitField - native bitfield at bit offset, one 64 bit unit per field
+template <size_t Sz, size_t offset>
+struct BitField {
+  uint64_t pad : offset;
+  uint64_t value : Sz;
+};
+
+template <size_t Sz>
+struct BitField<Sz, 0> {
+  uint64_t value : Sz;
+};
+
+/// LEOrderAt for field k of a pass, the offsets are compile time constants
+template <typename T, size_t Sz, size_t offset, size_t k = 0, bool done = (k >= 16)>
+struct FixedFields {
+  using Order = vstruct::internals::LEOrderAt<T, Sz, offset + k * 64>;
+  static uint64_t get(const pbuf_type* p) {
+    return Order::get(p) + FixedFields<T, Sz, offset, k + 1>::get(p);
+  }
+  static void set(pbuf_type* p, T x) {
+    Order::set(p, x);
+    FixedFields<T, Sz, offset, k + 1>::set(p, static_cast<T>(x + 1));
+  }
+};
+
+template <typename T, size_t Sz, size_t offset, size_t k>
+struct FixedFields<T, Sz, offset, k, true> {
+  static uint64_t get(const pbuf_type*) {
+    return 0;
+  }
+  static void set(pbuf_type*, T) {}
+};
+
+template <size_t Sz, size_t offset>
+void bench_leorder_bitfield(std::true_type) {
+  static BitField<Sz, offset> bitfields[fields];
+  add("leorder", "bitfield", "get", Sz, offset, measure([]() {
+    uint64_t sum = 0;
+    for (size_t k = 0; k < fields; k++) {
+      sum += bitfields[k].value;
+    }
+    return sum;
+  }));
+  add("leorder", "bitfield", "set", Sz, offset, measure([]() {
+    for (size_t k = 0; k < fields; k++) {
+      bitfields[k].value = k;
+    }
+    return static_cast<uint64_t>(bitfields[fields - 1].value);
+  }));
+}
+
+template <size_t Sz, size_t offset>
+void bench_leorder_bitfield(std::false_type) {}  // a bitfield cannot cross its 64 bit unit
+
+template <size_t Sz, size_t offset>
+void bench_leorder() {
+  typedef Unsigned<Sz> T;
+  using Order = vstruct::internals::LEOrder<T, Sz>;
+  using Fixed = FixedFields<T, Sz, offset>;
+  static pbuf_type buffer[fields * 8 + 2 * vstruct::slack_bytes];  // the second slack keeps -Warray-bounds quiet
+  const size_t bytes = fields * 8 + vstruct::slack_bytes;
+
+  add("leorder", "vstruct", "get", Sz, offset, measure([bytes]() {
+    const size_t first = offset + opaque_zero;
+    uint64_t sum = 0;
+    for (size_t k = 0; k < fields; k++) {
+      sum += Order::get(buffer, first + k * 64, bytes);
+    }
+    return sum;
+  }));
+  add("leorder", "vstruct", "set", Sz, offset, measure([bytes]() {
+    const size_t first = offset + opaque_zero;
+    for (size_t k = 0; k < fields; k++) {
+      Order::set(buffer, first + k * 64, static_cast<T>(k), bytes);
+    }
+    return static_cast<uint64_t>(buffer[0]);
+  }));
+  add("leorder", "vstruct_fixed", "get", Sz, offset, measure([]() {
+    uint64_t sum = 0;
+    for (size_t k = 0; k < fields; k += 16) {
+      sum += Fixed::get(buffer + k * 8);
+    }
+    return sum;
+  }));
+  add("leorder", "vstruct_fixed", "set", Sz, offset, measure([]() {
+    for (size_t k = 0; k < fields; k += 16) {
+      Fixed::set(buffer + k * 8, static_cast<T>(k));
+    }
+    return static_cast<uint64_t>(buffer[0]);
+  }));
+  add("leorder", "hand", "get", Sz, offset, measure([]() {
+    const size_t first = offset + opaque_zero;
+    uint64_t sum = 0;
+    for (size_t k = 0; k < fields; k++) {
+      sum += hand_get<Sz>(buffer, first + k * 64);
+    }
+    return sum;
+  }));
+  add("leorder", "hand", "set", Sz, offset, measure([]() {
+    const size_t first = offset + opaque_zero;
+    for (size_t k = 0; k < fields; k++) {
+      hand_set<Sz>(buffer, first + k * 64, k);
+    }
+    return static_cast<uint64_t>(buffer[0]);
+  }));
+  bench_leorder_bitfield<Sz, offset>(std::integral_constant<bool, (offset + Sz <= 64)>());
+}
+
+template <size_t Sz, size_t... offset>
+void bench_leorder_offsets(IndexList<offset...>) {
+  int expand[] = {(bench_leorder<Sz, offset>(), 0)...};
+  (void)expand;
+}
+
+template <size_t first_sz, size_t... I>
+void bench_leorder_range(IndexList<I...>) {
+  int expand[] = {(bench_leorder_offsets<first_sz + I>(MakeIndexList<8>::type()), 0)...};
+  (void)expand;
+}
+
+}  // namespace
+
+template <size_t first_sz>
+void bench_leorder_sizes() {
+  bench_leorder_range<first_sz>(MakeIndexList<16>::type());
+}
+
+template void bench_leorder_sizes<VSTRUCT_BENCH_FIRST_SZ>();
+
+}  // namespace vstruct_bench
@@ -0,0 +1,130 @@
+""" compile_time.py
+
+copyright Joseph Lee Yuan Sheng 2019
+
+Measures the compile time and peak compiler memory of generated structs.
+
+For each field count a struct definition is written, converted to a header
+by vstruct_gen_header.py and included in a translation unit that uses the
+view, the FieldTable and the native load()/store() of the struct. Each
+translation unit is compiled REPEAT times with -fsyntax-only and at -O2,
+the fastest run and the peak resident memory of the compiler are reported.
+
+usage: compile_time.py [--cxx c++] [--fields 10 100 1000] [--output results.csv]
+"""
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+GENERATOR = os.path.join(ROOT, 'py_src', 'vstruct', 'scripts', 'vstruct_gen_header.py')
+REPEAT = 3
+
+# fields cycle through these, a mix of sizes and alignments
+FIELDS = [
+    'BoolItem()',
+    'LEItem(Type.uint8_t, bit_size=3)',
+    'LEItem(Type.int16_t, bit_size=11)',
+    'LEItem(Type.uint32_t, bit_size=26)',
+    'LEItem(Type.int64_t, bit_size=59)',
+    'LEArray(Type.uint8_t, bit_size=4, array_size=3)',
+    'LEItem(Type.float)',
+    'LEItem(Type.double)',
+]
+
+TRANSLATION_UNIT = '''#include <stdio.h>
+#include "vstruct.h"
+#include "bench{n}.h"
+
+int main() {{
+  static vstruct::pbuf_type buffer[Bench{n}::record_bytes + vstruct::slack_bytes];
+  Bench{n}Native n;
+  load(buffer, n);
+  store(n, buffer);
+  Bench{n}View view(buffer);
+  view.f0() = 1;
+  size_t bits = 0;
+  for (const vstruct::FieldDescriptor& d : vstruct::FieldTable<Bench{n}>()) {{
+    bits += d.bit_size();
+  }}
+  printf("%zu\\n", bits);
+  return 0;
+}}
+'''
+
+
+def write_struct(directory, n):
+    """ struct definition with n fields, returns the path of the .py file """
+    path = os.path.join(directory, 'bench{}.py'.format(n))
+    with open(path, 'w') as f:
+        f.write('""" bench{}.py, written by compile_time.py """\n'.format(n))
+        f.write('from vstruct import BoolItem, LEItem, LEArray, Type, VStruct\n\n\n')
+        f.write('class Bench{}(VStruct):\n'.format(n))
+        f.write('    """ {} fields """\n'.format(n))
+        for i in range(n):
+            f.write('    f{} = {}\n'.format(i, FIELDS[i % len(FIELDS)]))
+    return path
+
+
+def generate(directory, n):
+    """ generates bench<n>.h and the translation unit, returns the path of the .cpp file """
+    write_struct(directory, n)
+    env = dict(os.environ)
+    env['PYTHONPATH'] = os.pathsep.join([os.path.join(ROOT, 'py_src'), env.get('PYTHONPATH', '')])
+    subprocess.check_call([sys.executable, GENERATOR, '-f', 'bench{}.py'.format(n), '-o', 'bench{}.h'.format(n)],
+                          cwd=directory, env=env, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    path = os.path.join(directory, 'bench{}.cpp'.format(n))
+    with open(path, 'w') as f:
+        f.write(TRANSLATION_UNIT.format(n=n))
+    return path
+
+
+def compile_once(command):
+    """ (seconds, peak resident kB) of one compiler run """
+    start = time.perf_counter()
+    process = subprocess.Popen(command)
+    _, status, usage = os.wait4(process.pid, 0)
+    seconds = time.perf_counter() - start
+    if status != 0:
+        raise RuntimeError('compile failed: ' + ' '.join(command))
+    return seconds, usage.ru_maxrss
+
+
+def measure(cxx, source, flags):
+    base = [cxx, '-std=c++11', '-I' + os.path.join(ROOT, 'include'), '-I' + os.path.dirname(source)]
+    command = base + flags + [source]
+    runs = [compile_once(command) for _ in range(REPEAT)]
+    return min(r[0] for r in runs), max(r[1] for r in runs)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='compile time of generated structs')
+    parser.add_argument('--cxx', default=os.environ.get('CXX', 'c++'), help='C++ compiler')
+    parser.add_argument('--fields', nargs='*', type=int, default=[10, 100, 1000], help='field counts')
+    parser.add_argument('--output', help='also write the results to this CSV file')
+    args = parser.parse_args()
+
+    modes = [('syntax', ['-fsyntax-only']),
+             ('O2', ['-O2', '-c', '-o', os.devnull])]
+    rows = []
+    with tempfile.TemporaryDirectory() as directory:
+        for n in args.fields:
+            source = generate(directory, n)
+            for mode, flags in modes:
+                seconds, kb = measure(args.cxx, source, flags)
+                rows.append((n, mode, seconds, kb))
+                print('{:>6} fields {:>7}: {:8.3f} s {:10d} kB'.format(n, mode, seconds, kb))
+                sys.stdout.flush()
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write('fields,mode,seconds,peak_kb\n')
+            for n, mode, seconds, kb in rows:
+                f.write('{},{},{:.4f},{}\n'.format(n, mode, seconds, kb))
+
+
+if __name__ == '__main__':
+    main()
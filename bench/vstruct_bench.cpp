@@ -0,0 +1,302 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// Runtime microbenchmark of the accessors.
+///
+/// Every case is compared with native C bitfields, where the compiler can express the layout, and with hand
+/// written shift and mask code on the same buffer:
+///   leorder   LEOrder::get/set, Sz 1 to 64 at bit offsets 0 to 7, runtime and fixed (LEOrderAt) offsets
+///   learray   LEArrayType element access, sequential and random order
+///   boolarray BoolArrayType element access, sequential and random order
+///   packer    Packer::pack of signed values, half of them out of range and saturated
+///
+/// usage: vstruct_bench [--format csv|json] [--output file] [--min-ms ms]
+///   --min-ms: time of each of the 5 repeats of a case, 2 ms by default
+///
+/// One result per line (csv) or per array element (json): group, implementation, operation, Sz, bit offset
+/// and nanoseconds per element. The fastest of the repeats is reported.
+///
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits>
+#include <string>
+#include <vector>
+#include "./bench.h"
+
+namespace vstruct_bench {
+
+std::vector<Result> results;
+double min_ns = 2e6;
+volatile uint64_t sink;
+volatile size_t opaque_zero = 0;
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// LEArrayType
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T, size_t Sz>
+void bench_learray() {
+  enum : size_t {
+    first_bit = 3
+  };
+  using Array = vstruct::ViewField<vstruct::LEArrayType<T, first_bit, Sz, fields>>;
+  static pbuf_type buffer[(first_bit + Sz * fields + 7) / 8 + vstruct::slack_bytes];
+  static const std::vector<size_t> order = random_indices(fields);
+  Array array(buffer);
+
+  add("learray", "vstruct", "get_sequential", Sz, first_bit, measure([&array]() {
+    const Array& a = array;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < fields; i++) {
+      sum += static_cast<uint64_t>(a[i]);
+    }
+    return sum;
+  }));
+  add("learray", "vstruct", "set_sequential", Sz, first_bit, measure([&array]() {
+    for (size_t i = 0; i < fields; i++) {
+      array[i] = static_cast<T>(i);
+    }
+    return static_cast<uint64_t>(buffer[0]);
+  }));
+  add("learray", "vstruct", "get_random", Sz, first_bit, measure([&array]() {
+    const Array& a = array;
+    uint64_t sum = 0;
+    for (size_t i : order) {
+      sum += static_cast<uint64_t>(a[i]);
+    }
+    return sum;
+  }));
+  add("learray", "vstruct", "set_random", Sz, first_bit, measure([&array]() {
+    for (size_t i : order) {
+      array[i] = static_cast<T>(i);
+    }
+    return static_cast<uint64_t>(buffer[0]);
+  }));
+  add("learray", "hand", "get_sequential", Sz, first_bit, measure([]() {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < fields; i++) {
+      sum += hand_get<Sz>(buffer, first_bit + i * Sz);
+    }
+    return sum;
+  }));
+  add("learray", "hand", "set_sequential", Sz, first_bit, measure([]() {
+    for (size_t i = 0; i < fields; i++) {
+      hand_set<Sz>(buffer, first_bit + i * Sz, i);
+    }
+    return static_cast<uint64_t>(buffer[0]);
+  }));
+  add("learray", "hand", "get_random", Sz, first_bit, measure([]() {
+    uint64_t sum = 0;
+    for (size_t i : order) {
+      sum += hand_get<Sz>(buffer, first_bit + i * Sz);
+    }
+    return sum;
+  }));
+  add("learray", "hand", "set_random", Sz, first_bit, measure([]() {
+    for (size_t i : order) {
+      hand_set<Sz>(buffer, first_bit + i * Sz, i);
+    }
+    return static_cast<uint64_t>(buffer[0]);
+  }));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// BoolArrayType
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void bench_boolarray() {
+  enum : size_t {
+    first_bit = 5
+  };
+  using Array = vstruct::ViewField<vstruct::BoolArrayType<first_bit, fields>>;
+  static pbuf_type buffer[(first_bit + fields + 7) / 8 + vstruct::slack_bytes];
+  static const std::vector<size_t> order = random_indices(fields);
+  Array array(buffer);
+
+  add("boolarray", "vstruct", "get_sequential", 1, first_bit, measure([&array]() {
+    const Array& a = array;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < fields; i++) {
+      sum += a[i];
+    }
+    return sum;
+  }));
+  add("boolarray", "vstruct", "set_sequential", 1, first_bit, measure([&array]() {
+    for (size_t i = 0; i < fields; i++) {
+      array[i] = (i & 3) == 0;
+    }
+    return static_cast<uint64_t>(buffer[0]);
+  }));
+  add("boolarray", "vstruct", "get_random", 1, first_bit, measure([&array]() {
+    const Array& a = array;
+    uint64_t sum = 0;
+    for (size_t i : order) {
+      sum += a[i];
+    }
+    return sum;
+  }));
+  add("boolarray", "hand", "get_sequential", 1, first_bit, measure([]() {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < fields; i++) {
+      size_t bit = first_bit + i;
+      sum += (buffer[bit >> 3] >> (bit & 7)) & 1;
+    }
+    return sum;
+  }));
+  add("boolarray", "hand", "set_sequential", 1, first_bit, measure([]() {
+    for (size_t i = 0; i < fields; i++) {
+      size_t bit = first_bit + i;
+      pbuf_type m = static_cast<pbuf_type>(1u << (bit & 7));
+      buffer[bit >> 3] = ((i & 3) == 0) ? (buffer[bit >> 3] | m) : (buffer[bit >> 3] & ~m);
+    }
+    return static_cast<uint64_t>(buffer[0]);
+  }));
+  add("boolarray", "hand", "get_random", 1, first_bit, measure([]() {
+    uint64_t sum = 0;
+    for (size_t i : order) {
+      size_t bit = first_bit + i;
+      sum += (buffer[bit >> 3] >> (bit & 7)) & 1;
+    }
+    return sum;
+  }));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Packer signed saturation
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <size_t Sz>
+struct SignedBitField {
+  int32_t value : Sz;
+};
+
+template <size_t Sz>
+void bench_packer() {
+  using Packer_ = vstruct::internals::Packer<int32_t, Sz>;
+  static std::vector<int32_t> values;
+  static SignedBitField<Sz> bitfields[fields];
+  const int32_t max_val = vstruct::internals::mask_max<int32_t>(Sz);
+  Rand rand;
+  values.resize(fields);
+  for (int32_t& v : values) {  // half of the values are out of range
+    int64_t range = (rand.next() & 1) ? max_val : std::numeric_limits<int32_t>::max();
+    v = static_cast<int32_t>(static_cast<int64_t>(rand.next() % (2 * range + 1)) - range);
+  }
+
+  add("packer", "vstruct", "pack", Sz, 0, measure([]() {
+    uint64_t sum = 0;
+    for (int32_t v : values) {
+      sum += Packer_::pack(v);
+    }
+    return sum;
+  }));
+  add("packer", "hand", "pack", Sz, 0, measure([max_val]() {
+    const uint32_t mask = vstruct::internals::low_mask<uint32_t>(Sz);
+    uint64_t sum = 0;
+    for (int32_t v : values) {
+      int32_t x = (v > max_val) ? max_val : (v < -max_val - 1) ? -max_val - 1 : v;
+      sum += static_cast<uint32_t>(x) & mask;
+    }
+    return sum;
+  }));
+  add("packer", "bitfield", "pack", Sz, 0, measure([]() {  // truncates, no saturation
+    for (size_t i = 0; i < fields; i++) {
+      bitfields[i].value = values[i];
+    }
+    return static_cast<uint64_t>(bitfields[fields - 1].value);
+  }));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Output
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void write_csv(FILE* f) {
+  fprintf(f, "group,impl,op,Sz,offset,ns_per_op\n");
+  for (const Result& r : results) {
+    fprintf(f, "%s,%s,%s,%zu,%zu,%.4f\n", r.group.c_str(), r.impl.c_str(), r.op.c_str(), r.Sz, r.offset, r.ns);
+  }
+}
+
+void write_json(FILE* f) {
+#if defined(__VERSION__)
+  const char* compiler = __VERSION__;
+#else
+  const char* compiler = "";
+#endif
+  fprintf(f, "{\n  \"compiler\": \"%s\",\n  \"slack_padded_buffer\": %d,\n  \"results\": [\n",
+          compiler, VSTRUCT_SLACK_PADDED_BUFFER);
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result& r = results[i];
+    fprintf(f, "    {\"group\": \"%s\", \"impl\": \"%s\", \"op\": \"%s\", \"Sz\": %zu, \"offset\": %zu, "
+            "\"ns_per_op\": %.4f}%s\n", r.group.c_str(), r.impl.c_str(), r.op.c_str(), r.Sz, r.offset, r.ns,
+            (i + 1 < results.size()) ? "," : "");
+  }
+  fprintf(f, "  ]\n}\n");
+}
+
+int usage(const char* name) {
+  fprintf(stderr, "usage: %s [--format csv|json] [--output file] [--min-ms ms]\n", name);
+  return 2;
+}
+
+}  // namespace
+}  // namespace vstruct_bench
+
+int main(int argc, char** argv) {
+  using namespace vstruct_bench;  // NOLINT(build/namespaces)
+  std::string format = "csv";
+  const char* output = nullptr;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      return usage(argv[0]);
+    } else if (arg == "--format") {
+      format = argv[++i];
+    } else if (arg == "--output") {
+      output = argv[++i];
+    } else if (arg == "--min-ms") {
+      min_ns = atof(argv[++i]) * 1e6;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+  if (format != "csv" && format != "json") {
+    return usage(argv[0]);
+  }
+
+  bench_leorder_sizes<1>();
+  bench_leorder_sizes<17>();
+  bench_leorder_sizes<33>();
+  bench_leorder_sizes<49>();
+  bench_learray<uint8_t, 5>();
+  bench_learray<uint16_t, 11>();
+  bench_learray<uint32_t, 27>();
+  bench_learray<uint64_t, 61>();
+  bench_boolarray();
+  bench_packer<5>();
+  bench_packer<12>();
+  bench_packer<20>();
+  bench_packer<31>();
+
+  FILE* f = output ? fopen(output, "w") : stdout;
+  if (!f) {
+    perror(output);
+    return 1;
+  }
+  if (format == "json") {
+    write_json(f);
+  } else {
+    write_csv(f);
+  }
+  if (output) {
+    fclose(f);
+  }
+  return 0;
+}
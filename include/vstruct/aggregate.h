@@ -0,0 +1,208 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// This file provides aggregation of a field across many records, or of the elements of an array.
+///
+/// sum, min, max and the number of non zero values are collected in one pass over the packed data,
+/// without decoding the column into a separate buffer. Integer sums are kept in 64 bit accumulators,
+/// so small fields cannot overflow. On cpus with AVX2, integer fields within 32 bits are gathered,
+/// unpacked and accumulated 8 records at a time.
+///
+/// Example Usage:
+///
+/// vstruct::FieldStats<uint32_t> stats = vstruct::aggregate(&Example1::x4, records, count);
+/// uint64_t total = stats.sum;
+/// double mean = stats.mean();
+///
+#ifndef VSTRUCT_AGGREGATE_H_
+#define VSTRUCT_AGGREGATE_H_
+
+#include <stdint.h>
+#include <limits>
+#include <type_traits>
+#include "./internals.h"
+#include "./cpu.h"
+#include "./itemtypes.h"
+#include "./records.h"
+#include "./columns.h"
+
+namespace vstruct {
+
+/// FieldStats - aggregates of the values of a field
+/// sum is int64_t for signed fields, uint64_t for unsigned and bool fields, double for floating point fields
+template <typename T>
+struct FieldStats {
+  typedef typename std::conditional<std::is_floating_point<T>::value, double,
+          typename std::conditional<std::is_signed<T>::value, int64_t, uint64_t>::type>::type sum_type;
+
+  size_t count = 0;
+  sum_type sum = 0;
+  T min = std::numeric_limits<T>::max();  // unchanged when count is 0
+  T max = std::numeric_limits<T>::lowest();
+  size_t nonzero = 0;
+
+  double mean() const {
+    return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+  }
+
+  void add(T x) {
+    count++;
+    sum += static_cast<sum_type>(x);
+    min = (x < min) ? x : min;
+    max = (x > max) ? x : max;
+    nonzero += (x != 0) ? 1 : 0;
+  }
+
+  // combine with the aggregates of other values
+  void merge(const FieldStats& other) {
+    count += other.count;
+    sum += other.sum;
+    min = (other.min < min) ? other.min : min;
+    max = (other.max > max) ? other.max : max;
+    nonzero += other.nonzero;
+  }
+};
+
+namespace internals {
+
+/// AggregateAvx2 - aggregate 8 records at a time, for fields that CanGather8
+/// Template args:
+///   F: storage type of the field
+///   stride: bytes between records
+template <typename F, size_t stride, bool enable = CanGather8<F, stride>::value>
+struct AggregateAvx2 {
+  enum : size_t { enabled = 0 };
+  template <typename T>
+  static size_t run(const pbuf_type*, size_t, FieldStats<T>*) {
+    return 0;
+  }
+};
+
+#if VSTRUCT_X86_SIMD
+template <typename F, size_t stride>
+struct AggregateAvx2<F, stride, true> {
+  typedef typename F::unpackedT T;
+  using Load = Gather8<F, stride>;
+  enum : size_t {
+    enabled = 1,
+    lanes = Load::lanes,
+    is_signed = std::is_signed<T>::value
+  };
+
+  // aggregate whole groups of 8 records into stats, returns the number of records aggregated
+  VSTRUCT_TARGET("avx2") static size_t run(const pbuf_type* records, size_t count, FieldStats<T>* stats) {
+    const __m256i zero = _mm256_setzero_si256();
+    size_t groups = count / lanes;
+    if (groups == 0) {
+      return 0;
+    }
+    __m256i sum = zero;  // 4 x 64 bit
+    __m256i vmin = is_signed ? _mm256_set1_epi32(std::numeric_limits<int32_t>::max()) : _mm256_set1_epi32(-1);
+    __m256i vmax = is_signed ? _mm256_set1_epi32(std::numeric_limits<int32_t>::min()) : zero;
+    size_t zeros = 0;
+    const pbuf_type* p = records + Load::offset_byte;
+    for (size_t g = 0; g < groups; g++) {
+      __m256i v = Load::load(p);
+      __m128i lo = _mm256_castsi256_si128(v);
+      __m128i hi = _mm256_extracti128_si256(v, 1);
+      if (is_signed) {
+        sum = _mm256_add_epi64(sum, _mm256_add_epi64(_mm256_cvtepi32_epi64(lo), _mm256_cvtepi32_epi64(hi)));
+        vmin = _mm256_min_epi32(vmin, v);
+        vmax = _mm256_max_epi32(vmax, v);
+      } else {
+        sum = _mm256_add_epi64(sum, _mm256_add_epi64(_mm256_cvtepu32_epi64(lo), _mm256_cvtepu32_epi64(hi)));
+        vmin = _mm256_min_epu32(vmin, v);
+        vmax = _mm256_max_epu32(vmax, v);
+      }
+      int is_zero = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, zero)));
+      zeros += static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(is_zero)));
+      p += lanes * stride;
+    }
+
+    uint64_t sums[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums), sum);
+    uint32_t mins[lanes];
+    uint32_t maxs[lanes];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(mins), vmin);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(maxs), vmax);
+    FieldStats<T> result;
+    result.count = groups * lanes;
+    result.sum = static_cast<typename FieldStats<T>::sum_type>(sums[0] + sums[1] + sums[2] + sums[3]);
+    result.nonzero = result.count - zeros;
+    typedef typename std::conditional<std::is_signed<T>::value, int32_t, uint32_t>::type lane_type;
+    for (size_t i = 0; i < lanes; i++) {
+      T x_min = static_cast<T>(static_cast<lane_type>(mins[i]));
+      T x_max = static_cast<T>(static_cast<lane_type>(maxs[i]));
+      result.min = (x_min < result.min) ? x_min : result.min;
+      result.max = (x_max > result.max) ? x_max : result.max;
+    }
+    stats->merge(result);
+    return groups * lanes;
+  }
+};
+#endif  // VSTRUCT_X86_SIMD
+
+/// AggregateField - aggregate field F of count records, stride bytes apart
+template <typename F, size_t stride>
+struct AggregateField {
+  static_assert(F::N == 1, "aggregate of an array field is not supported, aggregate each array instead");
+  static_assert(!IsBigEndian<F>::value, "aggregate of a big endian field is not supported");
+  static_assert(F::total_bytes <= stride, "field is outside the record");
+  typedef typename F::unpackedT T;
+  using Packer_ = ColumnPacker<T, F::Sz>;
+  using Order = LEOrderAt<typename Packer_::packedT, F::Sz, F::first_bit>;
+  using Simd = AggregateAvx2<F, stride>;
+
+  static FieldStats<T> run(const pbuf_type* records, size_t count) {
+    FieldStats<T> stats;
+    size_t i = 0;
+#if VSTRUCT_X86_SIMD
+    if (Simd::enabled && CpuFeatures::get().avx2) {
+      i = Simd::run(records, count, &stats);
+    }
+#endif
+    for (; i < count; i++) {
+      stats.add(Packer_::unpack(Order::get(records + i * stride)));
+    }
+    return stats;
+  }
+};
+
+}  // namespace internals
+
+/// aggregate - sum, min, max and non zero count of field across count records at records
+template <typename Layout, typename Field>
+FieldStats<typename Field::unpackedT> aggregate(Field Layout::*, const pbuf_type* records, size_t count) {
+  return internals::AggregateField<Field, Layout::record_bytes>::run(records, count);
+}
+
+/// aggregate - sum, min, max and non zero count of field across all records of a RecordArray
+template <typename Layout, typename Field, typename View>
+FieldStats<typename Field::unpackedT> aggregate(Field Layout::* field, const RecordArray<View>& records) {
+  static_assert(std::is_same<Layout, typename View::Layout>::value, "field is not a member of the record layout");
+  return aggregate(field, records.data(), records.size());
+}
+
+/// aggregate - sum, min, max and non zero count of the elements of an array
+/// Elements are unpacked a tile at a time with the bulk kernels of unpack_to
+template <typename T, size_t bits, size_t Sz, size_t N, typename Holder>
+FieldStats<T> aggregate(const LEArrayType<T, bits, Sz, N, Holder>& array) {
+  enum : size_t { tile = 64 };
+  FieldStats<T> stats;
+  T values[tile];
+  for (size_t first = 0; first < N; first += tile) {
+    size_t n = (N - first < tile) ? N - first : tile;
+    array.unpack_to(values, first, n);
+    for (size_t i = 0; i < n; i++) {
+      stats.add(values[i]);
+    }
+  }
+  return stats;
+}
+
+}  // namespace vstruct
+
+#endif  // VSTRUCT_AGGREGATE_H_
@@ -0,0 +1,305 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// This file provides bulk decoding of arrays.
+///
+/// An array of Sz bit elements repeats its bit pattern every 8 elements (Sz bytes),
+/// so a group of 8 elements starting at a multiple of 8 always has the same byte offsets
+/// and shifts per lane. The simd kernels decode whole groups with constant shuffles and shifts,
+/// the elements before the first and after the last whole group are decoded with LEOrder.
+///
+#ifndef VSTRUCT_BULK_H_
+#define VSTRUCT_BULK_H_
+
+#include <stdint.h>
+#include <type_traits>
+#include "./internals.h"
+#include "./cpu.h"
+
+namespace vstruct {
+namespace internals {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Kernel declarations
+/// Kernels decode groups of lanes elements, group g starts at element (first_lane + g * lanes),
+/// which is at byte (base_byte + g * group_bytes) and load_bytes are read from there.
+/// Template args:
+///   T: unpacked type
+///   Sz: Number of storage bits
+///   b: bit offset of element 0 in the first byte
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename T, size_t Sz, size_t b,
+          bool enable = std::is_integral<T>::value && (Sz <= 25)>
+struct UnpackAvx2;  // any Sz up to 25 bits, 8 lanes
+
+template <typename T, size_t Sz, size_t b,
+          bool enable = std::is_integral<T>::value && (Sz == 4) && (b % 4 == 0)>
+struct UnpackNibbleSse2;  // 4 bit elements, 32 lanes
+
+// disabled kernels
+template <typename T, size_t Sz, size_t b>
+struct UnpackAvx2<T, Sz, b, false> {
+  enum : size_t { enabled = 0, lanes = 1, first_lane = 0, base_byte = 0, group_bytes = 1, load_bytes = 1 };
+  static void groups(const pbuf_type*, size_t, size_t, T*) {}
+};
+
+template <typename T, size_t Sz, size_t b>
+struct UnpackNibbleSse2<T, Sz, b, false> {
+  enum : size_t { enabled = 0, lanes = 1, first_lane = 0, base_byte = 0, group_bytes = 1, load_bytes = 1 };
+  static void groups(const pbuf_type*, size_t, size_t, T*) {}
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Array unpacking
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// LEArrayUnpack - decode count elements starting at element first
+/// pData points to the first byte of the array, buf_bytes is the number of bytes from pData to the end of the array
+template <typename T, size_t Sz, size_t b>
+struct LEArrayUnpack {
+  using Packer_ = Packer<T, Sz>;
+  typedef typename Packer_::packedT packedT;
+  using LEOrder_ = LEOrder<packedT, Sz>;
+  using Avx2 = UnpackAvx2<T, Sz, b>;
+  using NibbleSse2 = UnpackNibbleSse2<T, Sz, b>;
+
+  static void run(const pbuf_type* pData, size_t buf_bytes, size_t first, size_t count, T* out) {
+#if VSTRUCT_X86_SIMD
+    const CpuFeatures& cpu = CpuFeatures::get();
+    if (NibbleSse2::enabled && cpu.sse2 && run_kernel<NibbleSse2>(pData, buf_bytes, first, count, out)) {
+      return;
+    }
+    if (Avx2::enabled && cpu.avx2 && run_kernel<Avx2>(pData, buf_bytes, first, count, out)) {
+      return;
+    }
+#endif
+    scalar(pData, buf_bytes, first, count, out);
+  }
+
+  static void scalar(const pbuf_type* pData, size_t buf_bytes, size_t first, size_t count, T* out) {
+    for (size_t i = 0; i < count; i++) {
+      out[i] = Packer_::unpack(LEOrder_::get(pData, b + (first + i) * Sz, buf_bytes));
+    }
+  }
+
+  // decode whole groups with Kernel and the rest with scalar, false if there is no whole group to decode
+  template <class Kernel>
+  static bool run_kernel(const pbuf_type* pData, size_t buf_bytes, size_t first, size_t count, T* out) {
+    if (first + count < Kernel::first_lane + Kernel::lanes || buf_bytes < Kernel::base_byte + Kernel::load_bytes) {
+      return false;
+    }
+    size_t g_begin = (first > Kernel::first_lane)
+                     ? (first - Kernel::first_lane + Kernel::lanes - 1) / Kernel::lanes : 0;
+    size_t g_end = (first + count - Kernel::first_lane) / Kernel::lanes;
+    size_t g_bound = (buf_bytes - Kernel::base_byte - Kernel::load_bytes) / Kernel::group_bytes + 1;
+    if (g_end > g_bound) {
+      g_end = g_bound;
+    }
+    if (g_end <= g_begin) {
+      return false;
+    }
+    size_t e_begin = Kernel::first_lane + g_begin * Kernel::lanes;
+    size_t e_end = Kernel::first_lane + g_end * Kernel::lanes;
+    scalar(pData, buf_bytes, first, e_begin - first, out);
+    Kernel::groups(pData, g_begin, g_end, out + (e_begin - first));
+    scalar(pData, buf_bytes, e_end, first + count - e_end, out + (e_end - first));
+    return true;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Array packing
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// LEArrayPack - encode count elements starting at element first, returns the number of saturated inputs
+/// Packed bits are streamed through a BitWriter, only the first and the last byte are merged
+/// with the existing buffer content.
+template <typename T, size_t Sz, size_t b>
+struct LEArrayPack {
+  using Packer_ = Packer<T, Sz>;
+
+  static size_t run(pbuf_type* pData, size_t first, size_t count, const T* in) {
+    size_t saturated = 0;
+    BitWriter writer(pData, b + first * Sz);
+    for (size_t i = 0; i < count; i++) {
+      saturated += Packer_::saturates(in[i]) ? 1 : 0;
+      writer.put(static_cast<uint64_t>(Packer_::pack(in[i])), Sz);
+    }
+    writer.flush();
+    return saturated;
+  }
+};
+
+#if VSTRUCT_X86_SIMD
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Lane stores, widen or narrow decoded lanes to T
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Sse2Store - store sign or zero extended lanes to T
+template <typename T>
+struct Sse2Store {
+  enum : bool { is_signed = std::is_signed<T>::value };
+
+  VSTRUCT_TARGET("sse2") static __m128i ext8(__m128i v) {
+    return is_signed ? _mm_cmpgt_epi8(_mm_setzero_si128(), v) : _mm_setzero_si128();
+  }
+  VSTRUCT_TARGET("sse2") static __m128i ext16(__m128i v) {
+    return is_signed ? _mm_srai_epi16(v, 15) : _mm_setzero_si128();
+  }
+  VSTRUCT_TARGET("sse2") static __m128i ext32(__m128i v) {
+    return is_signed ? _mm_srai_epi32(v, 31) : _mm_setzero_si128();
+  }
+  // 16 lanes of 8 bits
+  VSTRUCT_TARGET("sse2") static void store8(T* out, __m128i v) {
+    if (sizeof(T) == 1) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+    } else {
+      store16(out, _mm_unpacklo_epi8(v, ext8(v)));
+      store16(out + 8, _mm_unpackhi_epi8(v, ext8(v)));
+    }
+  }
+  // 8 lanes of 16 bits
+  VSTRUCT_TARGET("sse2") static void store16(T* out, __m128i v) {
+    if (sizeof(T) <= 2) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+    } else {
+      store32(out, _mm_unpacklo_epi16(v, ext16(v)));
+      store32(out + 4, _mm_unpackhi_epi16(v, ext16(v)));
+    }
+  }
+  // 4 lanes of 32 bits
+  VSTRUCT_TARGET("sse2") static void store32(T* out, __m128i v) {
+    if (sizeof(T) <= 4) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), v);
+    } else {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi32(v, ext32(v)));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2), _mm_unpackhi_epi32(v, ext32(v)));
+    }
+  }
+};
+
+/// Avx2Store - store 8 lanes of 32 bits to T
+template <typename T>
+struct Avx2Store {
+  enum : bool { is_signed = std::is_signed<T>::value };
+
+  VSTRUCT_TARGET("avx2") static void store32(T* out, __m256i v) {
+    if (sizeof(T) == 1) {
+      __m256i v16 = is_signed ? _mm256_packs_epi32(v, v) : _mm256_packus_epi32(v, v);
+      __m256i v8 = is_signed ? _mm256_packs_epi16(v16, v16) : _mm256_packus_epi16(v16, v16);
+      v8 = _mm256_permutevar8x32_epi32(v8, _mm256_setr_epi32(0, 4, 0, 4, 0, 4, 0, 4));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(v8));
+    } else if (sizeof(T) == 2) {
+      __m256i v16 = is_signed ? _mm256_packs_epi32(v, v) : _mm256_packus_epi32(v, v);
+      v16 = _mm256_permute4x64_epi64(v16, 0x08);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(v16));
+    } else if (sizeof(T) == 4) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), v);
+    } else {
+      __m128i lo = _mm256_castsi256_si128(v);
+      __m128i hi = _mm256_extracti128_si256(v, 1);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                          is_signed ? _mm256_cvtepi32_epi64(lo) : _mm256_cvtepu32_epi64(lo));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4),
+                          is_signed ? _mm256_cvtepi32_epi64(hi) : _mm256_cvtepu32_epi64(hi));
+    }
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Kernels
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// UnpackAvx2 - shuffle the 4 bytes holding each element into a 32 bit lane, then shift and mask.
+/// Lanes 0-3 are shuffled from the 16 bytes at the group start, lanes 4-7 from the 16 bytes at lane 4.
+template <typename T, size_t Sz, size_t b>
+struct UnpackAvx2<T, Sz, b, true> {
+  enum : size_t {
+    enabled = 1,
+    lanes = 8,
+    first_lane = 0,
+    base_byte = 0,
+    group_bytes = Sz,  // 8 elements of Sz bits
+    hi_byte = (b + 4 * Sz) >> 3,  // first byte of lane 4
+    load_bytes = hi_byte + 16
+  };
+  static constexpr int lane_byte(size_t lane) {
+    return static_cast<int>((b + lane * Sz) >> 3);
+  }
+  static constexpr int lane_shift(size_t lane) {
+    return static_cast<int>((b + lane * Sz) & 0x7);
+  }
+  static constexpr char shuffle(size_t i) {  // i-th byte of the shuffle control
+    return static_cast<char>(lane_byte(i >> 2) - ((i < 16) ? 0 : static_cast<int>(hi_byte)) + static_cast<int>(i & 3));
+  }
+
+  VSTRUCT_TARGET("avx2") static void groups(const pbuf_type* pData, size_t g_begin, size_t g_end, T* out) {
+    const __m256i control = _mm256_setr_epi8(
+        shuffle(0), shuffle(1), shuffle(2), shuffle(3), shuffle(4), shuffle(5), shuffle(6), shuffle(7),
+        shuffle(8), shuffle(9), shuffle(10), shuffle(11), shuffle(12), shuffle(13), shuffle(14), shuffle(15),
+        shuffle(16), shuffle(17), shuffle(18), shuffle(19), shuffle(20), shuffle(21), shuffle(22), shuffle(23),
+        shuffle(24), shuffle(25), shuffle(26), shuffle(27), shuffle(28), shuffle(29), shuffle(30), shuffle(31));
+    const __m256i shifts = _mm256_setr_epi32(
+        lane_shift(0), lane_shift(1), lane_shift(2), lane_shift(3),
+        lane_shift(4), lane_shift(5), lane_shift(6), lane_shift(7));
+    const __m256i mask = _mm256_set1_epi32(static_cast<int>(MaskMax<uint32_t, Sz>::value));
+    const pbuf_type* p = pData + g_begin * group_bytes;
+    for (size_t g = g_begin; g < g_end; g++) {
+      __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + hi_byte));
+      __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+      v = _mm256_srlv_epi32(_mm256_shuffle_epi8(v, control), shifts);
+      if (std::is_signed<T>::value) {  // sign extend, same as Packer::unpack
+        v = _mm256_srai_epi32(_mm256_slli_epi32(v, 32 - Sz), 32 - Sz);
+      } else {
+        v = _mm256_and_si256(v, mask);
+      }
+      Avx2Store<T>::store32(out, v);
+      out += lanes;
+      p += group_bytes;
+    }
+  }
+};
+
+/// UnpackNibbleSse2 - split 16 bytes into low and high nibbles and interleave them to 32 byte lanes
+template <typename T, size_t Sz, size_t b>
+struct UnpackNibbleSse2<T, Sz, b, true> {
+  enum : size_t {
+    enabled = 1,
+    lanes = 32,
+    first_lane = (b == 4) ? 1 : 0,  // first element starting on a byte boundary
+    base_byte = (b == 4) ? 1 : 0,
+    group_bytes = 16,
+    load_bytes = 16
+  };
+
+  VSTRUCT_TARGET("sse2") static void groups(const pbuf_type* pData, size_t g_begin, size_t g_end, T* out) {
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i sign = _mm_set1_epi8(0x08);
+    const pbuf_type* p = pData + base_byte + g_begin * group_bytes;
+    for (size_t g = g_begin; g < g_end; g++) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      __m128i lo = _mm_and_si128(v, nibble);
+      __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+      __m128i first = _mm_unpacklo_epi8(lo, hi);
+      __m128i second = _mm_unpackhi_epi8(lo, hi);
+      if (std::is_signed<T>::value) {  // sign extend, same as Packer::unpack
+        first = _mm_sub_epi8(_mm_xor_si128(first, sign), sign);
+        second = _mm_sub_epi8(_mm_xor_si128(second, sign), sign);
+      }
+      Sse2Store<T>::store8(out, first);
+      Sse2Store<T>::store8(out + 16, second);
+      out += lanes;
+      p += group_bytes;
+    }
+  }
+};
+#endif  // VSTRUCT_X86_SIMD
+
+}  // namespace internals
+}  // namespace vstruct
+
+#endif  // VSTRUCT_BULK_H_
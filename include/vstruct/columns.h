@@ -0,0 +1,215 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// This file provides columnar access to one field across many records.
+///
+/// A field of a generated struct sits at the same bit position in every record, so the column
+/// is read with the fixed offset accessor record by record, stride bytes apart, without attaching a view.
+/// On cpus with AVX2, fields within 32 bits are read 8 records at a time with a gather.
+///
+/// Example Usage:
+///
+/// std::vector<uint32_t> x4(count);
+/// vstruct::extract_column(&Example1::x4, records, count, x4.data());
+/// vstruct::scatter_column(&Example1::x4, records, count, x4.data());
+///
+#ifndef VSTRUCT_COLUMNS_H_
+#define VSTRUCT_COLUMNS_H_
+
+#include <stdint.h>
+#include <type_traits>
+#include "./internals.h"
+#include "./cpu.h"
+#include "./bulk.h"
+#include "./records.h"
+
+namespace vstruct {
+namespace internals {
+
+/// ColumnPacker - Packer of a column, bool fields are stored as 1 bit unsigned values
+template <typename T, size_t Sz>
+struct ColumnPacker : public Packer<T, Sz> {};
+
+template <size_t Sz>
+struct ColumnPacker<bool, Sz> {
+  typedef uint8_t packedT;
+  static packedT pack(bool x) {
+    return x ? 1 : 0;
+  }
+  static bool saturates(bool) {
+    return false;
+  }
+  static bool unpack(packedT x) {
+    return x != 0;
+  }
+};
+
+/// PrefetchRecords - how many records ahead the column kernels prefetch, records of 64 bytes and larger
+/// are beyond the hardware prefetcher
+template <size_t stride>
+struct PrefetchRecords {
+  enum : size_t {
+    value = (stride >= 64) ? 16 : 0
+  };
+};
+
+/// CanGather8 - field F of 8 records, stride bytes apart, can be read with one 32 bit gather: an integer
+/// field within a 32 bit load from its first byte, bool fields excluded
+template <typename F, size_t stride>
+struct CanGather8
+    : public std::integral_constant<bool, std::is_integral<typename F::unpackedT>::value &&
+                                          !std::is_same<typename F::unpackedT, bool>::value &&
+                                          ((F::first_bit & 0x7) + F::Sz <= 32) &&
+                                          ((F::first_bit >> 3) + 4 <= stride) &&  // load stays within the record
+                                          (stride <= (1u << 27))> {};  // 32 bit gather index
+
+#if VSTRUCT_X86_SIMD
+/// Gather8 - read field F of 8 records, stride bytes apart, into 32 bit lanes
+/// Signed fields are sign extended, unsigned fields zero extended. Only for fields where CanGather8 holds.
+template <typename F, size_t stride>
+struct Gather8 {
+  typedef typename F::unpackedT T;
+  enum : size_t {
+    lanes = 8,
+    offset_byte = F::first_bit >> 3,
+    offset_bit = F::first_bit & 0x7,
+    Sz = F::Sz
+  };
+
+  // p points to the first field byte of record 0
+  VSTRUCT_TARGET("avx2") static __m256i load(const pbuf_type* p) {
+    const __m256i index = _mm256_setr_epi32(
+        0, static_cast<int>(stride), static_cast<int>(2 * stride), static_cast<int>(3 * stride),
+        static_cast<int>(4 * stride), static_cast<int>(5 * stride), static_cast<int>(6 * stride),
+        static_cast<int>(7 * stride));
+    __m256i v = _mm256_i32gather_epi32(reinterpret_cast<const int*>(p), index, 1);
+    if (Sz < 32) {  // resolved at compile time
+      v = _mm256_slli_epi32(v, static_cast<int>(32 - Sz - offset_bit));
+      v = std::is_signed<T>::value ? _mm256_srai_epi32(v, static_cast<int>(32 - Sz))
+                                   : _mm256_srli_epi32(v, static_cast<int>(32 - Sz));
+    }
+    return v;
+  }
+};
+#endif  // VSTRUCT_X86_SIMD
+
+/// GatherAvx2 - gather 8 records at a time into a column
+/// Template args:
+///   F: storage type of the field
+///   stride: bytes between records
+template <typename F, size_t stride, bool enable = CanGather8<F, stride>::value>
+struct GatherAvx2 {
+  enum : size_t { enabled = 0 };
+  template <typename T>
+  static size_t run(const pbuf_type*, size_t, T*) {
+    return 0;
+  }
+};
+
+#if VSTRUCT_X86_SIMD
+template <typename F, size_t stride>
+struct GatherAvx2<F, stride, true> {
+  typedef typename F::unpackedT T;
+  using Load = Gather8<F, stride>;
+  enum : size_t {
+    enabled = 1,
+    lanes = Load::lanes,
+    prefetch_groups = PrefetchRecords<stride>::value / lanes
+  };
+
+  // decode whole groups of 8 records, returns the number of records decoded
+  VSTRUCT_TARGET("avx2") static size_t run(const pbuf_type* records, size_t count, T* out) {
+    size_t groups = count / lanes;
+    const pbuf_type* p = records + Load::offset_byte;
+    for (size_t g = 0; g < groups; g++) {
+      if (prefetch_groups != 0 && (g + prefetch_groups < groups)) {
+        for (size_t i = 0; i < lanes; i++) {
+          __builtin_prefetch(p + (prefetch_groups * lanes + i) * stride);
+        }
+      }
+      Avx2Store<T>::store32(out, Load::load(p));
+      out += lanes;
+      p += lanes * stride;
+    }
+    return groups * lanes;
+  }
+};
+#endif  // VSTRUCT_X86_SIMD
+
+/// ColumnAccess - decode/encode field F of count records, stride bytes apart
+template <typename F, size_t stride>
+struct ColumnAccess {
+  static_assert(F::N == 1, "column of an array field is not supported");
+  static_assert(!IsBigEndian<F>::value, "column of a big endian field is not supported");
+  static_assert(F::total_bytes <= stride, "field is outside the record");
+  typedef typename F::unpackedT T;
+  using Packer_ = ColumnPacker<T, F::Sz>;
+  using Order = LEOrderAt<typename Packer_::packedT, F::Sz, F::first_bit>;
+  using Gather = GatherAvx2<F, stride>;
+  enum : size_t {
+    prefetch_records = PrefetchRecords<stride>::value
+  };
+
+  static void extract(const pbuf_type* records, size_t count, T* out) {
+    size_t i = 0;
+#if VSTRUCT_X86_SIMD
+    if (Gather::enabled && CpuFeatures::get().avx2) {
+      i = Gather::run(records, count, out);
+    }
+#endif
+    for (; i < count; i++) {
+      if (prefetch_records != 0 && (i + prefetch_records < count)) {
+        __builtin_prefetch(records + (i + prefetch_records) * stride + Order::offset_byte);
+      }
+      out[i] = Packer_::unpack(Order::get(records + i * stride));
+    }
+  }
+
+  // returns the number of values clipped by saturation
+  static size_t scatter(pbuf_type* records, size_t count, const T* in) {
+    size_t saturated = 0;
+    for (size_t i = 0; i < count; i++) {
+      if (prefetch_records != 0 && (i + prefetch_records < count)) {
+        __builtin_prefetch(records + (i + prefetch_records) * stride + Order::offset_byte, 1);
+      }
+      saturated += Packer_::saturates(in[i]) ? 1 : 0;
+      Order::set(records + i * stride, Packer_::pack(in[i]));
+    }
+    return saturated;
+  }
+};
+
+}  // namespace internals
+
+/// extract_column - decode field of count records at records, stride is the layout record_bytes
+template <typename Layout, typename Field>
+void extract_column(Field Layout::*, const pbuf_type* records, size_t count, typename Field::unpackedT* out) {
+  internals::ColumnAccess<Field, Layout::record_bytes>::extract(records, count, out);
+}
+
+/// scatter_column - encode field of count records at records, returns the number of values clipped by saturation
+template <typename Layout, typename Field>
+size_t scatter_column(Field Layout::*, pbuf_type* records, size_t count, const typename Field::unpackedT* in) {
+  return internals::ColumnAccess<Field, Layout::record_bytes>::scatter(records, count, in);
+}
+
+/// extract_column - decode field of all records of a RecordArray
+template <typename Layout, typename Field, typename View>
+void extract_column(Field Layout::* field, const RecordArray<View>& records, typename Field::unpackedT* out) {
+  static_assert(std::is_same<Layout, typename View::Layout>::value, "field is not a member of the record layout");
+  extract_column(field, records.data(), records.size(), out);
+}
+
+/// scatter_column - encode field of all records of a RecordArray
+template <typename Layout, typename Field, typename View>
+size_t scatter_column(Field Layout::* field, RecordArray<View>& records, const typename Field::unpackedT* in) {
+  static_assert(std::is_same<Layout, typename View::Layout>::value, "field is not a member of the record layout");
+  return scatter_column(field, records.data(), records.size(), in);
+}
+
+}  // namespace vstruct
+
+#endif  // VSTRUCT_COLUMNS_H_
@@ -0,0 +1,291 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// This file provides a columnar store for the records of a generated struct.
+///
+/// Every field of the layout (Layout::field_types) gets its own bit packed column, record r of a field
+/// with bit_size bits is at bit r * bit_size of the column. A scan over a few fields then only reads those columns.
+///
+/// Conversion between row records and columns works on blocks of block_records records: a block of rows stays
+/// in cache while it is copied to each column in turn. Blocks start at a multiple of 8 records, so every block
+/// starts on a byte boundary in every column and blocks can be converted by different threads.
+///
+/// Example Usage:
+///
+/// vstruct::ColumnStore<Example1> store;
+/// store.from_records(records, count, 4);  // 4 threads
+/// auto x4 = store.column(&Example1::x4);
+/// for (size_t r = 0; r < store.size(); r++) {
+///   total += x4.get(r);
+/// }
+///
+#ifndef VSTRUCT_COLUMNSTORE_H_
+#define VSTRUCT_COLUMNSTORE_H_
+
+#include <assert.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#include "./internals.h"
+#include "./itemtypes.h"
+#include "./columns.h"
+
+namespace vstruct {
+namespace internals {
+
+/// RecordBits - copy bits first_bit to first_bit + bits of a record to/from a bit stream, 64 bits at a time
+template <size_t first_bit, size_t bits, bool split = (bits > 64)>
+struct RecordBits {
+  static void read(const pbuf_type* pRecord, BitWriter& writer) {
+    writer.put(LEOrderAt<uint64_t, bits, first_bit>::get(pRecord), bits);
+  }
+  static void write(pbuf_type* pRecord, BitReader& reader) {
+    LEOrderAt<uint64_t, bits, first_bit>::set(pRecord, reader.get(bits));
+  }
+};
+
+template <size_t first_bit, size_t bits>
+struct RecordBits<first_bit, bits, true> {
+  static void read(const pbuf_type* pRecord, BitWriter& writer) {
+    RecordBits<first_bit, 64>::read(pRecord, writer);
+    RecordBits<first_bit + 64, bits - 64>::read(pRecord, writer);
+  }
+  static void write(pbuf_type* pRecord, BitReader& reader) {
+    RecordBits<first_bit, 64>::write(pRecord, reader);
+    RecordBits<first_bit + 64, bits - 64>::write(pRecord, reader);
+  }
+};
+
+/// ColumnTranspose - convert records [r0, r1) of fields I, I+1, ... between rows and columns
+template <size_t stride, size_t I, typename... Fields>
+struct ColumnTranspose;
+
+template <size_t stride, size_t I, typename F, typename... Rest>
+struct ColumnTranspose<stride, I, F, Rest...> {
+  static_assert(!IsBigEndian<F>::value, "column store of a big endian field is not supported");
+  using Bits = RecordBits<F::first_bit, F::bit_size>;
+  using Next = ColumnTranspose<stride, I + 1, Rest...>;
+
+  static void to_columns(const pbuf_type* records, size_t r0, size_t r1, pbuf_type* const* columns) {
+    BitWriter writer(columns[I], r0 * F::bit_size);
+    const pbuf_type* pRecord = records + r0 * stride;
+    for (size_t r = r0; r < r1; r++) {
+      Bits::read(pRecord, writer);
+      pRecord += stride;
+    }
+    writer.flush();
+    Next::to_columns(records, r0, r1, columns);
+  }
+
+  static void to_records(pbuf_type* records, size_t r0, size_t r1, const pbuf_type* const* columns) {
+    BitReader reader(columns[I], r0 * F::bit_size);
+    pbuf_type* pRecord = records + r0 * stride;
+    for (size_t r = r0; r < r1; r++) {
+      Bits::write(pRecord, reader);
+      pRecord += stride;
+    }
+    Next::to_records(records, r0, r1, columns);
+  }
+
+  // bits per record of each column
+  static void bit_sizes(size_t* out) {
+    out[I] = F::bit_size;
+    Next::bit_sizes(out);
+  }
+};
+
+template <size_t stride, size_t I>
+struct ColumnTranspose<stride, I> {  // end of the field list
+  static void to_columns(const pbuf_type*, size_t, size_t, pbuf_type* const*) {}
+  static void to_records(pbuf_type*, size_t, size_t, const pbuf_type* const*) {}
+  static void bit_sizes(size_t*) {}
+};
+
+/// FieldIndex - position of Field in Fields
+template <typename Field, typename... Fields>
+struct FieldIndex;
+
+template <typename Field, typename... Rest>
+struct FieldIndex<Field, Field, Rest...> {
+  enum : size_t { value = 0 };
+};
+
+template <typename Field, typename F, typename... Rest>
+struct FieldIndex<Field, F, Rest...> {
+  enum : size_t { value = 1 + FieldIndex<Field, Rest...>::value };
+};
+
+template <typename Layout, typename List>
+struct ColumnLayout;
+
+template <typename Layout, typename... Fields>
+struct ColumnLayout<Layout, FieldList<Fields...>> {
+  using Transpose = ColumnTranspose<Layout::record_bytes, 0, Fields...>;
+  template <typename Field>
+  using Index = FieldIndex<Field, Fields...>;
+};
+
+}  // namespace internals
+
+/// Column - bit packed values of one field, record r at bit r * bit_size
+template <typename Field>
+struct Column {
+  static_assert(!IsBigEndian<Field>::value, "column of a big endian field is not supported");
+  typedef typename Field::unpackedT T;
+  using Packer_ = internals::ColumnPacker<T, Field::Sz>;
+  using Order = internals::LEOrder<typename Packer_::packedT, Field::Sz>;
+  enum : size_t {
+    Sz = Field::Sz,
+    N = Field::N,  // elements per record for array fields
+    bit_size = Field::bit_size  // bits per record
+  };
+
+  pbuf_type* data_;
+  size_t size_;  // records
+  size_t buf_bytes_;
+
+  size_t size() const {
+    return size_;
+  }
+  pbuf_type* data() const {
+    return data_;
+  }
+
+  // element index of record
+  T get(size_t record, size_t index = 0) const {
+    assert(record < size_ && index < N && "Index is out of bounds!");
+    return Packer_::unpack(Order::get(data_, record * bit_size + index * Sz, buf_bytes_));
+  }
+
+  void set(size_t record, T value, size_t index = 0) {
+    assert(record < size_ && index < N && "Index is out of bounds!");
+    Order::set(data_, record * bit_size + index * Sz, Packer_::pack(value), buf_bytes_);
+  }
+};
+
+/// ColumnStore - columnar copy of records of a generated layout
+/// Template args:
+///   Layout: generated struct, provides field_types and record_bytes
+template <typename Layout>
+class ColumnStore {
+ public:
+  using ColumnLayout_ = internals::ColumnLayout<Layout, typename Layout::field_types>;
+  using Transpose = typename ColumnLayout_::Transpose;
+  enum : size_t {
+    columns = Layout::field_types::size,
+    stride = Layout::record_bytes,
+    block_records = 1024  // multiple of 8, keeps every block byte aligned in every column
+  };
+
+  ColumnStore(): size_(0), data_(columns, nullptr) {
+    Transpose::bit_sizes(bit_sizes_);
+  }
+
+  explicit ColumnStore(size_t count): ColumnStore() {
+    resize(count);
+  }
+
+  ColumnStore(const ColumnStore& other): size_(other.size_), storage_(other.storage_), data_(columns, nullptr) {
+    Transpose::bit_sizes(bit_sizes_);
+    update_pointers();
+  }
+
+  ColumnStore& operator=(const ColumnStore& other) {
+    size_ = other.size_;
+    storage_ = other.storage_;
+    update_pointers();
+    return *this;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  // bytes of column i, excluding the slack
+  size_t column_bytes(size_t i) const {
+    return (size_ * bit_sizes_[i] + 7) >> 3;
+  }
+
+  pbuf_type* column_data(size_t i) const {
+    return data_[i];
+  }
+
+  // column of field, for example store.column(&Example1::x4)
+  template <typename Field>
+  Column<Field> column(Field Layout::*) const {
+    const size_t i = ColumnLayout_::template Index<Field>::value;
+    return Column<Field>{data_[i], size_, column_bytes(i) + slack_bytes};
+  }
+
+  // every column is followed by vstruct::slack_bytes spare bytes, new records are zero
+  void resize(size_t count) {
+    size_ = count;
+    storage_.resize(columns);
+    for (size_t i = 0; i < columns; i++) {
+      storage_[i].resize(column_bytes(i) + slack_bytes);
+    }
+    update_pointers();
+  }
+
+  // convert count row records, stride bytes apart, to columns
+  void from_records(const pbuf_type* records, size_t count, unsigned threads = 1) {
+    resize(count);
+    pbuf_type* const* columns_data = data_.data();
+    run_blocks(threads, [=](size_t r0, size_t r1) {
+      Transpose::to_columns(records, r0, r1, columns_data);
+    });
+  }
+
+  // convert columns back to row records, only the field bits of the records are written
+  void to_records(pbuf_type* records, unsigned threads = 1) const {
+    const pbuf_type* const* columns_data = data_.data();
+    run_blocks(threads, [=](size_t r0, size_t r1) {
+      Transpose::to_records(records, r0, r1, columns_data);
+    });
+  }
+
+ private:
+  void update_pointers() {
+    for (size_t i = 0; i < columns && i < storage_.size(); i++) {
+      data_[i] = storage_[i].data();
+    }
+  }
+
+  // run fn on blocks of records, contiguous ranges of blocks are handed to each thread
+  template <typename Fn>
+  void run_blocks(unsigned threads, Fn fn) const {
+    size_t blocks = (size_ + block_records - 1) / block_records;
+    size_t workers = (threads < blocks) ? threads : blocks;
+    size_t count = size_;
+    auto worker = [=](size_t b0, size_t b1) {
+      for (size_t b = b0; b < b1; b++) {
+        size_t r0 = b * block_records;
+        size_t r1 = (r0 + block_records < count) ? r0 + block_records : count;
+        fn(r0, r1);
+      }
+    };
+    if (workers <= 1) {
+      worker(0, blocks);
+      return;
+    }
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < workers; t++) {
+      pool.emplace_back(worker, t * blocks / workers, (t + 1) * blocks / workers);
+    }
+    for (std::thread& thread : pool) {
+      thread.join();
+    }
+  }
+
+  size_t size_;
+  size_t bit_sizes_[columns];
+  std::vector<std::vector<pbuf_type>> storage_;
+  std::vector<pbuf_type*> data_;
+};
+
+}  // namespace vstruct
+
+#endif  // VSTRUCT_COLUMNSTORE_H_
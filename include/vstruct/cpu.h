@@ -0,0 +1,63 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// This file provides run time detection of cpu instruction set extensions.
+/// Kernels using an extension are compiled with a function target attribute and
+/// only called after the running cpu reports support for it.
+///
+/// Define VSTRUCT_NO_SIMD to disable all intrinsic kernels.
+///
+#ifndef VSTRUCT_CPU_H_
+#define VSTRUCT_CPU_H_
+
+#if !defined(VSTRUCT_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VSTRUCT_X86_SIMD 1
+#include <immintrin.h>
+#define VSTRUCT_TARGET(isa) __attribute__((target(isa)))
+#else
+#define VSTRUCT_X86_SIMD 0
+#define VSTRUCT_TARGET(isa)
+#endif
+
+// pext/pdep on 64 bit words are only available in 64 bit mode
+#if VSTRUCT_X86_SIMD && defined(__x86_64__)
+#define VSTRUCT_X86_BMI2 1
+#else
+#define VSTRUCT_X86_BMI2 0
+#endif
+
+namespace vstruct {
+namespace internals {
+
+/// CpuFeatures - extensions supported by the running cpu, detected once on first use
+struct CpuFeatures {
+  bool sse2;
+  bool ssse3;
+  bool avx2;
+  bool bmi2;
+
+  static const CpuFeatures& get() {
+    static const CpuFeatures features = detect();
+    return features;
+  }
+
+  static CpuFeatures detect() {
+    CpuFeatures features = {false, false, false, false};
+#if VSTRUCT_X86_SIMD
+    __builtin_cpu_init();
+    features.sse2 = __builtin_cpu_supports("sse2");
+    features.ssse3 = __builtin_cpu_supports("ssse3");
+    features.avx2 = __builtin_cpu_supports("avx2");
+    features.bmi2 = __builtin_cpu_supports("bmi2");
+#endif
+    return features;
+  }
+};
+
+}  // namespace internals
+}  // namespace vstruct
+
+#endif  // VSTRUCT_CPU_H_
@@ -0,0 +1,165 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// This file provides a bit contiguous stream of records.
+///
+/// A RecordArray pads every record to record_bytes, a 37 bit record then takes 40 bits. DenseRecords
+/// stores record i at bit i * record_bits instead, with no padding between records.
+/// A field of record i is at bit i * record_bits + first_bit, it is read in place with LEOrder at that
+/// base offset. Whole records are decoded to, or encoded from, byte aligned records so the generated
+/// views can be used on them; a batch of records is copied as one bit stream, 64 bits at a time.
+///
+/// Example Usage:
+///
+/// vstruct::DenseRecords<Example1> dense;
+/// dense.encode(records);  // RecordArray<Example1View>
+/// uint32_t x4 = dense.get(&Example1::x4, 10);
+/// vstruct::RecordArray<Example1View> batch = dense.decode(1000, 256);
+///
+#ifndef VSTRUCT_DENSE_H_
+#define VSTRUCT_DENSE_H_
+
+#include <assert.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "./internals.h"
+#include "./itemtypes.h"
+#include "./records.h"
+#include "./columnstore.h"
+
+namespace vstruct {
+
+/// DenseRecords - records of a generated layout packed back to back at record_bits intervals
+/// The buffer always has vstruct::slack_bytes spare bytes after the last record.
+/// Template args:
+///   Layout: generated struct, provides View, record_bits and record_bytes
+template <typename Layout>
+class DenseRecords {
+ public:
+  typedef typename Layout::View View;
+  using Bits = internals::RecordBits<0, Layout::record_bits>;
+  enum : size_t {
+    record_bits = Layout::record_bits,
+    stride = Layout::record_bytes  // stride of the decoded records
+  };
+
+  DenseRecords(): size_(0), storage_(slack_bytes, 0) {}
+
+  explicit DenseRecords(size_t count): DenseRecords() {
+    resize(count);
+  }
+
+  size_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+  pbuf_type* data() {
+    return storage_.data();
+  }
+  const pbuf_type* data() const {
+    return storage_.data();
+  }
+  // bytes of the stream, excluding the slack
+  size_t size_bytes() const {
+    return (size_ * record_bits + 7) >> 3;
+  }
+  size_t bit_offset(size_t index) const {
+    return index * record_bits;
+  }
+
+  // new records are zero
+  void resize(size_t count) {
+    size_ = count;
+    storage_.resize(size_bytes() + slack_bytes);
+    // bits after the last record stay zero, including those left by removed records
+    size_t end_bit = size_ * record_bits;
+    if (end_bit & 0x7) {
+      storage_[end_bit >> 3] &= static_cast<pbuf_type>((1u << (end_bit & 0x7)) - 1);
+    }
+    std::fill(storage_.begin() + size_bytes(), storage_.end(), 0);
+  }
+
+  void clear() {
+    resize(0);
+  }
+
+  // element index of field in record, for example dense.get(&Example1::x4, 10)
+  template <typename Field>
+  typename Field::unpackedT get(Field Layout::*, size_t record, size_t index = 0) const {
+    using Packer_ = internals::ColumnPacker<typename Field::unpackedT, Field::Sz>;
+    using Order = internals::LEOrder<typename Packer_::packedT, Field::Sz>;
+    static_assert(!IsBigEndian<Field>::value, "big endian fields are not supported in dense records");
+    assert(record < size_ && index < Field::N && "Index is out of bounds!");
+    return Packer_::unpack(Order::get_word(data(), field_bit<Field>(record, index)));
+  }
+
+  template <typename Field>
+  void set(Field Layout::*, size_t record, typename Field::unpackedT value, size_t index = 0) {
+    using Packer_ = internals::ColumnPacker<typename Field::unpackedT, Field::Sz>;
+    using Order = internals::LEOrder<typename Packer_::packedT, Field::Sz>;
+    static_assert(!IsBigEndian<Field>::value, "big endian fields are not supported in dense records");
+    assert(record < size_ && index < Field::N && "Index is out of bounds!");
+    Order::set_word(data(), field_bit<Field>(record, index), Packer_::pack(value));
+  }
+
+  // copy count records from first to byte aligned records, stride bytes apart
+  void decode(size_t first, size_t count, pbuf_type* records) const {
+    assert(first + count <= size_ && "Index is out of bounds!");
+    internals::BitReader reader(data(), bit_offset(first));
+    for (size_t i = 0; i < count; i++) {
+      Bits::write(records + i * stride, reader);
+    }
+  }
+
+  RecordArray<View> decode(size_t first, size_t count) const {
+    RecordArray<View> records(count);
+    decode(first, count, records.data());
+    return records;
+  }
+
+  // copy count byte aligned records, stride bytes apart, to the records from first
+  void encode(size_t first, size_t count, const pbuf_type* records) {
+    assert(first + count <= size_ && "Index is out of bounds!");
+    internals::BitWriter writer(data(), bit_offset(first));
+    for (size_t i = 0; i < count; i++) {
+      Bits::read(records + i * stride, writer);
+    }
+    writer.flush();
+  }
+
+  // replace the contents with records
+  void encode(const RecordArray<View>& records) {
+    resize(records.size());
+    encode(0, records.size(), records.data());
+  }
+
+  // append count byte aligned records
+  void append(const pbuf_type* records, size_t count) {
+    size_t first = size_;
+    resize(size_ + count);
+    encode(first, count, records);
+  }
+
+  void push_back(const pbuf_type* pRecord) {
+    append(pRecord, 1);
+  }
+
+ private:
+  template <typename Field>
+  static size_t field_bit(size_t record, size_t index) {
+    return record * record_bits + Field::first_bit + index * Field::Sz;
+  }
+
+  size_t size_;
+  std::vector<pbuf_type> storage_;
+};
+
+}  // namespace vstruct
+
+#endif  // VSTRUCT_DENSE_H_
@@ -0,0 +1,192 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// This file provides a constexpr table of field descriptors for a layout.
+///
+/// FieldTable<Layout> holds one FieldDescriptor per field of Layout::field_types, in declaration order:
+/// name, kind, unpacked C++ type, first bit, element size, element count and signedness.
+/// The table is a constant expression, so generic code can check the layout at compile time,
+/// or loop over the fields at runtime without a hand written table per struct.
+///
+/// Generated structs provide field_types and field_name(i). A hand written VStruct gets a table by
+/// declaring the same two members, field_name is optional and the names are empty without it:
+///
+/// struct Foo : public vstruct::VStruct {
+///   typename vstruct::LEItem<vstruct::Root, uint16_t, 12>::type a{*this};
+///   typename vstruct::BoolItem<decltype(a)>::type b{*this};
+///   using field_types = vstruct::FieldList<decltype(a), decltype(b)>;
+///   static constexpr const char* field_name(size_t i) { return i == 0 ? "a" : "b"; }
+/// };
+///
+/// Example Usage:
+///
+/// static_assert(vstruct::FieldTable<Example1>::fields[7].first_bit == 48, "x4 moved");
+/// for (const vstruct::FieldDescriptor& d : vstruct::FieldTable<Example1>()) {
+///   printf("%s %s:%zu\n", d.name, d.type, d.Sz);
+/// }
+///
+#ifndef VSTRUCT_DESCRIBE_H_
+#define VSTRUCT_DESCRIBE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include "./internals.h"
+#include "./itemtypes.h"
+
+namespace vstruct {
+
+enum class FieldKind : uint8_t {
+  le_item,
+  le_array,
+  bool_item,
+  bool_array,
+  be_item,
+  be_array
+};
+
+/// FieldDescriptor - layout of one field
+struct FieldDescriptor {
+  const char* name;  // member name, empty if the layout has no field_name
+  FieldKind kind;
+  const char* type;  // unpacked C++ type, for example "int16_t"
+  size_t first_bit;
+  size_t Sz;  // bits per element
+  size_t N;  // elements, 1 for items
+  bool is_signed;
+
+  constexpr size_t bit_size() const {
+    return Sz * N;
+  }
+  constexpr size_t next_bit() const {
+    return first_bit + Sz * N;
+  }
+};
+
+namespace internals {
+
+/// FieldKindOf - kind of the storage type of a field
+template <typename Field>
+struct FieldKindOf;
+
+template<typename T, size_t bits, size_t Sz, typename H>
+struct FieldKindOf<LEItemType<T, bits, Sz, H>> {
+  static constexpr FieldKind value() { return FieldKind::le_item; }
+};
+
+template<typename T, size_t bits, size_t Sz, size_t N, typename H>
+struct FieldKindOf<LEArrayType<T, bits, Sz, N, H>> {
+  static constexpr FieldKind value() { return FieldKind::le_array; }
+};
+
+template<size_t bits, typename H>
+struct FieldKindOf<BoolItemType<bits, H>> {
+  static constexpr FieldKind value() { return FieldKind::bool_item; }
+};
+
+template<size_t bits, size_t N, typename H>
+struct FieldKindOf<BoolArrayType<bits, N, H>> {
+  static constexpr FieldKind value() { return FieldKind::bool_array; }
+};
+
+template<typename T, size_t bits, size_t Sz, typename H>
+struct FieldKindOf<BEItemType<T, bits, Sz, H>> {
+  static constexpr FieldKind value() { return FieldKind::be_item; }
+};
+
+template<typename T, size_t bits, size_t Sz, size_t N, typename H>
+struct FieldKindOf<BEArrayType<T, bits, Sz, N, H>> {
+  static constexpr FieldKind value() { return FieldKind::be_array; }
+};
+
+/// TypeName - spelling of an unpacked type
+template <typename T>
+struct TypeName;
+
+template <> struct TypeName<bool> { static constexpr const char* get() { return "bool"; } };
+template <> struct TypeName<uint8_t> { static constexpr const char* get() { return "uint8_t"; } };
+template <> struct TypeName<int8_t> { static constexpr const char* get() { return "int8_t"; } };
+template <> struct TypeName<uint16_t> { static constexpr const char* get() { return "uint16_t"; } };
+template <> struct TypeName<int16_t> { static constexpr const char* get() { return "int16_t"; } };
+template <> struct TypeName<uint32_t> { static constexpr const char* get() { return "uint32_t"; } };
+template <> struct TypeName<int32_t> { static constexpr const char* get() { return "int32_t"; } };
+template <> struct TypeName<uint64_t> { static constexpr const char* get() { return "uint64_t"; } };
+template <> struct TypeName<int64_t> { static constexpr const char* get() { return "int64_t"; } };
+template <> struct TypeName<float> { static constexpr const char* get() { return "float"; } };
+template <> struct TypeName<double> { static constexpr const char* get() { return "double"; } };
+
+/// FieldName - Layout::field_name(i) if the layout has it, otherwise ""
+template <typename Layout>
+struct FieldName {
+  template <typename U>
+  static constexpr const char* get(size_t i, decltype(U::field_name(0))*) {
+    return U::field_name(i);
+  }
+  template <typename U>
+  static constexpr const char* get(size_t, ...) {
+    return "";
+  }
+  static constexpr const char* get(size_t i) {
+    return get<Layout>(i, nullptr);
+  }
+};
+
+}  // namespace internals
+
+/// describe_field - descriptor of the storage type Field, for example describe_field<decltype(s.x4)>("x4")
+template <typename Field>
+constexpr FieldDescriptor describe_field(const char* name) {
+  return FieldDescriptor{
+    name,
+    internals::FieldKindOf<Field>::value(),
+    internals::TypeName<typename Field::unpackedT>::get(),
+    Field::first_bit,
+    Field::Sz,
+    Field::N,
+    std::is_signed<typename Field::unpackedT>::value};
+}
+
+/// FieldTable - descriptors of the fields of a layout, in the order of Layout::field_types
+/// Template args:
+///   Layout: struct providing field_types, and optionally field_name(i)
+///   Fields: FieldList of the fields, for example vstruct::LayoutFieldList<L> for a flat Layout
+template <typename Layout,
+          typename Fields = typename Layout::field_types,
+          typename Indices = typename internals::MakeIndexList<Fields::size>::type>
+struct FieldTable;
+
+template <typename Layout, typename... Fields, size_t... I>
+struct FieldTable<Layout, FieldList<Fields...>, internals::IndexList<I...>> {
+  enum : size_t {
+    size = sizeof...(Fields)
+  };
+  static constexpr FieldDescriptor fields[sizeof...(Fields)] = {
+    describe_field<Fields>(internals::FieldName<Layout>::get(I))...};
+
+  // index of the field named name, size if there is none
+  static constexpr size_t find(const char* name, size_t i = 0) {
+    return (i >= size || equal(fields[i].name, name)) ? i : find(name, i + 1);
+  }
+
+  const FieldDescriptor* begin() const {
+    return fields;
+  }
+  const FieldDescriptor* end() const {
+    return fields + size;
+  }
+
+ private:
+  static constexpr bool equal(const char* a, const char* b) {
+    return (*a == *b) && (*a == '\0' || equal(a + 1, b + 1));
+  }
+};
+
+template <typename Layout, typename... Fields, size_t... I>
+constexpr FieldDescriptor FieldTable<Layout, FieldList<Fields...>, internals::IndexList<I...>>::fields[];
+
+}  // namespace vstruct
+
+#endif  // VSTRUCT_DESCRIBE_H_
@@ -0,0 +1,637 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// This file provides record decoding for layouts only known at runtime.
+///
+/// A DynamicLayout is loaded from the JSON schema written by vstruct_gen_header.py --schema, from its
+/// compact binary form, or from the FieldTable of a compiled layout. Loading compiles the fields into a
+/// flat decode plan, one step per element: first byte, shift, mask and sign extension. Decoding a record
+/// runs the plan with one word load, a shift, a mask and an optional sign extension per element, the same
+/// operations as the fixed offset accessors, with the offsets read from the plan instead of the code.
+/// Big endian elements byte swap the loaded word first, as BEOrderAt does.
+///
+/// Every element decodes to a 64 bit slot: integers are sign or zero extended, bools are 0 or 1 and
+/// floating point elements keep their bit pattern. get<T>() converts a slot to a native type.
+///
+/// Example Usage:
+///
+/// vstruct::DynamicLayout layout;
+/// if (!layout.parse_json(text, "Example1")) {
+///   fprintf(stderr, "bad schema\n");
+/// }
+/// size_t x4 = layout.find("x4");
+/// std::vector<uint64_t> slots(count * layout.slots());
+/// layout.decode(records, count, slots.data());  // count records, record_bytes apart
+/// uint32_t value = layout.get<uint32_t>(records, x4);
+///
+#ifndef VSTRUCT_DYNAMIC_H_
+#define VSTRUCT_DYNAMIC_H_
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "./internals.h"
+#include "./describe.h"
+
+namespace vstruct {
+namespace internals {
+
+/// JsonReader - minimal pull parser for the schema, objects, arrays, strings, unsigned numbers and literals
+/// Every function returns false on a syntax error and leaves the position at the error.
+class JsonReader {
+ public:
+  JsonReader(const char* text, size_t length): p_(text), end_(text + length) {}
+
+  bool at_end() {
+    skip_space();
+    return p_ == end_;
+  }
+
+  // true if the next character is c, which is consumed
+  bool accept(char c) {
+    skip_space();
+    if (p_ != end_ && *p_ == c) {
+      p_++;
+      return true;
+    }
+    return false;
+  }
+
+  bool peek(char c) {
+    skip_space();
+    return p_ != end_ && *p_ == c;
+  }
+
+  bool string(std::string* out) {
+    if (!accept('"')) {
+      return false;
+    }
+    out->clear();
+    while (p_ != end_ && *p_ != '"') {
+      char c = *p_++;
+      if (c == '\\') {
+        if (p_ == end_) {
+          return false;
+        }
+        c = *p_++;
+        switch (c) {
+          case 'n': c = '\n'; break;
+          case 't': c = '\t'; break;
+          case 'r': c = '\r'; break;
+          case 'b': c = '\b'; break;
+          case 'f': c = '\f'; break;
+          case 'u': return false;  // not used by the schema
+          default: break;  // \" \\ and \/ are the character itself
+        }
+      }
+      out->push_back(c);
+    }
+    return accept_raw('"');
+  }
+
+  // unsigned integer up to UINT32_MAX, as the u32 numbers of the binary form
+  bool number(size_t* out) {
+    skip_space();
+    if (p_ == end_ || *p_ < '0' || *p_ > '9') {
+      return false;
+    }
+    uint64_t x = 0;
+    while (p_ != end_ && *p_ >= '0' && *p_ <= '9') {
+      x = x * 10 + static_cast<uint64_t>(*p_++ - '0');
+      if (x > UINT32_MAX) {
+        return false;
+      }
+    }
+    *out = x;
+    return true;
+  }
+
+  bool boolean(bool* out) {
+    if (literal("true")) {
+      *out = true;
+      return true;
+    }
+    if (literal("false")) {
+      *out = false;
+      return true;
+    }
+    return false;
+  }
+
+  // skip any value, for keys the schema reader does not know
+  bool skip() {
+    std::string s;
+    size_t n;
+    bool b;
+    if (peek('"')) {
+      return string(&s);
+    }
+    if (accept('[')) {
+      return list([this]() { return skip(); }, ']');
+    }
+    if (accept('{')) {
+      return list([this, &s]() { return string(&s) && accept(':') && skip(); }, '}');
+    }
+    if (peek('-')) {
+      p_++;
+    }
+    if (number(&n)) {
+      while (p_ != end_ && (*p_ == '.' || *p_ == 'e' || *p_ == 'E' || *p_ == '+' || *p_ == '-' ||
+                            (*p_ >= '0' && *p_ <= '9'))) {
+        p_++;
+      }
+      return true;
+    }
+    return boolean(&b) || literal("null");
+  }
+
+  // elements of an array or members of an object after the opening bracket, fn reads one of them
+  template <typename Fn>
+  bool list(Fn fn, char close) {
+    if (accept(close)) {
+      return true;
+    }
+    do {
+      if (!fn()) {
+        return false;
+      }
+    } while (accept(','));
+    return accept(close);
+  }
+
+ private:
+  void skip_space() {
+    while (p_ != end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) {
+      p_++;
+    }
+  }
+
+  bool accept_raw(char c) {
+    if (p_ != end_ && *p_ == c) {
+      p_++;
+      return true;
+    }
+    return false;
+  }
+
+  bool literal(const char* word) {
+    skip_space();
+    size_t n = strlen(word);
+    if (static_cast<size_t>(end_ - p_) < n || memcmp(p_, word, n) != 0) {
+      return false;
+    }
+    p_ += n;
+    return true;
+  }
+
+  const char* p_;
+  const char* end_;
+};
+
+/// ScalarType - unpacked types of a schema, the binary schema stores the index
+struct ScalarType {
+  const char* name;
+  size_t bits;
+  bool is_signed;
+  bool is_float;
+};
+
+inline const ScalarType* scalar_types(size_t* count) {
+  static const ScalarType types[] = {
+    {"bool", 1, false, false},
+    {"uint8_t", 8, false, false}, {"int8_t", 8, true, false},
+    {"uint16_t", 16, false, false}, {"int16_t", 16, true, false},
+    {"uint32_t", 32, false, false}, {"int32_t", 32, true, false},
+    {"uint64_t", 64, false, false}, {"int64_t", 64, true, false},
+    {"float", 32, true, true}, {"double", 64, true, true}};
+  *count = sizeof(types) / sizeof(types[0]);
+  return types;
+}
+
+}  // namespace internals
+
+/// DynamicLayout - record layout loaded at runtime, decoded with a precompiled plan
+/// Functions loading a schema return false if it cannot be read or is not a valid layout,
+/// the layout is then empty.
+class DynamicLayout {
+ public:
+  struct Field {
+    std::string name;
+    FieldKind kind;
+    std::string type;  // unpacked C++ type, for example "int16_t"
+    size_t first_bit;
+    size_t Sz;  // bits per element
+    size_t N;  // elements, 1 for items
+    bool is_signed;
+    bool is_float;
+    size_t slot;  // slot of element 0 in a decoded record
+  };
+
+  /// Step - decode plan of one element
+  struct Step {
+    uint32_t byte;  // first byte of the element in the record
+    uint8_t shift;  // bit offset of the element in that byte, from the msb for big endian elements
+    uint8_t extend;  // 64 - Sz for sign extension, 0 for unsigned elements
+    uint8_t nbytes;  // bytes of the element within the first 8, 1 to 8
+    uint8_t spill;  // 1 if the element reaches into a 9th byte
+    uint8_t word;  // 1 if a word load from byte stays within the record
+    uint8_t big_endian;  // 1 for elements of be_item and be_array fields
+    uint8_t Sz;  // bits of the element
+    uint64_t mask;
+  };
+
+  enum : uint32_t {
+    binary_magic = 0x314c5356  // "VSL1"
+  };
+
+  DynamicLayout(): record_bits_(0) {}
+
+  // layout of a compiled struct, for example DynamicLayout::from_table<Example1>()
+  template <typename Layout>
+  static DynamicLayout from_table() {
+    DynamicLayout layout;
+    for (const FieldDescriptor& d : FieldTable<Layout>()) {
+      layout.add(d.name, d.kind, d.type, d.first_bit, d.Sz, d.N);
+    }
+    layout.finish(Layout::record_bits);
+    return layout;
+  }
+
+  const std::string& name() const {
+    return name_;
+  }
+  size_t record_bits() const {
+    return record_bits_;
+  }
+  size_t record_bytes() const {
+    return (record_bits_ + 7) >> 3;
+  }
+  const std::vector<Field>& fields() const {
+    return fields_;
+  }
+  const std::vector<Step>& plan() const {
+    return plan_;
+  }
+  // 64 bit slots of a decoded record, one per element
+  size_t slots() const {
+    return plan_.size();
+  }
+
+  // index of the field named name, fields().size() if there is none
+  size_t find(const std::string& name) const {
+    size_t i = 0;
+    while (i < fields_.size() && fields_[i].name != name) {
+      i++;
+    }
+    return i;
+  }
+
+  // load struct_name from the JSON schema, or the first struct if struct_name is empty
+  bool parse_json(const std::string& text, const std::string& struct_name = "") {
+    clear();
+    internals::JsonReader json(text.data(), text.size());
+    bool found = false;
+    auto one = [&]() {
+      if (found) {
+        return json.skip();
+      }
+      if (!parse_struct(&json)) {
+        return false;
+      }
+      found = struct_name.empty() || name_ == struct_name;
+      if (!found) {
+        clear();
+      }
+      return true;
+    };
+    bool ok = json.accept('[') ? json.list(one, ']') : one();
+    if (!ok || !json.at_end() || !found || !finish(record_bits_)) {
+      clear();
+      return false;
+    }
+    return true;
+  }
+
+  // compact binary form, all numbers little endian:
+  // magic u32, record_bits u32, name, fields u32, then per field kind u8, type u8, first_bit u32, Sz u8, N u32, name
+  // names are a u8 length followed by the characters
+  std::vector<pbuf_type> to_binary() const {
+    std::vector<pbuf_type> out;
+    put(&out, binary_magic, 4);
+    put(&out, record_bits_, 4);
+    put_name(&out, name_);
+    put(&out, fields_.size(), 4);
+    for (const Field& f : fields_) {
+      put(&out, static_cast<uint64_t>(f.kind), 1);
+      put(&out, type_index(f.type), 1);
+      put(&out, f.first_bit, 4);
+      put(&out, f.Sz, 1);
+      put(&out, f.N, 4);
+      put_name(&out, f.name);
+    }
+    return out;
+  }
+
+  bool parse_binary(const pbuf_type* data, size_t length) {
+    clear();
+    const pbuf_type* p = data;
+    const pbuf_type* end = data + length;
+    uint64_t magic, bits, count;
+    bool ok = get(&p, end, 4, &magic) && magic == binary_magic &&
+              get(&p, end, 4, &bits) && get_name(&p, end, &name_) && get(&p, end, 4, &count);
+    size_t types;
+    const internals::ScalarType* scalar = internals::scalar_types(&types);
+    for (uint64_t i = 0; ok && i < count; i++) {
+      uint64_t kind, type, first_bit, Sz, N;
+      std::string name;
+      ok = get(&p, end, 1, &kind) && kind <= static_cast<uint64_t>(FieldKind::be_array) &&
+           get(&p, end, 1, &type) && type < types &&
+           get(&p, end, 4, &first_bit) && get(&p, end, 1, &Sz) && get(&p, end, 4, &N) &&
+           get_name(&p, end, &name);
+      if (ok) {
+        add(name, static_cast<FieldKind>(kind), scalar[type].name, first_bit, Sz, N);
+      }
+    }
+    if (!ok || p != end || !finish(bits)) {
+      clear();
+      return false;
+    }
+    return true;
+  }
+
+  // raw slot of element index of field i
+  uint64_t get_slot(const pbuf_type* pRecord, size_t i, size_t index = 0) const {
+    assert(i < fields_.size() && index < fields_[i].N && "Index is out of bounds!");
+    return run(pRecord, plan_[fields_[i].slot + index]);
+  }
+
+  // element index of field i converted to T
+  template <typename T>
+  T get(const pbuf_type* pRecord, size_t i, size_t index = 0) const {
+    return convert<T>(fields_[i], get_slot(pRecord, i, index));
+  }
+
+  // slot of field f as T, for slots of a decoded record
+  template <typename T>
+  static T convert(const Field& f, uint64_t slot) {
+    if (f.is_float) {
+      if (f.Sz == 32) {
+        float x;
+        uint32_t bits = static_cast<uint32_t>(slot);
+        memcpy(&x, &bits, sizeof(x));
+        return static_cast<T>(x);
+      }
+      double x;
+      memcpy(&x, &slot, sizeof(x));
+      return static_cast<T>(x);
+    }
+    if (f.is_signed) {
+      return static_cast<T>(static_cast<int64_t>(slot));
+    }
+    return static_cast<T>(slot);
+  }
+
+  // decode every element of a record to out, slots() values
+  void decode(const pbuf_type* pRecord, uint64_t* out) const {
+    const Step* steps = plan_.data();
+    for (size_t s = 0, n = plan_.size(); s < n; s++) {
+      out[s] = run(pRecord, steps[s]);
+    }
+  }
+
+  // decode count records, record_bytes apart, to count * slots() values
+  void decode(const pbuf_type* records, size_t count, uint64_t* out) const {
+    size_t stride = record_bytes();
+    size_t n = plan_.size();
+    for (size_t r = 0; r < count; r++) {
+      decode(records + r * stride, out + r * n);
+    }
+  }
+
+  // element index of field i of count records, record_bytes apart, to out
+  void extract(size_t i, const pbuf_type* records, size_t count, uint64_t* out, size_t index = 0) const {
+    assert(i < fields_.size() && index < fields_[i].N && "Index is out of bounds!");
+    const Step step = plan_[fields_[i].slot + index];
+    size_t stride = record_bytes();
+    for (size_t r = 0; r < count; r++) {
+      out[r] = run(records + r * stride, step);
+    }
+  }
+
+ private:
+  static uint64_t run(const pbuf_type* pRecord, const Step& s) {
+    const pbuf_type* p = pRecord + s.byte;
+    uint64_t x;
+    if (s.word) {
+      x = internals::WordAccess::load(p);
+    } else {  // near the end of the record, only the bytes of the element
+      x = 0;
+      for (size_t i = 0; i < s.nbytes; i++) {
+        x |= static_cast<uint64_t>(p[i]) << (i << 3);
+      }
+    }
+    if (s.big_endian) {  // first byte to the top, the element ends up in the top Sz bits
+      x = internals::ByteSwap<uint64_t>::swap(x) << s.shift;
+      if (s.spill) {
+        x |= static_cast<uint64_t>(p[8]) >> (8 - s.shift);
+      }
+      x >>= 64 - s.Sz;
+    } else {
+      x >>= s.shift;
+      if (s.spill) {
+        x |= static_cast<uint64_t>(p[8]) << (64 - s.shift);
+      }
+      x &= s.mask;
+    }
+    if (s.extend) {
+      x = static_cast<uint64_t>(static_cast<int64_t>(x << s.extend) >> s.extend);
+    }
+    return x;
+  }
+
+  void clear() {
+    name_.clear();
+    record_bits_ = 0;
+    fields_.clear();
+    plan_.clear();
+  }
+
+  void add(const std::string& name, FieldKind kind, const std::string& type, size_t first_bit, size_t Sz, size_t N) {
+    Field f;
+    f.name = name;
+    f.kind = kind;
+    f.type = type;
+    f.first_bit = first_bit;
+    f.Sz = Sz;
+    f.N = N;
+    f.is_signed = false;
+    f.is_float = false;
+    f.slot = 0;
+    fields_.push_back(f);
+  }
+
+  // check the fields and compile the plan
+  bool finish(size_t record_bits) {
+    record_bits_ = record_bits;
+    if (record_bits > UINT32_MAX) {  // byte offsets must fit Step::byte
+      return false;
+    }
+    size_t types;
+    const internals::ScalarType* scalar = internals::scalar_types(&types);
+    size_t record_bytes = (record_bits + 7) >> 3;
+    plan_.clear();
+    for (Field& f : fields_) {
+      size_t t = type_index(f.type);
+      if (t >= types) {
+        return false;
+      }
+      bool is_bool = (t == 0);
+      bool is_array = (f.kind == FieldKind::le_array || f.kind == FieldKind::bool_array ||
+                       f.kind == FieldKind::be_array);
+      bool bool_kind = (f.kind == FieldKind::bool_item || f.kind == FieldKind::bool_array);
+      if (is_bool != bool_kind || f.Sz < 1 || f.Sz > scalar[t].bits || f.N < 1 || (!is_array && f.N != 1) ||
+          (scalar[t].is_float && f.Sz != scalar[t].bits) ||
+          f.first_bit > record_bits || f.N > (record_bits - f.first_bit) / f.Sz) {  // inside, without overflow
+        return false;
+      }
+      f.type = scalar[t].name;
+      f.is_signed = scalar[t].is_signed;
+      f.is_float = scalar[t].is_float;
+      f.slot = plan_.size();
+      for (size_t k = 0; k < f.N; k++) {
+        size_t bit = f.first_bit + k * f.Sz;
+        Step s;
+        s.byte = static_cast<uint32_t>(bit >> 3);
+        s.shift = static_cast<uint8_t>(bit & 0x7);
+        s.extend = static_cast<uint8_t>((f.is_signed && !f.is_float && f.Sz < 64) ? 64 - f.Sz : 0);
+        size_t total_bytes = (s.shift + f.Sz + 7) >> 3;
+        s.nbytes = static_cast<uint8_t>((total_bytes > 8) ? 8 : total_bytes);
+        s.spill = (total_bytes > 8) ? 1 : 0;
+        s.word = (s.byte + 8u + s.spill <= record_bytes) ? 1 : 0;
+        s.big_endian = (f.kind == FieldKind::be_item || f.kind == FieldKind::be_array) ? 1 : 0;
+        s.Sz = static_cast<uint8_t>(f.Sz);
+        s.mask = (f.Sz == 64) ? ~uint64_t{0} : (uint64_t{1} << f.Sz) - 1;
+        plan_.push_back(s);
+      }
+    }
+    return true;
+  }
+
+  bool parse_struct(internals::JsonReader* json) {
+    clear();
+    bool has_bits = false;
+    std::string key;
+    return json->accept('{') && json->list([&]() {
+      if (!json->string(&key) || !json->accept(':')) {
+        return false;
+      }
+      if (key == "name") {
+        return json->string(&name_);
+      }
+      if (key == "record_bits") {
+        has_bits = true;
+        return json->number(&record_bits_);
+      }
+      if (key == "fields") {
+        return json->accept('[') && json->list([&]() { return parse_field(json); }, ']');
+      }
+      return json->skip();
+    }, '}') && has_bits;
+  }
+
+  bool parse_field(internals::JsonReader* json) {
+    std::string key, name, kind, type;
+    size_t first_bit = 0, Sz = 0, N = 1;
+    bool ok = json->accept('{') && json->list([&]() {
+      if (!json->string(&key) || !json->accept(':')) {
+        return false;
+      }
+      if (key == "name") {
+        return json->string(&name);
+      }
+      if (key == "kind") {
+        return json->string(&kind);
+      }
+      if (key == "type") {
+        return json->string(&type);
+      }
+      if (key == "first_bit") {
+        return json->number(&first_bit);
+      }
+      if (key == "Sz") {
+        return json->number(&Sz);
+      }
+      if (key == "N") {
+        return json->number(&N);
+      }
+      return json->skip();  // is_signed follows from the type
+    }, '}');
+    static const char* const kinds[] = {"le_item", "le_array", "bool_item", "bool_array", "be_item", "be_array"};
+    for (size_t k = 0; ok && k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+      if (kind == kinds[k]) {
+        add(name, static_cast<FieldKind>(k), type, first_bit, Sz, N);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static size_t type_index(const std::string& type) {
+    size_t types;
+    const internals::ScalarType* scalar = internals::scalar_types(&types);
+    size_t t = 0;
+    while (t < types && type != scalar[t].name) {
+      t++;
+    }
+    return t;
+  }
+
+  static void put(std::vector<pbuf_type>* out, uint64_t x, size_t nbytes) {
+    for (size_t i = 0; i < nbytes; i++) {
+      out->push_back(static_cast<pbuf_type>(x >> (i << 3)));
+    }
+  }
+
+  static void put_name(std::vector<pbuf_type>* out, const std::string& name) {
+    size_t n = (name.size() < 255) ? name.size() : 255;
+    put(out, n, 1);
+    out->insert(out->end(), name.begin(), name.begin() + n);
+  }
+
+  static bool get(const pbuf_type** p, const pbuf_type* end, size_t nbytes, uint64_t* x) {
+    if (static_cast<size_t>(end - *p) < nbytes) {
+      return false;
+    }
+    *x = 0;
+    for (size_t i = 0; i < nbytes; i++) {
+      *x |= static_cast<uint64_t>((*p)[i]) << (i << 3);
+    }
+    *p += nbytes;
+    return true;
+  }
+
+  static bool get_name(const pbuf_type** p, const pbuf_type* end, std::string* name) {
+    uint64_t n;
+    if (!get(p, end, 1, &n) || static_cast<size_t>(end - *p) < n) {
+      return false;
+    }
+    name->assign(reinterpret_cast<const char*>(*p), n);
+    *p += n;
+    return true;
+  }
+
+  std::string name_;
+  size_t record_bits_;
+  std::vector<Field> fields_;
+  std::vector<Step> plan_;
+};
+
+}  // namespace vstruct
+
+#endif  // VSTRUCT_DYNAMIC_H_
@@ -0,0 +1,198 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// This file provides access to a group of neighbouring small fields in one go.
+///
+/// The fields of a group are loaded with a single span access and spread into the lanes of a 64 bit word,
+/// field i going into lane i. On cpus with BMI2 the spread is one pext to gather the field bits
+/// followed by one pdep to deposit them into the lanes, other cpus use a shift and mask per field.
+///
+/// Example Usage:
+///
+/// using Group = vstruct::FieldGroup<uint8_t, decltype(s.b0), decltype(s.x0), decltype(s.x1)>;
+/// uint64_t lanes = Group::extract(s.getBuffer());
+/// int8_t x1 = Group::get<2>(lanes);  // same as s.x1
+///
+#ifndef VSTRUCT_FIELDGROUP_H_
+#define VSTRUCT_FIELDGROUP_H_
+
+#include <stdint.h>
+#include <type_traits>
+#include "./internals.h"
+#include "./cpu.h"
+
+namespace vstruct {
+namespace internals {
+
+/// GroupLanes - compile time masks and portable spread/gather for fields F, Rest...
+/// Template args:
+///   base_bit: first bit of the byte holding the first field
+///   prev_end: bit after the end of the previous field
+///   lane_bits: bits per lane
+///   index: lane of field F
+template <size_t base_bit, size_t prev_end, size_t lane_bits, size_t index, class... Fields>
+struct GroupLanes {  // end of the group
+  enum : uint64_t {
+    src_mask = 0,
+    lane_mask = 0
+  };
+  enum : size_t {
+    end_bit = prev_end
+  };
+  static uint64_t spread(uint64_t) {
+    return 0;
+  }
+  static uint64_t gather(uint64_t) {
+    return 0;
+  }
+};
+
+template <size_t base_bit, size_t prev_end, size_t lane_bits, size_t index, class F, class... Rest>
+struct GroupLanes<base_bit, prev_end, lane_bits, index, F, Rest...> {
+  static_assert(F::first_bit >= prev_end, "fields must be in ascending bit order without overlap");
+  static_assert(F::N == 1, "field group of an array field is not supported");
+  static_assert(!IsBigEndian<F>::value, "field group of a big endian field is not supported");
+  static_assert(F::bit_size <= lane_bits, "field does not fit in a lane");
+  static_assert((index + 1) * lane_bits <= 64, "too many fields for the lane size");
+  enum : size_t {
+    src_shift = F::first_bit - base_bit,
+    lane_shift = index * lane_bits
+  };
+  enum : uint64_t {
+    field_mask = MaskMax<uint64_t, F::bit_size>::value
+  };
+  using Next = GroupLanes<base_bit, F::first_bit + F::bit_size, lane_bits, index + 1, Rest...>;
+  enum : uint64_t {
+    src_mask = (static_cast<uint64_t>(field_mask) << src_shift) | Next::src_mask,
+    lane_mask = (static_cast<uint64_t>(field_mask) << lane_shift) | Next::lane_mask
+  };
+  enum : size_t {
+    end_bit = Next::end_bit
+  };
+
+  // word holds the bits from base_bit onwards
+  static uint64_t spread(uint64_t word) {
+    return (((word >> src_shift) & field_mask) << lane_shift) | Next::spread(word);
+  }
+
+  // inverse of spread, bits outside the fields are zero
+  static uint64_t gather(uint64_t lanes) {
+    return (((lanes >> lane_shift) & field_mask) << src_shift) | Next::gather(lanes);
+  }
+};
+
+/// GroupField - type of field i
+template <size_t i, class F, class... Rest>
+struct GroupField {
+  using type = typename GroupField<i - 1, Rest...>::type;
+};
+
+template <class F, class... Rest>
+struct GroupField<0, F, Rest...> {
+  using type = F;
+};
+
+/// GroupUnpack - unpack a lane to the unpacked type of field F
+template <class F, bool is_bool = std::is_same<typename F::unpackedT, bool>::value>
+struct GroupUnpack {
+  static_assert(F::N == 1, "field group of an array field is not supported");
+  typedef typename F::unpackedT type;
+  static type unpack(uint64_t x) {
+    return Packer<type, F::Sz>::unpack(static_cast<typename F::packedT>(x));
+  }
+};
+
+template <class F>
+struct GroupUnpack<F, true> {
+  static_assert(F::N == 1, "field group of an array field is not supported");
+  typedef bool type;
+  static type unpack(uint64_t x) {
+    return x != 0;
+  }
+};
+
+}  // namespace internals
+
+/// FieldGroup - extract/insert neighbouring fields of a vstruct together
+/// Template args:
+///   Lane: unsigned lane type, uint8_t for up to 8 fields of up to 8 bits each, uint16_t for up to 4 fields
+///   Fields: item types of the fields, in ascending bit order and within 8 bytes from the first byte of the group
+template <typename Lane, class F0, class... Fields>
+struct FieldGroup {
+  static_assert(std::is_unsigned<Lane>::value && sizeof(Lane) <= 4, "Lane must be uint8_t, uint16_t or uint32_t");
+  enum : size_t {
+    lanes = 1 + sizeof...(Fields),
+    lane_bits = sizeof(Lane) << 3,
+    base_byte = F0::first_bit >> 3,
+    base_bit = base_byte << 3
+  };
+  using Lanes_ = internals::GroupLanes<base_bit, base_bit, lane_bits, 0, F0, Fields...>;
+  enum : size_t {
+    span_bytes = (Lanes_::end_bit - base_bit + 7) >> 3
+  };
+  static_assert(span_bytes <= 8, "fields of a group must be within 8 bytes");
+  enum : uint64_t {
+    src_mask = Lanes_::src_mask,
+    lane_mask = Lanes_::lane_mask
+  };
+  using Span = internals::SpanAccess<span_bytes>;
+
+  // packed value of field i in lane i, pRoot is the pointer to the start of buffer
+  static uint64_t extract(const pbuf_type* pRoot) {
+    uint64_t word = Span::load(&pRoot[base_byte]);
+#if VSTRUCT_X86_BMI2
+    if (internals::CpuFeatures::get().bmi2) {
+      return spread_bmi2(word);
+    }
+#endif
+    return Lanes_::spread(word);
+  }
+
+  // write the packed value in lane i to field i, bits outside the fields are unchanged
+  static void insert(pbuf_type* pRoot, uint64_t lanes) {
+    uint64_t word = Span::load(&pRoot[base_byte]);
+    uint64_t bits;
+#if VSTRUCT_X86_BMI2
+    if (internals::CpuFeatures::get().bmi2) {
+      bits = gather_bmi2(lanes);
+    } else {
+      bits = Lanes_::gather(lanes);
+    }
+#else
+    bits = Lanes_::gather(lanes);
+#endif
+    word = (word & ~static_cast<uint64_t>(src_mask)) | bits;
+    Span::store(&pRoot[base_byte], word);
+  }
+
+  // packed value in lane i
+  template <size_t i>
+  static Lane lane(uint64_t lanes) {
+    static_assert(i < FieldGroup::lanes, "lane index is out of bounds");
+    return static_cast<Lane>(lanes >> (i * lane_bits));
+  }
+
+  // unpacked value of field i
+  template <size_t i>
+  static typename internals::GroupUnpack<typename internals::GroupField<i, F0, Fields...>::type>::type
+  get(uint64_t lanes) {
+    return internals::GroupUnpack<typename internals::GroupField<i, F0, Fields...>::type>::unpack(lane<i>(lanes));
+  }
+
+#if VSTRUCT_X86_BMI2
+  VSTRUCT_TARGET("bmi2") static uint64_t spread_bmi2(uint64_t word) {
+    return _pdep_u64(_pext_u64(word, src_mask), lane_mask);
+  }
+
+  VSTRUCT_TARGET("bmi2") static uint64_t gather_bmi2(uint64_t lanes) {
+    return _pdep_u64(_pext_u64(lanes, lane_mask), src_mask);
+  }
+#endif
+};
+
+}  // namespace vstruct
+
+#endif  // VSTRUCT_FIELDGROUP_H_
@@ -1,330 +1,1420 @@
-///
-/// Copyright (c) 2019 Joseph Lee Yuan Sheng
-///
-/// This file is part of vstruct which is released under MIT license.
-/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
-///
-/// This file provides the internal mechanisms used to access data.
-///
-///
-#ifndef VSTRUCT_INTERNALS_H_
-#define VSTRUCT_INTERNALS_H_
-
-#include <assert.h>
-#include <stdint.h>
-#include <limits>
-#include <type_traits>
-
-namespace vstruct {
-typedef uint8_t pbuf_type;
-
-namespace internals {
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// Templated iteration to get Max value
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-template <typename T, size_t Sz>  // add one bit for each bit in size
-struct MaskMax {
-  enum : T {
-    value = std::is_signed<T>::value ?
-      MaskMax<typename std::make_unsigned<T>::type, Sz - 1>::value :  // one bit is used for sign
-      (MaskMax<T, Sz - 1>::value << 1) | 1  // add one bit
-  };
-};
-
-template <typename T>  // final iteration
-struct MaskMax<T, 0> {
-  enum : T {
-    value = 0,
-  };
-};
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// Byte Access
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-// access helper
-template<size_t Sz, size_t offset>
-struct ByteSubStruct {
-    union {
-        struct {
-            uint8_t pad: offset;
-            uint8_t element : Sz;
-        } bits;
-        uint8_t reg;
-    };
-};
-
-// access helper specializiation for 0 offset
-template<size_t Sz>
-struct ByteSubStruct<Sz, 0> {
-    union {
-        struct {
-            uint8_t element : Sz;
-        } bits;
-        uint8_t reg;
-    };
-};
-
-template<size_t Sz, size_t offset = 0>
-struct ByteAccess final{
-    static_assert(Sz + offset <= 8, "must fit in a single byte");
-    using ByteStruct = ByteSubStruct <Sz, offset>;
-    static_assert(sizeof(ByteStruct) == 1, "compiler unexpected uses an invalid size");
-
-    static void set(pbuf_type* buf, uint8_t value) {
-        reinterpret_cast<ByteStruct*>(buf)->bits.element = value;
-    }
-    static uint8_t get(pbuf_type* buf) {
-        return reinterpret_cast<ByteStruct*>(buf)->bits.element;
-    }
-};
-
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// Class definitions
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-/// LEOrder - methods to get/set in little endian order
-template <class T, size_t Sz>
-struct LEOrder {
-  static_assert(Sz >= 1, "0 sized Item is not supported");
-  static_assert(
-      std::is_integral<T>::value && std::is_unsigned<T>::value && !std::is_same<T, bool>::value,
-      "This interface class can only deal with unsigned integer types");
-  enum : size_t {
-    nbytes = sizeof(T),
-    nbits = nbytes << 3
-  };
-  enum : T {
-    mask = MaskMax<T, Sz>::value
-  };
-  // pRoot is the pointer to the start of buffer
-  // Get Bits from buffer, Little Endian Ordering
-  static T get(uint8_t* pRoot, size_t starting_bit) {
-    T x;
-    T y;
-    size_t offset_byte = starting_bit >> 3;
-    size_t offset_bit = starting_bit & 0x7;
-    x = 0;
-    for (size_t i=0; i<nbytes; i++)
-    {
-      x |= static_cast<T>(pRoot[offset_byte + i]) << (i << 3);
-    }
-    x >>= offset_bit;
-    if (offset_bit + Sz > nbits)
-    {
-      y = static_cast<T>(pRoot[offset_byte + nbytes]);
-      x |= y << (((nbytes) << 3) - offset_bit);
-    }
-    x &= mask;
-    return x;
-  }
-
-  // Write Bits from buffer, Little Endian Ordering
-  static void set(pbuf_type* pData, size_t starting_bit, T x) {
-    static_assert(Sz >= 1, "0 sized object");
-
-    size_t offset_byte = starting_bit >> 3;
-    size_t offset_bit = starting_bit & 0x7;
-    size_t total_bytes = (offset_bit + Sz + 7) >> 3;
-    size_t shift;
-    pbuf_type byte_mask;
-    x &= mask;
-    // first byte
-    byte_mask = static_cast<pbuf_type>(mask);
-    byte_mask <<= offset_bit;
-    pData[offset_byte] &= ~byte_mask;
-    pData[offset_byte] |= static_cast<pbuf_type>(x << offset_bit);
-    // middle bytes
-    if (total_bytes > 2) {  // next byte is a direct copy
-      for (size_t i=1; i<total_bytes - 1; i++) {
-        pData[offset_byte + i] = x >> ((i << 3) - offset_bit);
-      }
-    }
-    // last byte
-    if (total_bytes > 1) {
-      shift = ((total_bytes - 1) << 3) - offset_bit;
-      byte_mask = static_cast<pbuf_type>(mask >> shift);
-      pData[offset_byte + total_bytes - 1] &= ~byte_mask;
-      pData[offset_byte + total_bytes - 1] |= static_cast<pbuf_type>(x >> shift);
-    }
-    
-  }
-};
-
-/// Packer - pack value including sign bits
-template <typename T, size_t Sz>
-struct Packer {
-  typedef typename std::conditional<std::is_signed<T>::value && !std::is_floating_point<T>::value,
-                                    typename std::make_unsigned<T>::type, T>::type packedT;
-  // pack
-  static packedT pack(T x) {
-    packedT max_val = static_cast<packedT>(MaskMax<T, Sz>::value);
-    packedT min_val = ~max_val;
-    packedT mask = MaskMax<packedT, Sz>::value;
-
-    if (std::is_floating_point<T>::value) {
-      // dont touch the floating point
-    } else if (x > static_cast<T>(max_val)) {
-      x = max_val;
-    } else if (std::is_signed<T>::value && (x < static_cast<T>(min_val))) {
-      x = min_val;
-    }
-    return static_cast<packedT>(x) & mask;
-  }
-
-  // unpack
-  static T unpack(packedT x) {
-    packedT max_val = static_cast<packedT>(MaskMax<T, Sz>::value);
-    packedT min_val = ~max_val;
-    packedT mask = MaskMax<packedT, Sz>::value;
-    x &= mask;
-    if (std::is_floating_point<T>::value) {
-      // dont touch the floating point
-    } else if (std::is_signed<T>::value && !std::is_floating_point<T>::value && (min_val & x)) {
-      x |= min_val;
-    }
-    return static_cast<T>(x);
-  }
-};
-
-/// TypeBase - all type objects should derive from this
-template <size_t param_bits, size_t param_Sz, size_t param_N>
-struct TypeBaseFunctions {
-  enum : size_t {
-    bits = param_bits,  // first bit position
-    Sz = param_Sz,
-    N = param_N,
-    B = bits >> 3,  // first Byte position
-    b = bits & 0x7u,  // bit offset
-
-    first_byte = B,
-    first_bit = bits,
-    byte_size = (Sz * N + 7) >> 3,
-    bit_size = Sz * N,
-    next_bit = b + (Sz * N),  // for next Item
-    prev_bytes = (bits + 7) >> 3,  // total bytes up to previous (excluding this)
-    total_bytes = (bits + (Sz * N)  + 7) >> 3  // total bytes up to this (including this)
-  };
- protected:
-  ~TypeBaseFunctions(){}
-};
-
-template <typename T, size_t bits, size_t Sz, size_t N>
-struct TypeBase : public TypeBaseFunctions<bits, Sz, N>{
-  typedef T unpackedT;
-  typedef typename Packer<T, Sz>::packedT packedT;
- protected:
-  ~TypeBase(){}
-};
-
-// specialization for bool
-template <size_t bits, size_t Sz, size_t N>
-struct TypeBase <bool, bits, Sz, N> : public TypeBaseFunctions<bits, Sz, N>{
- protected:
-  ~TypeBase(){}
-};
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// Packer Specialization
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-template <size_t Sz>  // specialization for float type
-struct Packer<float, Sz> {
-  static_assert(Sz == 32, "Size must be 32bits for float type");
-  typedef uint32_t packedT;
-  static float unpack(packedT x) {
-    packedT* p = &x;
-    return *(reinterpret_cast<float*>(p));
-  }
-  static packedT pack(float x) {
-    float* p = &x;
-    return *(reinterpret_cast<packedT*>(p));
-  }
-};
-
-
-template <size_t Sz>  // specialization for double type
-struct Packer<double, Sz> {
-  static_assert(Sz == 64, "Size must be 64bits for double type");
-  typedef uint64_t packedT;
-  static double unpack(packedT x) {
-    packedT* p = &x;
-    return *(reinterpret_cast<double*>(p));
-  }
-  static packedT pack(double x) {
-    double* p = &x;
-    return *(reinterpret_cast<packedT*>(p));
-  }
-};
-
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// Temporary Objects
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-/// Temporary object created when Array index is accessed.
-template<typename T, size_t Sz>
-struct LEArrayTemp {
-  pbuf_type* pData_;
-  const size_t first_bit_;
-  using Packer_ = Packer<T, Sz>;
-  typedef typename Packer_::packedT packedT;
-  using LEOrder_ = LEOrder<packedT, Sz>;
-
-  LEArrayTemp(pbuf_type* pData, size_t first_bit)
-  : pData_(pData), first_bit_(first_bit) {
-  }
-
-  // getter
-  operator T () const {
-    return Packer_::unpack(LEOrder_::get(pData_, first_bit_));
-  }
-
-  // setter
-  LEArrayTemp<T, Sz>& operator= (const T& value) {
-    LEOrder_::set(pData_, first_bit_, Packer_::pack(value));
-  }
-};
-
-
-/// Temporary object created when BoolArray index is accessed.
-template<size_t offset, size_t N>
-struct BoolArrayTemp {
-  pbuf_type* const pData_;
-  const size_t index_;
-
-  // Google Style-guide disallows non-const reference for API, we need this
-  // NOLINTNEXTLINE(runtime/references)
-  BoolArrayTemp(pbuf_type* pbuf, size_t index):
-    pData_(pbuf),
-    index_(index) {
-    assert(index < N && "Index is out of bounds!");
-  }
-  operator bool () const {
-    size_t B_ = (offset + index_) >> 3;
-    size_t b_ = (offset + index_) & 0x7;
-    return static_cast<bool>(pData_[B_] & (1u << b_));
-  }
-
-  BoolArrayTemp& operator= (const bool& value) {
-    size_t B_ = (offset + index_) >> 3;
-    size_t b_ = (offset + index_) & 0x7;
-    if (value) {
-      pData_[B_] |= (1u << b_);
-    } else {
-      pData_[B_] &= ~(1u << b_);
-    }
-  }
-};
-
-
-
-}  // namespace internals
-}  // namespace vstruct
-
-
-
-#endif  // VSTRUCT_INTERNALS_H_
-
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// This file provides the internal mechanisms used to access data.
+///
+///
+#ifndef VSTRUCT_INTERNALS_H_
+#define VSTRUCT_INTERNALS_H_
+
+#include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include "./cpu.h"
+
+/// Define VSTRUCT_SLACK_PADDED_BUFFER to 1 if every buffer attached to a vstruct has at least
+/// vstruct::slack_bytes accessible bytes after the last byte of the struct.
+/// All accessors can then use single word loads/stores without any bounds check.
+#ifndef VSTRUCT_SLACK_PADDED_BUFFER
+#define VSTRUCT_SLACK_PADDED_BUFFER 0
+#endif
+
+/// Define VSTRUCT_LEORDER_PEXT to 1 to access array elements with LEOrderPext,
+/// which uses the BMI2 pext/pdep instructions when the running cpu supports them.
+#ifndef VSTRUCT_LEORDER_PEXT
+#define VSTRUCT_LEORDER_PEXT 0
+#endif
+
+namespace vstruct {
+typedef uint8_t pbuf_type;
+
+enum : size_t {
+  slack_bytes = 8  // bytes a word access may touch past the end of a field
+};
+
+/// IsBigEndian - true for the storage types of big endian fields, specialized in itemtypes.h
+template<typename Field>
+struct IsBigEndian : public std::false_type {};
+
+namespace internals {
+
+/// IndexList - compile time list of indices 0 to N - 1, built by MakeIndexList<N>
+template <size_t... I>
+struct IndexList {};
+
+template <typename Low, typename High>
+struct ConcatIndexList;
+
+template <size_t... I, size_t... J>
+struct ConcatIndexList<IndexList<I...>, IndexList<J...>> {
+  using type = IndexList<I..., (sizeof...(I) + J)...>;
+};
+
+// halves N at each step, the instantiation depth is log2(N) rather than N
+template <size_t N>
+struct MakeIndexList {
+  using type = typename ConcatIndexList<typename MakeIndexList<N / 2>::type,
+                                        typename MakeIndexList<N - N / 2>::type>::type;
+};
+
+template <>
+struct MakeIndexList<0> {
+  using type = IndexList<>;
+};
+
+template <>
+struct MakeIndexList<1> {
+  using type = IndexList<0>;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Max value of Sz bits
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// low_mask - unsigned U with the n low bits set
+template <typename U>
+constexpr U low_mask(size_t n) {
+  return (n >= (sizeof(U) << 3)) ? static_cast<U>(~static_cast<U>(0)) :
+    static_cast<U>((static_cast<U>(1) << n) - 1);
+}
+
+/// mask_max - max value of T packed in Sz bits, a signed T uses one bit for the sign
+template <typename T>
+constexpr T mask_max(size_t Sz) {
+  return std::is_signed<T>::value ?
+    static_cast<T>(low_mask<typename std::conditional<std::is_signed<T>::value,
+                                                      std::make_unsigned<T>,
+                                                      std::common_type<T>>::type::type>((Sz > 0) ? Sz - 1 : 0)) :
+    low_mask<T>(Sz);
+}
+
+template <typename T, size_t Sz>
+struct MaskMax {
+  enum : T {
+    value = mask_max<T>(Sz)
+  };
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Byte Access
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// access helper
+template<size_t Sz, size_t offset>
+struct ByteSubStruct {
+    union {
+        struct {
+            uint8_t pad: offset;
+            uint8_t element : Sz;
+        } bits;
+        uint8_t reg;
+    };
+};
+
+// access helper specializiation for 0 offset
+template<size_t Sz>
+struct ByteSubStruct<Sz, 0> {
+    union {
+        struct {
+            uint8_t element : Sz;
+        } bits;
+        uint8_t reg;
+    };
+};
+
+template<size_t Sz, size_t offset = 0>
+struct ByteAccess final{
+    static_assert(Sz + offset <= 8, "must fit in a single byte");
+    using ByteStruct = ByteSubStruct <Sz, offset>;
+    static_assert(sizeof(ByteStruct) == 1, "compiler unexpected uses an invalid size");
+
+    static void set(pbuf_type* buf, uint8_t value) {
+        reinterpret_cast<ByteStruct*>(buf)->bits.element = value;
+    }
+    static uint8_t get(const pbuf_type* buf) {
+        return reinterpret_cast<const ByteStruct*>(buf)->bits.element;
+    }
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Word Access
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// ByteSwap - reverse byte order of an unsigned integer
+template <typename U>
+struct ByteSwap;
+template <> struct ByteSwap<uint8_t> {
+  static uint8_t swap(uint8_t x) { return x; }
+};
+template <> struct ByteSwap<uint16_t> {
+  static uint16_t swap(uint16_t x) { return __builtin_bswap16(x); }
+};
+template <> struct ByteSwap<uint32_t> {
+  static uint32_t swap(uint32_t x) { return __builtin_bswap32(x); }
+};
+template <> struct ByteSwap<uint64_t> {
+  static uint64_t swap(uint64_t x) { return __builtin_bswap64(x); }
+};
+
+/// WordAccess - unaligned 64 bit load/store in little endian order
+struct WordAccess final {
+  enum : size_t {
+    nbytes = sizeof(uint64_t),
+    nbits = nbytes << 3
+  };
+  static uint64_t load(const pbuf_type* p) {
+    uint64_t x;
+    memcpy(&x, p, nbytes);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    x = ByteSwap<uint64_t>::swap(x);
+#endif
+    return x;
+  }
+  static void store(pbuf_type* p, uint64_t x) {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    x = ByteSwap<uint64_t>::swap(x);
+#endif
+    memcpy(p, &x, nbytes);
+  }
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Class definitions
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// LEOrder - methods to get/set in little endian order
+///
+/// Fields are read and written with a single unaligned 64 bit word access when the word is known to be inside
+/// the buffer, either because the caller passes the buffer size, or because VSTRUCT_SLACK_PADDED_BUFFER is set.
+/// Otherwise only the bytes spanned by the field are touched, one at a time.
+template <class T, size_t Sz>
+struct LEOrder {
+  static_assert(Sz >= 1, "0 sized Item is not supported");
+  static_assert(
+      std::is_integral<T>::value && std::is_unsigned<T>::value && !std::is_same<T, bool>::value,
+      "This interface class can only deal with unsigned integer types");
+  enum : size_t {
+    nbytes = sizeof(T),
+    nbits = nbytes << 3
+  };
+  enum : T {
+    mask = MaskMax<T, Sz>::value
+  };
+  // pRoot is the pointer to the start of buffer
+  // Get Bits from buffer, Little Endian Ordering
+  static T get(const pbuf_type* pRoot, size_t starting_bit) {
+    if (VSTRUCT_SLACK_PADDED_BUFFER) {
+      return get_word(pRoot, starting_bit);
+    }
+    return get_bytes(pRoot, starting_bit);
+  }
+
+  // Get Bits from a buffer of buf_bytes size, Little Endian Ordering
+  static T get(const pbuf_type* pRoot, size_t starting_bit, size_t buf_bytes) {
+    if (fits_word(starting_bit, buf_bytes)) {
+      return get_word(pRoot, starting_bit);
+    }
+    return get_bytes(pRoot, starting_bit);
+  }
+
+  // Write Bits from buffer, Little Endian Ordering
+  static void set(pbuf_type* pData, size_t starting_bit, T x) {
+    if (VSTRUCT_SLACK_PADDED_BUFFER) {
+      set_word(pData, starting_bit, x);
+    } else {
+      set_bytes(pData, starting_bit, x);
+    }
+  }
+
+  // Write Bits to a buffer of buf_bytes size, Little Endian Ordering
+  static void set(pbuf_type* pData, size_t starting_bit, T x, size_t buf_bytes) {
+    if (fits_word(starting_bit, buf_bytes)) {
+      set_word(pData, starting_bit, x);
+    } else {
+      set_bytes(pData, starting_bit, x);
+    }
+  }
+
+  // true if the word access for starting_bit stays within buf_bytes
+  static bool fits_word(size_t starting_bit, size_t buf_bytes) {
+    size_t offset_bit = starting_bit & 0x7;
+    size_t word_bytes = (offset_bit + Sz > WordAccess::nbits) ? WordAccess::nbytes + 1 : WordAccess::nbytes;
+    return VSTRUCT_SLACK_PADDED_BUFFER || ((starting_bit >> 3) + word_bytes <= buf_bytes);
+  }
+
+  // single word load, may read up to 8 bytes past the end of the field
+  static T get_word(const pbuf_type* pRoot, size_t starting_bit) {
+    size_t offset_byte = starting_bit >> 3;
+    size_t offset_bit = starting_bit & 0x7;
+    uint64_t x = WordAccess::load(&pRoot[offset_byte]) >> offset_bit;
+    if (offset_bit + Sz > WordAccess::nbits) {  // only for Sz > 57
+      x |= static_cast<uint64_t>(pRoot[offset_byte + WordAccess::nbytes]) << (WordAccess::nbits - offset_bit);
+    }
+    return static_cast<T>(x) & mask;
+  }
+
+  // byte loop, only reads the bytes spanned by the field
+  static T get_bytes(const pbuf_type* pRoot, size_t starting_bit) {
+    size_t offset_byte = starting_bit >> 3;
+    size_t offset_bit = starting_bit & 0x7;
+    size_t total_bytes = (offset_bit + Sz + 7) >> 3;
+    T x = 0;
+    for (size_t i=0; i < total_bytes && i < nbytes; i++) {
+      x |= static_cast<T>(pRoot[offset_byte + i]) << (i << 3);
+    }
+    x >>= offset_bit;
+    if (total_bytes > nbytes) {
+      x |= static_cast<T>(pRoot[offset_byte + nbytes]) << (nbits - offset_bit);
+    }
+    x &= mask;
+    return x;
+  }
+
+  // single word read-modify-write, rewrites (unchanged) bytes up to 8 bytes past the end of the field
+  static void set_word(pbuf_type* pData, size_t starting_bit, T x) {
+    size_t offset_byte = starting_bit >> 3;
+    size_t offset_bit = starting_bit & 0x7;
+    uint64_t value = static_cast<uint64_t>(x) & static_cast<uint64_t>(mask);
+    uint64_t word_mask = static_cast<uint64_t>(mask) << offset_bit;
+    uint64_t word = WordAccess::load(&pData[offset_byte]);
+    word = (word & ~word_mask) | (value << offset_bit);
+    WordAccess::store(&pData[offset_byte], word);
+    if (offset_bit + Sz > WordAccess::nbits) {  // only for Sz > 57
+      size_t shift = WordAccess::nbits - offset_bit;
+      pbuf_type byte_mask = static_cast<pbuf_type>(static_cast<uint64_t>(mask) >> shift);
+      pData[offset_byte + WordAccess::nbytes] &= ~byte_mask;
+      pData[offset_byte + WordAccess::nbytes] |= static_cast<pbuf_type>(value >> shift);
+    }
+  }
+
+  // byte loop, only writes the bytes spanned by the field
+  static void set_bytes(pbuf_type* pData, size_t starting_bit, T x) {
+    size_t offset_byte = starting_bit >> 3;
+    size_t offset_bit = starting_bit & 0x7;
+    size_t total_bytes = (offset_bit + Sz + 7) >> 3;
+    size_t shift;
+    pbuf_type byte_mask;
+    x &= mask;
+    // first byte
+    byte_mask = static_cast<pbuf_type>(mask);
+    byte_mask <<= offset_bit;
+    pData[offset_byte] &= ~byte_mask;
+    pData[offset_byte] |= static_cast<pbuf_type>(x << offset_bit);
+    // middle bytes
+    if (total_bytes > 2) {  // next byte is a direct copy
+      for (size_t i=1; i<total_bytes - 1; i++) {
+        pData[offset_byte + i] = x >> ((i << 3) - offset_bit);
+      }
+    }
+    // last byte
+    if (total_bytes > 1) {
+      shift = ((total_bytes - 1) << 3) - offset_bit;
+      byte_mask = static_cast<pbuf_type>(mask >> shift);
+      pData[offset_byte + total_bytes - 1] &= ~byte_mask;
+      pData[offset_byte + total_bytes - 1] |= static_cast<pbuf_type>(x >> shift);
+    }
+  }
+};
+
+/// SpanAccess - load/store of 1 to 8 bytes in little endian order, compiles to fixed size moves
+/// Spans that are not a power of 2 are split into a power of 2 lower part and the remaining upper part.
+template <size_t N>
+struct SpanAccess final {
+  static_assert(N >= 1 && N <= 8, "span must be 1 to 8 bytes");
+  enum : size_t {
+    lower = (N > 4) ? 4 : (N > 2) ? 2 : 1,
+    upper = N - lower
+  };
+  static uint64_t load(const pbuf_type* p) {
+    return SpanAccess<lower>::load(p) | (SpanAccess<upper>::load(p + lower) << (lower << 3));
+  }
+  static void store(pbuf_type* p, uint64_t x) {
+    SpanAccess<lower>::store(p, x);
+    SpanAccess<upper>::store(p + lower, x >> (lower << 3));
+  }
+};
+
+/// SpanAccess for power of 2 spans, a single move of an unsigned integer
+template <typename U>
+struct SpanAccessWord {
+  static uint64_t load(const pbuf_type* p) {
+    U x;
+    memcpy(&x, p, sizeof(U));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    x = ByteSwap<U>::swap(x);
+#endif
+    return x;
+  }
+  static void store(pbuf_type* p, uint64_t value) {
+    U x = static_cast<U>(value);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    x = ByteSwap<U>::swap(x);
+#endif
+    memcpy(p, &x, sizeof(U));
+  }
+};
+
+template <> struct SpanAccess<1> : public SpanAccessWord<uint8_t> {};
+template <> struct SpanAccess<2> : public SpanAccessWord<uint16_t> {};
+template <> struct SpanAccess<4> : public SpanAccessWord<uint32_t> {};
+template <> struct SpanAccess<8> : public SpanAccessWord<uint64_t> {};
+
+/// LEOrderAt - LEOrder for a starting bit known at compile time
+/// Only the bytes spanned by the field are accessed, using a fixed load/shift/mask sequence without loop or branch.
+template <class T, size_t Sz, size_t starting_bit>
+struct LEOrderAt {
+  static_assert(Sz >= 1, "0 sized Item is not supported");
+  static_assert(Sz <= (sizeof(T) << 3), "Sz must fit in T");
+  enum : size_t {
+    offset_byte = starting_bit >> 3,
+    offset_bit = starting_bit & 0x7,
+    total_bytes = (offset_bit + Sz + 7) >> 3,  // 1 to 9 bytes
+    spill = total_bytes > 8,  // 9th byte needed, only for Sz > 57
+    word_bytes = spill ? 8 : total_bytes,
+    spill_shift = (64 - offset_bit) & 63  // shift for the 9th byte
+  };
+  enum : T {
+    mask = MaskMax<T, Sz>::value
+  };
+  using Span = SpanAccess<word_bytes>;
+
+  // pRoot is the pointer to the start of buffer
+  static T get(const pbuf_type* pRoot) {
+    uint64_t x = Span::load(&pRoot[offset_byte]) >> offset_bit;
+    if (spill) {  // resolved at compile time
+      x |= static_cast<uint64_t>(pRoot[offset_byte + WordAccess::nbytes]) << spill_shift;
+    }
+    return static_cast<T>(x) & mask;
+  }
+
+  static void set(pbuf_type* pRoot, T x) {
+    uint64_t value = static_cast<uint64_t>(x) & static_cast<uint64_t>(mask);
+    uint64_t word_mask = static_cast<uint64_t>(mask) << offset_bit;
+    uint64_t word = Span::load(&pRoot[offset_byte]);
+    word = (word & ~word_mask) | (value << offset_bit);
+    Span::store(&pRoot[offset_byte], word);
+    if (spill) {  // resolved at compile time
+      pbuf_type byte_mask = static_cast<pbuf_type>(static_cast<uint64_t>(mask) >> spill_shift);
+      pRoot[offset_byte + WordAccess::nbytes] &= ~byte_mask;
+      pRoot[offset_byte + WordAccess::nbytes] |= static_cast<pbuf_type>(value >> spill_shift);
+    }
+  }
+};
+
+/// BEOrder - methods to get/set in big endian order
+///
+/// Big endian fields number their bits MSB first: bit i is bit 7 - (i & 7) of byte i >> 3, the most significant
+/// bit of the value is at the first bit and whole bytes are in network order. A field is read with a single word
+/// load reversed by a bswap, under the same conditions as LEOrder, otherwise byte by byte.
+template <class T, size_t Sz>
+struct BEOrder {
+  static_assert(Sz >= 1, "0 sized Item is not supported");
+  static_assert(
+      std::is_integral<T>::value && std::is_unsigned<T>::value && !std::is_same<T, bool>::value,
+      "This interface class can only deal with unsigned integer types");
+  enum : T {
+    mask = MaskMax<T, Sz>::value
+  };
+  enum : uint64_t {
+    mask64 = MaskMax<uint64_t, Sz>::value
+  };
+
+  static T get(const pbuf_type* pRoot, size_t starting_bit) {
+    if (VSTRUCT_SLACK_PADDED_BUFFER) {
+      return get_word(pRoot, starting_bit);
+    }
+    return get_bytes(pRoot, starting_bit);
+  }
+
+  static T get(const pbuf_type* pRoot, size_t starting_bit, size_t buf_bytes) {
+    if (fits_word(starting_bit, buf_bytes)) {
+      return get_word(pRoot, starting_bit);
+    }
+    return get_bytes(pRoot, starting_bit);
+  }
+
+  static void set(pbuf_type* pData, size_t starting_bit, T x) {
+    if (VSTRUCT_SLACK_PADDED_BUFFER) {
+      set_word(pData, starting_bit, x);
+    } else {
+      set_bytes(pData, starting_bit, x);
+    }
+  }
+
+  static void set(pbuf_type* pData, size_t starting_bit, T x, size_t buf_bytes) {
+    if (fits_word(starting_bit, buf_bytes)) {
+      set_word(pData, starting_bit, x);
+    } else {
+      set_bytes(pData, starting_bit, x);
+    }
+  }
+
+  static bool fits_word(size_t starting_bit, size_t buf_bytes) {
+    return LEOrder<T, Sz>::fits_word(starting_bit, buf_bytes);
+  }
+
+  // single word load, the value is the top Sz bits after skipping offset_bit bits of the swapped word
+  static T get_word(const pbuf_type* pRoot, size_t starting_bit) {
+    size_t offset_byte = starting_bit >> 3;
+    size_t offset_bit = starting_bit & 0x7;
+    uint64_t x = ByteSwap<uint64_t>::swap(WordAccess::load(&pRoot[offset_byte])) << offset_bit;
+    if (offset_bit + Sz > WordAccess::nbits) {  // only for Sz > 57
+      x |= static_cast<uint64_t>(pRoot[offset_byte + WordAccess::nbytes]) >> (8 - offset_bit);
+    }
+    return static_cast<T>(x >> (WordAccess::nbits - Sz));
+  }
+
+  static void set_word(pbuf_type* pData, size_t starting_bit, T x) {
+    size_t offset_byte = starting_bit >> 3;
+    size_t offset_bit = starting_bit & 0x7;
+    uint64_t value = static_cast<uint64_t>(x) & mask64;
+    uint64_t word = ByteSwap<uint64_t>::swap(WordAccess::load(&pData[offset_byte]));
+    if (offset_bit + Sz <= WordAccess::nbits) {
+      size_t shift = WordAccess::nbits - offset_bit - Sz;
+      word = (word & ~(static_cast<uint64_t>(mask64) << shift)) | (value << shift);
+      WordAccess::store(&pData[offset_byte], ByteSwap<uint64_t>::swap(word));
+    } else {  // the last rem bits go to the top of the 9th byte
+      size_t rem = offset_bit + Sz - WordAccess::nbits;
+      word = (word & ~(static_cast<uint64_t>(mask64) >> rem)) | (value >> rem);
+      WordAccess::store(&pData[offset_byte], ByteSwap<uint64_t>::swap(word));
+      pbuf_type byte_mask = static_cast<pbuf_type>(0xFFu << (8 - rem));
+      pbuf_type& last = pData[offset_byte + WordAccess::nbytes];
+      last = static_cast<pbuf_type>((last & ~byte_mask) | (static_cast<pbuf_type>(value << (8 - rem)) & byte_mask));
+    }
+  }
+
+  // byte i of the field holds the value bits shifted right by Sz + offset_bit - 8 * (i + 1)
+  static T get_bytes(const pbuf_type* pRoot, size_t starting_bit) {
+    size_t offset_byte = starting_bit >> 3;
+    size_t offset_bit = starting_bit & 0x7;
+    size_t total_bytes = (offset_bit + Sz + 7) >> 3;
+    uint64_t x = 0;
+    for (size_t i = 0; i < total_bytes; i++) {
+      ptrdiff_t shift = static_cast<ptrdiff_t>(Sz + offset_bit) - static_cast<ptrdiff_t>((i + 1) << 3);
+      uint64_t byte = pRoot[offset_byte + i] & byte_mask(shift);
+      x |= (shift >= 0) ? (byte << shift) : (byte >> -shift);
+    }
+    return static_cast<T>(x);
+  }
+
+  static void set_bytes(pbuf_type* pData, size_t starting_bit, T x) {
+    size_t offset_byte = starting_bit >> 3;
+    size_t offset_bit = starting_bit & 0x7;
+    size_t total_bytes = (offset_bit + Sz + 7) >> 3;
+    uint64_t value = static_cast<uint64_t>(x) & mask64;
+    for (size_t i = 0; i < total_bytes; i++) {
+      ptrdiff_t shift = static_cast<ptrdiff_t>(Sz + offset_bit) - static_cast<ptrdiff_t>((i + 1) << 3);
+      pbuf_type m = byte_mask(shift);
+      pbuf_type bits = static_cast<pbuf_type>((shift >= 0) ? (value >> shift) : (value << -shift));
+      pData[offset_byte + i] = static_cast<pbuf_type>((pData[offset_byte + i] & ~m) | (bits & m));
+    }
+  }
+
+ private:
+  // bits of the byte that belong to the field
+  static pbuf_type byte_mask(ptrdiff_t shift) {
+    return static_cast<pbuf_type>((shift >= 0) ? (mask64 >> shift) : (mask64 << -shift));
+  }
+};
+
+/// BEOrderAt - BEOrder for a starting bit known at compile time
+/// Only the bytes spanned by the field are accessed: a span load, a bswap and a shift, without loop or branch.
+template <class T, size_t Sz, size_t starting_bit>
+struct BEOrderAt {
+  static_assert(Sz >= 1, "0 sized Item is not supported");
+  static_assert(Sz <= (sizeof(T) << 3), "Sz must fit in T");
+  enum : size_t {
+    offset_byte = starting_bit >> 3,
+    offset_bit = starting_bit & 0x7,
+    total_bytes = (offset_bit + Sz + 7) >> 3,  // 1 to 9 bytes
+    spill = total_bytes > 8,  // 9th byte needed, only for Sz > 57
+    word_bytes = spill ? 8 : total_bytes,
+    word_shift = spill ? 0 : 64 - offset_bit - Sz,  // shift of the value in the swapped word
+    rem = spill ? offset_bit + Sz - 64 : 0  // bits of the value in the 9th byte
+  };
+  enum : uint64_t {
+    mask64 = MaskMax<uint64_t, Sz>::value
+  };
+  using Span = SpanAccess<word_bytes>;
+
+  // the span is swapped so that its first byte is the top byte of the word
+  static uint64_t load(const pbuf_type* pRoot) {
+    return ByteSwap<uint64_t>::swap(Span::load(&pRoot[offset_byte]));
+  }
+
+  static T get(const pbuf_type* pRoot) {
+    uint64_t x = load(pRoot) << offset_bit;
+    if (spill) {  // resolved at compile time
+      x |= static_cast<uint64_t>(pRoot[offset_byte + WordAccess::nbytes]) >> (8 - offset_bit);
+    }
+    return static_cast<T>(x >> (64 - Sz));
+  }
+
+  static void set(pbuf_type* pRoot, T x) {
+    uint64_t value = static_cast<uint64_t>(x) & static_cast<uint64_t>(mask64);
+    uint64_t word = load(pRoot);
+    if (spill) {  // resolved at compile time
+      word = (word & ~(static_cast<uint64_t>(mask64) >> rem)) | (value >> rem);
+      pbuf_type byte_mask = static_cast<pbuf_type>(0xFFu << (8 - rem));
+      pbuf_type& last = pRoot[offset_byte + WordAccess::nbytes];
+      last = static_cast<pbuf_type>((last & ~byte_mask) | (static_cast<pbuf_type>(value << (8 - rem)) & byte_mask));
+    } else {
+      word = (word & ~(static_cast<uint64_t>(mask64) << word_shift)) | (value << word_shift);
+    }
+    Span::store(&pRoot[offset_byte], ByteSwap<uint64_t>::swap(word));
+  }
+};
+
+/// LEOrderPext - LEOrder using the BMI2 pext/pdep instructions
+/// The field is extracted from, or deposited into, a single 64 bit word with one instruction and a run time mask.
+/// Used only when the running cpu supports BMI2 and the word access is allowed,
+/// LEOrder handles all other cases, including fields spilling into a 9th byte.
+template <class T, size_t Sz>
+struct LEOrderPext {
+  using Portable = LEOrder<T, Sz>;
+
+  // pRoot is the pointer to the start of buffer
+  static T get(const pbuf_type* pRoot, size_t starting_bit) {
+    if (VSTRUCT_SLACK_PADDED_BUFFER && use_pext(starting_bit)) {
+      return get_pext(pRoot, starting_bit);
+    }
+    return Portable::get(pRoot, starting_bit);
+  }
+
+  static T get(const pbuf_type* pRoot, size_t starting_bit, size_t buf_bytes) {
+    if (use_pext(starting_bit) && Portable::fits_word(starting_bit, buf_bytes)) {
+      return get_pext(pRoot, starting_bit);
+    }
+    return Portable::get(pRoot, starting_bit, buf_bytes);
+  }
+
+  static void set(pbuf_type* pData, size_t starting_bit, T x) {
+    if (VSTRUCT_SLACK_PADDED_BUFFER && use_pext(starting_bit)) {
+      set_pext(pData, starting_bit, x);
+    } else {
+      Portable::set(pData, starting_bit, x);
+    }
+  }
+
+  static void set(pbuf_type* pData, size_t starting_bit, T x, size_t buf_bytes) {
+    if (use_pext(starting_bit) && Portable::fits_word(starting_bit, buf_bytes)) {
+      set_pext(pData, starting_bit, x);
+    } else {
+      Portable::set(pData, starting_bit, x, buf_bytes);
+    }
+  }
+
+  // true if the cpu supports BMI2 and the field is inside a single word
+  static bool use_pext(size_t starting_bit) {
+    return VSTRUCT_X86_BMI2 && ((starting_bit & 0x7) + Sz <= WordAccess::nbits) && CpuFeatures::get().bmi2;
+  }
+
+#if VSTRUCT_X86_BMI2
+  VSTRUCT_TARGET("bmi2") static T get_pext(const pbuf_type* pRoot, size_t starting_bit) {
+    uint64_t word_mask = static_cast<uint64_t>(Portable::mask) << (starting_bit & 0x7);
+    return static_cast<T>(_pext_u64(WordAccess::load(&pRoot[starting_bit >> 3]), word_mask));
+  }
+
+  VSTRUCT_TARGET("bmi2") static void set_pext(pbuf_type* pData, size_t starting_bit, T x) {
+    uint64_t word_mask = static_cast<uint64_t>(Portable::mask) << (starting_bit & 0x7);
+    uint64_t word = WordAccess::load(&pData[starting_bit >> 3]);
+    word = (word & ~word_mask) | _pdep_u64(static_cast<uint64_t>(x), word_mask);
+    WordAccess::store(&pData[starting_bit >> 3], word);
+  }
+#else
+  static T get_pext(const pbuf_type* pRoot, size_t starting_bit) {
+    return Portable::get_word(pRoot, starting_bit);
+  }
+
+  static void set_pext(pbuf_type* pData, size_t starting_bit, T x) {
+    Portable::set_word(pData, starting_bit, x);
+  }
+#endif
+};
+
+/// Packer - pack value including sign bits
+template <typename T, size_t Sz>
+struct Packer {
+  typedef typename std::conditional<std::is_signed<T>::value && !std::is_floating_point<T>::value,
+                                    typename std::make_unsigned<T>::type, T>::type packedT;
+  // pack
+  static packedT pack(T x) {
+    packedT max_val = static_cast<packedT>(MaskMax<T, Sz>::value);
+    packedT min_val = ~max_val;
+    packedT mask = MaskMax<packedT, Sz>::value;
+
+    if (std::is_floating_point<T>::value) {
+      // dont touch the floating point
+    } else if (x > static_cast<T>(max_val)) {
+      x = max_val;
+    } else if (std::is_signed<T>::value && (x < static_cast<T>(min_val))) {
+      x = min_val;
+    }
+    return static_cast<packedT>(x) & mask;
+  }
+
+  // true if pack clips x to the maximum or minimum value
+  static bool saturates(T x) {
+    packedT max_val = static_cast<packedT>(MaskMax<T, Sz>::value);
+    packedT min_val = ~max_val;
+    return !std::is_floating_point<T>::value &&
+           ((x > static_cast<T>(max_val)) || (std::is_signed<T>::value && (x < static_cast<T>(min_val))));
+  }
+
+  // unpack
+  static T unpack(packedT x) {
+    packedT max_val = static_cast<packedT>(MaskMax<T, Sz>::value);
+    packedT min_val = ~max_val;
+    packedT mask = MaskMax<packedT, Sz>::value;
+    x &= mask;
+    if (std::is_floating_point<T>::value) {
+      // dont touch the floating point
+    } else if (std::is_signed<T>::value && !std::is_floating_point<T>::value && (min_val & x)) {
+      x |= min_val;
+    }
+    return static_cast<T>(x);
+  }
+};
+
+/// TypeBase - all type objects should derive from this
+template <size_t param_bits, size_t param_Sz, size_t param_N>
+struct TypeBaseFunctions {
+  enum : size_t {
+    bits = param_bits,  // first bit position
+    Sz = param_Sz,
+    N = param_N,
+    B = bits >> 3,  // first Byte position
+    b = bits & 0x7u,  // bit offset
+
+    first_byte = B,
+    first_bit = bits,
+    byte_size = (Sz * N + 7) >> 3,
+    bit_size = Sz * N,
+    next_bit = bits + (Sz * N),  // for next Item
+    prev_bytes = (bits + 7) >> 3,  // total bytes up to previous (excluding this)
+    total_bytes = (bits + (Sz * N)  + 7) >> 3  // total bytes up to this (including this)
+  };
+ protected:
+  ~TypeBaseFunctions(){}
+};
+
+template <typename T, size_t bits, size_t Sz, size_t N>
+struct TypeBase : public TypeBaseFunctions<bits, Sz, N>{
+  typedef T unpackedT;
+  typedef typename Packer<T, Sz>::packedT packedT;
+ protected:
+  ~TypeBase(){}
+};
+
+// specialization for bool
+template <size_t bits, size_t Sz, size_t N>
+struct TypeBase <bool, bits, Sz, N> : public TypeBaseFunctions<bits, Sz, N>{
+  typedef bool unpackedT;
+ protected:
+  ~TypeBase(){}
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Packer Specialization
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <size_t Sz>  // specialization for float type
+struct Packer<float, Sz> {
+  static_assert(Sz == 32, "Size must be 32bits for float type");
+  typedef uint32_t packedT;
+  static float unpack(packedT x) {
+    packedT* p = &x;
+    return *(reinterpret_cast<float*>(p));
+  }
+  static packedT pack(float x) {
+    float* p = &x;
+    return *(reinterpret_cast<packedT*>(p));
+  }
+  static bool saturates(float) {
+    return false;
+  }
+};
+
+
+template <size_t Sz>  // specialization for double type
+struct Packer<double, Sz> {
+  static_assert(Sz == 64, "Size must be 64bits for double type");
+  typedef uint64_t packedT;
+  static double unpack(packedT x) {
+    packedT* p = &x;
+    return *(reinterpret_cast<double*>(p));
+  }
+  static packedT pack(double x) {
+    double* p = &x;
+    return *(reinterpret_cast<packedT*>(p));
+  }
+  static bool saturates(double) {
+    return false;
+  }
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Bit streams
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// BitWriter - append bit fields to a buffer in little endian order
+/// Bits are collected in a 64 bit accumulator and stored a whole word at a time. The bits before
+/// the starting bit are kept, flush() writes the remaining bits and keeps the bits after the last field.
+struct BitWriter final {
+  pbuf_type* p_;
+  uint64_t acc_;
+  size_t acc_bits_;  // valid bits in acc_
+
+  BitWriter(pbuf_type* pData, size_t starting_bit)
+  : p_(pData + (starting_bit >> 3)),
+    acc_(0),
+    acc_bits_(starting_bit & 0x7) {
+    if (acc_bits_ > 0) {  // keep bits before the first field
+      acc_ = *p_ & static_cast<pbuf_type>((1u << acc_bits_) - 1);
+    }
+  }
+
+  // x must not have bits set above nbits, nbits is 1 to 64
+  void put(uint64_t x, size_t nbits) {
+    acc_ |= x << acc_bits_;
+    acc_bits_ += nbits;
+    if (acc_bits_ >= WordAccess::nbits) {
+      WordAccess::store(p_, acc_);
+      p_ += WordAccess::nbytes;
+      acc_bits_ -= WordAccess::nbits;
+      acc_ = (acc_bits_ > 0) ? x >> (nbits - acc_bits_) : 0;
+    }
+  }
+
+  void flush() {
+    for (; acc_bits_ >= 8; acc_bits_ -= 8) {  // whole bytes left
+      *p_++ = static_cast<pbuf_type>(acc_);
+      acc_ >>= 8;
+    }
+    if (acc_bits_ > 0) {  // keep bits after the last field
+      pbuf_type byte_mask = static_cast<pbuf_type>((1u << acc_bits_) - 1);
+      *p_ = (*p_ & ~byte_mask) | (static_cast<pbuf_type>(acc_) & byte_mask);
+      acc_bits_ = 0;
+      acc_ = 0;
+    }
+  }
+};
+
+/// BitReader - read consecutive bit fields from a buffer in little endian order
+/// Every read is a single word load, the buffer must have vstruct::slack_bytes after the last field.
+struct BitReader final {
+  const pbuf_type* pData_;
+  size_t bit_;  // next bit to read
+
+  BitReader(const pbuf_type* pData, size_t starting_bit): pData_(pData), bit_(starting_bit) {}
+
+  // nbits is 1 to 64
+  uint64_t get(size_t nbits) {
+    size_t offset_byte = bit_ >> 3;
+    size_t offset_bit = bit_ & 0x7;
+    uint64_t x = WordAccess::load(&pData_[offset_byte]) >> offset_bit;
+    if (offset_bit + nbits > WordAccess::nbits) {
+      x |= static_cast<uint64_t>(pData_[offset_byte + WordAccess::nbytes]) << (WordAccess::nbits - offset_bit);
+    }
+    bit_ += nbits;
+    return (nbits < WordAccess::nbits) ? x & ((uint64_t{1} << nbits) - 1) : x;
+  }
+
+  void skip(size_t nbits) {
+    bit_ += nbits;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Bool array words
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// BoolArrayWords - access a bool array 64 elements at a time
+/// Word w holds elements 64 * w to 64 * w + 63, element i in bit i % 64.
+/// The last word only holds the remaining N % 64 elements, its upper bits read as 0 and are never written.
+/// pData points to the first byte of the array, b is the bit offset of element 0 in that byte.
+template <size_t b, size_t N>
+struct BoolArrayWords {
+  enum : size_t {
+    full_words = N >> 6,
+    tail_bits = N & 63,
+    words = full_words + ((tail_bits != 0) ? 1 : 0),
+    buf_bytes = (b + N + 7) >> 3  // bytes from pData to the end of the array
+  };
+  using Full = LEOrder<uint64_t, 64>;
+  using Tail = LEOrder<uint64_t, (tail_bits != 0) ? size_t(tail_bits) : size_t(1)>;
+
+  // valid bits of word w
+  static uint64_t mask(size_t w) {
+    return (w < full_words) ? ~uint64_t{0} : static_cast<uint64_t>(Tail::mask);
+  }
+
+  static uint64_t load(const pbuf_type* pData, size_t w) {
+    if (w < full_words) {
+      return Full::get(pData, b + (w << 6), buf_bytes);
+    }
+    return Tail::get(pData, b + (w << 6), buf_bytes);
+  }
+
+  static void store(pbuf_type* pData, size_t w, uint64_t x) {
+    if (w < full_words) {
+      Full::set(pData, b + (w << 6), x, buf_bytes);
+    } else {
+      Tail::set(pData, b + (w << 6), x, buf_bytes);
+    }
+  }
+
+  static size_t count(const pbuf_type* pData) {
+    size_t total = 0;
+    for (size_t w = 0; w < words; w++) {
+      total += __builtin_popcountll(load(pData, w));
+    }
+    return total;
+  }
+
+  static bool any(const pbuf_type* pData) {
+    for (size_t w = 0; w < words; w++) {
+      if (load(pData, w) != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static bool all(const pbuf_type* pData) {
+    for (size_t w = 0; w < words; w++) {
+      if (load(pData, w) != mask(w)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // index of the first element from start onwards equal to value, N if there is none
+  static size_t find_from(const pbuf_type* pData, size_t start, bool value) {
+    if (start >= N) {
+      return N;
+    }
+    uint64_t flip = value ? 0 : ~uint64_t{0};
+    size_t w = start >> 6;
+    uint64_t x = ((load(pData, w) ^ flip) & mask(w)) & (~uint64_t{0} << (start & 63));
+    while (x == 0) {
+      if (++w >= words) {
+        return N;
+      }
+      x = (load(pData, w) ^ flip) & mask(w);
+    }
+    return (w << 6) + __builtin_ctzll(x);
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Temporary Objects
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Temporary object created when Array index is accessed.
+template<typename T, size_t Sz>
+struct LEArrayTemp {
+  pbuf_type* pData_;
+  const size_t first_bit_;
+  const size_t buf_bytes_;  // bytes from pData_ to the end of the array
+  using Packer_ = Packer<T, Sz>;
+  typedef typename Packer_::packedT packedT;
+  using LEOrder_ = typename std::conditional<VSTRUCT_LEORDER_PEXT,
+                                             LEOrderPext<packedT, Sz>, LEOrder<packedT, Sz>>::type;
+
+  LEArrayTemp(pbuf_type* pData, size_t first_bit, size_t buf_bytes)
+  : pData_(pData), first_bit_(first_bit), buf_bytes_(buf_bytes) {
+  }
+
+  // getter
+  operator T () const {
+    return get(pData_, first_bit_, buf_bytes_);
+  }
+
+  // value of the element at first_bit, for read only buffers
+  static T get(const pbuf_type* pData, size_t first_bit, size_t buf_bytes) {
+    return Packer_::unpack(LEOrder_::get(pData, first_bit, buf_bytes));
+  }
+
+  // setter
+  LEArrayTemp<T, Sz>& operator= (const T& value) {
+    LEOrder_::set(pData_, first_bit_, Packer_::pack(value), buf_bytes_);
+    return *this;
+  }
+
+  LEArrayTemp<T, Sz>& operator= (const LEArrayTemp& other) {  // copies the value, not the position
+    return *this = static_cast<T>(other);
+  }
+
+  // swap the values of two elements, used by std::iter_swap
+  friend void swap(LEArrayTemp a, LEArrayTemp b) {
+    T temp = a;
+    a = static_cast<T>(b);
+    b = temp;
+  }
+};
+
+
+/// Temporary object created when a big endian Array index is accessed.
+template<typename T, size_t Sz>
+struct BEArrayTemp {
+  pbuf_type* pData_;
+  const size_t first_bit_;
+  const size_t buf_bytes_;  // bytes from pData_ to the end of the array
+  using Packer_ = Packer<T, Sz>;
+  typedef typename Packer_::packedT packedT;
+
+  BEArrayTemp(pbuf_type* pData, size_t first_bit, size_t buf_bytes)
+  : pData_(pData), first_bit_(first_bit), buf_bytes_(buf_bytes) {
+  }
+
+  operator T () const {
+    return get(pData_, first_bit_, buf_bytes_);
+  }
+
+  static T get(const pbuf_type* pData, size_t first_bit, size_t buf_bytes) {
+    return Packer_::unpack(BEOrder<packedT, Sz>::get(pData, first_bit, buf_bytes));
+  }
+
+  BEArrayTemp<T, Sz>& operator= (const T& value) {
+    BEOrder<packedT, Sz>::set(pData_, first_bit_, Packer_::pack(value), buf_bytes_);
+    return *this;
+  }
+
+  BEArrayTemp<T, Sz>& operator= (const BEArrayTemp& other) {  // copies the value, not the position
+    return *this = static_cast<T>(other);
+  }
+
+  friend void swap(BEArrayTemp a, BEArrayTemp b) {
+    T temp = a;
+    a = static_cast<T>(b);
+    b = temp;
+  }
+};
+
+/// Temporary object created when BoolArray index is accessed.
+template<size_t offset, size_t N>
+struct BoolArrayTemp {
+  pbuf_type* const pData_;
+  const size_t index_;
+
+  // Google Style-guide disallows non-const reference for API, we need this
+  // NOLINTNEXTLINE(runtime/references)
+  BoolArrayTemp(pbuf_type* pbuf, size_t index):
+    pData_(pbuf),
+    index_(index) {
+    assert(index < N && "Index is out of bounds!");
+  }
+  operator bool () const {
+    return get(pData_, index_);
+  }
+
+  // value of element index, for read only buffers
+  static bool get(const pbuf_type* pData, size_t index) {
+    assert(index < N && "Index is out of bounds!");
+    size_t B_ = (offset + index) >> 3;
+    size_t b_ = (offset + index) & 0x7;
+    return static_cast<bool>(pData[B_] & (1u << b_));
+  }
+
+  BoolArrayTemp& operator= (const bool& value) {
+    size_t B_ = (offset + index_) >> 3;
+    size_t b_ = (offset + index_) & 0x7;
+    if (value) {
+      pData_[B_] |= (1u << b_);
+    } else {
+      pData_[B_] &= ~(1u << b_);
+    }
+    return *this;
+  }
+
+  BoolArrayTemp& operator= (const BoolArrayTemp& other) {  // copies the value, not the position
+    return *this = static_cast<bool>(other);
+  }
+
+  // swap the values of two elements, used by std::iter_swap
+  friend void swap(BoolArrayTemp a, BoolArrayTemp b) {
+    bool temp = a;
+    a = static_cast<bool>(b);
+    b = temp;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Array Iterators
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// ArrayIteratorBase - index arithmetic and comparisons shared by the array iterators
+template<typename Derived>
+class ArrayIteratorBase {
+ public:
+  typedef std::random_access_iterator_tag iterator_category;
+  typedef ptrdiff_t difference_type;
+
+  size_t index() const {
+    return index_;
+  }
+
+  Derived& operator+=(difference_type n) {
+    index_ += n;
+    return self();
+  }
+  Derived& operator-=(difference_type n) {
+    index_ -= n;
+    return self();
+  }
+  Derived& operator++() {
+    return self() += 1;
+  }
+  Derived& operator--() {
+    return self() -= 1;
+  }
+  Derived operator++(int) {
+    Derived temp = self();
+    self() += 1;
+    return temp;
+  }
+  Derived operator--(int) {
+    Derived temp = self();
+    self() -= 1;
+    return temp;
+  }
+  Derived operator+(difference_type n) const {
+    Derived temp = self();
+    return temp += n;
+  }
+  Derived operator-(difference_type n) const {
+    Derived temp = self();
+    return temp -= n;
+  }
+  friend Derived operator+(difference_type n, const Derived& it) {
+    return it + n;
+  }
+  difference_type operator-(const ArrayIteratorBase& other) const {
+    return static_cast<difference_type>(index_) - static_cast<difference_type>(other.index_);
+  }
+
+  bool operator==(const ArrayIteratorBase& other) const {
+    return index_ == other.index_;
+  }
+  bool operator!=(const ArrayIteratorBase& other) const {
+    return index_ != other.index_;
+  }
+  bool operator<(const ArrayIteratorBase& other) const {
+    return index_ < other.index_;
+  }
+  bool operator>(const ArrayIteratorBase& other) const {
+    return index_ > other.index_;
+  }
+  bool operator<=(const ArrayIteratorBase& other) const {
+    return index_ <= other.index_;
+  }
+  bool operator>=(const ArrayIteratorBase& other) const {
+    return index_ >= other.index_;
+  }
+
+ protected:
+  explicit ArrayIteratorBase(size_t index): index_(index) {}
+
+  Derived& self() {
+    return static_cast<Derived&>(*this);
+  }
+  const Derived& self() const {
+    return static_cast<const Derived&>(*this);
+  }
+
+  size_t index_;
+};
+
+/// LEArrayConstIterator - iterator over the values of an array
+/// The word loaded for an element is kept, following elements within the word are read without a load.
+template<typename T, size_t Sz>
+class LEArrayConstIterator : public ArrayIteratorBase<LEArrayConstIterator<T, Sz>> {
+ public:
+  typedef T value_type;
+  typedef const T* pointer;
+  typedef T reference;
+  using Packer_ = Packer<T, Sz>;
+  typedef typename Packer_::packedT packedT;
+  enum : size_t {
+    cached = (Sz <= WordAccess::nbits - 7)  // element is within the word loaded from its first byte
+  };
+  enum : uint64_t {
+    mask = MaskMax<uint64_t, Sz>::value
+  };
+
+  LEArrayConstIterator(): LEArrayConstIterator(nullptr, 0, 0, 0) {}
+
+  // pData is the first byte of the array, first_bit the bit of element 0 in that byte
+  LEArrayConstIterator(const pbuf_type* pData, size_t first_bit, size_t buf_bytes, size_t index)
+  : ArrayIteratorBase<LEArrayConstIterator>(index),
+    pData_(pData), first_bit_(first_bit), buf_bytes_(buf_bytes), word_bit_(~size_t{0}), word_(0) {
+  }
+
+  T operator*() const {
+    size_t bit = first_bit_ + this->index_ * Sz;
+    if (!cached) {
+      return Packer_::unpack(LEOrder<packedT, Sz>::get(pData_, bit, buf_bytes_));
+    }
+    if ((bit < word_bit_) || (bit + Sz > word_bit_ + WordAccess::nbits)) {
+      load(bit >> 3);
+    }
+    return Packer_::unpack(static_cast<packedT>((word_ >> (bit - word_bit_)) & mask));
+  }
+
+  T operator[](ptrdiff_t n) const {
+    return *(*this + n);
+  }
+
+ private:
+  // load the word starting at byte, bytes after the end of the array read as 0
+  void load(size_t byte) const {
+    word_bit_ = byte << 3;
+    if (VSTRUCT_SLACK_PADDED_BUFFER || (byte + WordAccess::nbytes <= buf_bytes_)) {
+      word_ = WordAccess::load(&pData_[byte]);
+      return;
+    }
+    word_ = 0;
+    for (size_t i = 0; byte + i < buf_bytes_; i++) {
+      word_ |= static_cast<uint64_t>(pData_[byte + i]) << (i << 3);
+    }
+  }
+
+  const pbuf_type* pData_;
+  size_t first_bit_;
+  size_t buf_bytes_;  // bytes from pData_ to the end of the array
+  mutable size_t word_bit_;  // bit of the first bit of word_
+  mutable uint64_t word_;
+};
+
+/// LEArrayIterator - iterator over the elements of an array, dereferences to a temporary object
+template<typename T, size_t Sz>
+class LEArrayIterator : public ArrayIteratorBase<LEArrayIterator<T, Sz>> {
+ public:
+  typedef T value_type;
+  typedef void pointer;
+  typedef LEArrayTemp<T, Sz> reference;
+
+  LEArrayIterator(): LEArrayIterator(nullptr, 0, 0, 0) {}
+
+  LEArrayIterator(pbuf_type* pData, size_t first_bit, size_t buf_bytes, size_t index)
+  : ArrayIteratorBase<LEArrayIterator>(index), pData_(pData), first_bit_(first_bit), buf_bytes_(buf_bytes) {
+  }
+
+  reference operator*() const {
+    return reference{pData_, first_bit_ + this->index_ * Sz, buf_bytes_};
+  }
+
+  reference operator[](ptrdiff_t n) const {
+    return *(*this + n);
+  }
+
+  operator LEArrayConstIterator<T, Sz>() const {
+    return LEArrayConstIterator<T, Sz>(pData_, first_bit_, buf_bytes_, this->index_);
+  }
+
+ private:
+  pbuf_type* pData_;
+  size_t first_bit_;
+  size_t buf_bytes_;
+};
+
+/// BEArrayConstIterator - iterator over the values of a big endian array
+template<typename T, size_t Sz>
+class BEArrayConstIterator : public ArrayIteratorBase<BEArrayConstIterator<T, Sz>> {
+ public:
+  typedef T value_type;
+  typedef const T* pointer;
+  typedef T reference;
+
+  BEArrayConstIterator(): BEArrayConstIterator(nullptr, 0, 0, 0) {}
+
+  BEArrayConstIterator(const pbuf_type* pData, size_t first_bit, size_t buf_bytes, size_t index)
+  : ArrayIteratorBase<BEArrayConstIterator>(index), pData_(pData), first_bit_(first_bit), buf_bytes_(buf_bytes) {
+  }
+
+  T operator*() const {
+    return BEArrayTemp<T, Sz>::get(pData_, first_bit_ + this->index_ * Sz, buf_bytes_);
+  }
+
+  T operator[](ptrdiff_t n) const {
+    return *(*this + n);
+  }
+
+ private:
+  const pbuf_type* pData_;
+  size_t first_bit_;
+  size_t buf_bytes_;
+};
+
+/// BEArrayIterator - iterator over the elements of a big endian array, dereferences to a temporary object
+template<typename T, size_t Sz>
+class BEArrayIterator : public ArrayIteratorBase<BEArrayIterator<T, Sz>> {
+ public:
+  typedef T value_type;
+  typedef void pointer;
+  typedef BEArrayTemp<T, Sz> reference;
+
+  BEArrayIterator(): BEArrayIterator(nullptr, 0, 0, 0) {}
+
+  BEArrayIterator(pbuf_type* pData, size_t first_bit, size_t buf_bytes, size_t index)
+  : ArrayIteratorBase<BEArrayIterator>(index), pData_(pData), first_bit_(first_bit), buf_bytes_(buf_bytes) {
+  }
+
+  reference operator*() const {
+    return reference{pData_, first_bit_ + this->index_ * Sz, buf_bytes_};
+  }
+
+  reference operator[](ptrdiff_t n) const {
+    return *(*this + n);
+  }
+
+  operator BEArrayConstIterator<T, Sz>() const {
+    return BEArrayConstIterator<T, Sz>(pData_, first_bit_, buf_bytes_, this->index_);
+  }
+
+ private:
+  pbuf_type* pData_;
+  size_t first_bit_;
+  size_t buf_bytes_;
+};
+
+/// BoolArrayConstIterator - iterator over the values of a bool array, keeps the current 64 element word
+template<size_t offset, size_t N>
+class BoolArrayConstIterator : public ArrayIteratorBase<BoolArrayConstIterator<offset, N>> {
+ public:
+  typedef bool value_type;
+  typedef const bool* pointer;
+  typedef bool reference;
+  using Words = BoolArrayWords<offset, N>;
+
+  BoolArrayConstIterator(): BoolArrayConstIterator(nullptr, 0) {}
+
+  BoolArrayConstIterator(const pbuf_type* pData, size_t index)
+  : ArrayIteratorBase<BoolArrayConstIterator>(index), pData_(pData), word_index_(~size_t{0}), word_(0) {
+  }
+
+  bool operator*() const {
+    size_t w = this->index_ >> 6;
+    if (w != word_index_) {
+      word_index_ = w;
+      word_ = Words::load(pData_, w);
+    }
+    return (word_ >> (this->index_ & 63)) & 1;
+  }
+
+  bool operator[](ptrdiff_t n) const {
+    return *(*this + n);
+  }
+
+ private:
+  const pbuf_type* pData_;
+  mutable size_t word_index_;
+  mutable uint64_t word_;
+};
+
+/// BoolArrayIterator - iterator over the elements of a bool array, dereferences to a temporary object
+template<size_t offset, size_t N>
+class BoolArrayIterator : public ArrayIteratorBase<BoolArrayIterator<offset, N>> {
+ public:
+  typedef bool value_type;
+  typedef void pointer;
+  typedef BoolArrayTemp<offset, N> reference;
+
+  BoolArrayIterator(): BoolArrayIterator(nullptr, 0) {}
+
+  BoolArrayIterator(pbuf_type* pData, size_t index): ArrayIteratorBase<BoolArrayIterator>(index), pData_(pData) {}
+
+  reference operator*() const {
+    return reference{pData_, this->index_};
+  }
+
+  reference operator[](ptrdiff_t n) const {
+    return *(*this + n);
+  }
+
+  operator BoolArrayConstIterator<offset, N>() const {
+    return BoolArrayConstIterator<offset, N>(pData_, this->index_);
+  }
+
+ private:
+  pbuf_type* pData_;
+};
+
+
+
+/// LEArrayElement - result of indexing an array, a temporary object or the value for read only buffers
+template<typename T, size_t Sz, bool read_only>
+struct LEArrayElement {
+  typedef LEArrayTemp<T, Sz> type;
+  typedef LEArrayIterator<T, Sz> iterator;
+  static type make(pbuf_type* pData, size_t first_bit, size_t buf_bytes) {
+    return type{pData, first_bit, buf_bytes};
+  }
+};
+
+template<typename T, size_t Sz>
+struct LEArrayElement<T, Sz, true> {
+  typedef T type;
+  typedef LEArrayConstIterator<T, Sz> iterator;
+  static type make(const pbuf_type* pData, size_t first_bit, size_t buf_bytes) {
+    return LEArrayTemp<T, Sz>::get(pData, first_bit, buf_bytes);
+  }
+};
+
+/// BEArrayElement - result of indexing a big endian array, a temporary object or the value for read only buffers
+template<typename T, size_t Sz, bool read_only>
+struct BEArrayElement {
+  typedef BEArrayTemp<T, Sz> type;
+  typedef BEArrayIterator<T, Sz> iterator;
+  static type make(pbuf_type* pData, size_t first_bit, size_t buf_bytes) {
+    return type{pData, first_bit, buf_bytes};
+  }
+};
+
+template<typename T, size_t Sz>
+struct BEArrayElement<T, Sz, true> {
+  typedef T type;
+  typedef BEArrayConstIterator<T, Sz> iterator;
+  static type make(const pbuf_type* pData, size_t first_bit, size_t buf_bytes) {
+    return BEArrayTemp<T, Sz>::get(pData, first_bit, buf_bytes);
+  }
+};
+
+/// BoolArrayElement - result of indexing a bool array, a temporary object or the value for read only buffers
+template<size_t offset, size_t N, bool read_only>
+struct BoolArrayElement {
+  typedef BoolArrayTemp<offset, N> type;
+  typedef BoolArrayIterator<offset, N> iterator;
+  static type make(pbuf_type* pData, size_t index) {
+    return type{pData, index};
+  }
+};
+
+template<size_t offset, size_t N>
+struct BoolArrayElement<offset, N, true> {
+  typedef bool type;
+  typedef BoolArrayConstIterator<offset, N> iterator;
+  static type make(const pbuf_type* pData, size_t index) {
+    return BoolArrayTemp<offset, N>::get(pData, index);
+  }
+};
+
+}  // namespace internals
+}  // namespace vstruct
+
+
+
+#endif  // VSTRUCT_INTERNALS_H_
+
@@ -1,220 +1,619 @@
-// todo: some copyright here
-//
-// xvstruct.h
-//
-//
-// todo: description here
-//
-
-#ifndef VSTRUCT_ITEMTYPES_H_
-#define VSTRUCT_ITEMTYPES_H_
-
-
-#include <stdint.h>
-#include "./internals.h"
-
-
-namespace vstruct {
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// Type generator for different types, byte position is inferred from Prev type
-/// Template args:
-///   Prev: type of the previous object. for first item use Root
-///   T: Storage Type
-///   Sz: Number of storage bits
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-template<typename Prev, typename T, size_t Sz>
-struct LEItem;  // type generator for Little Endian items
-
-template<typename Prev, typename T, size_t Sz, size_t N>
-struct LEArray;  // type generator for  Little Endian Arrays
-
-template<typename Prev>
-struct BoolItem;  // type generator for single bool
-
-template<typename Prev, size_t N>
-struct BoolArray;  // type generator for bool Arrays
-
-template<typename Prev, size_t AlignByte>
-struct AlignPad;  // type generator for byte alignment
-
-struct Root;  // root item for first to attach
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// Actual Type declarations
-/// Template args:
-///   T: Storage Type
-///   bits: first bit position
-///   Sz: Number of storage bits
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-template<typename T, size_t bits, size_t Sz>
-struct LEItemType;  // storage type for Little Endian items
-
-template<typename T, size_t bits, size_t Sz, size_t N>
-struct LEArrayType;  // storage type for Little Endian Arrays
-
-template<size_t bits>
-struct BoolItemType;  // storage type for single bool
-
-template<size_t bits, size_t N>
-struct BoolArrayType;  // storage type for bool Arrays
-
-template<size_t bits, size_t AlignByte>
-struct AlignPadType;  // dummy storage for byte alignment
-
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// Vstruct declaration is needed as we want to attach to the base
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-struct VStruct{
- public:
-  pbuf_type* internal_buf_;
-  pbuf_type* getBuffer() {
-    return internal_buf_;
-  }
-  void setBuffer(pbuf_type* pBuffer) {
-    internal_buf_ = pBuffer;
-  }
-};
-
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// Little Endian Integer / Float
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-template<typename T, size_t bits, size_t Sz>
-struct LEItemType final : public internals::TypeBase<T, bits, Sz, 1> {
-  static_assert(!std::is_base_of<bool, T>::value, "bool type is not allowed, use BoolItem instead");
-  static_assert(!std::is_floating_point<T>::value ||(std::is_floating_point<T>::value && (Sz == (sizeof(T) << 3))),
-                "No compression allowed for floating point types, Sz must match floating point sizeof");
-  static_assert(Sz > 0, "Size must be 1 or more");
-  static_assert(Sz <= 64, "Maximum 64bit _ItemBase supported");
-  static_assert(Sz <= 8 * sizeof(T), "Bit packed _ItemBase should be equal or less than Raw _ItemBase");
-
-  pbuf_type* &pbuf_;
-  // Google Style-guide disallows non-const reference for API, we need this
-  // NOLINTNEXTLINE(runtime/references)
-  explicit LEItemType(pbuf_type* &pbuf): pbuf_(pbuf) {}
-  // NOLINTNEXTLINE(runtime/references)
-  explicit LEItemType(VStruct &baseStruct): pbuf_(baseStruct.internal_buf_) {}
-
-  operator T() const {  // getter
-      return internals::Packer<T, Sz>::unpack(
-               internals::LEOrder<typename LEItemType::packedT, Sz>::get(pbuf_, bits));
-  }
-
-  LEItemType<T, LEItemType::b, Sz>& operator= (const T& value) {  // setter
-      internals::LEOrder<typename LEItemType::packedT, Sz>::set(
-        pbuf_, bits, internals::Packer<T, Sz>::pack(value));
-  }
-};
-
-template<typename T, size_t bits, size_t Sz, size_t N>
-struct LEArrayType final : public internals::TypeBase<T, bits, Sz, N> {
-  static_assert(!std::is_base_of<T, bool>::value, "bool type is not allowed");
-  static_assert(Sz > 0, "Size must be 1 or more");
-  static_assert(Sz <= 64, "Maximum 64bit supported");
-  static_assert(Sz <= 8 * sizeof(T), "Bit packed should be equal or less than original type");
-
-  pbuf_type* &pbuf_;
-  // Google Style-guide disallows non-const reference for API, we need this
-  // NOLINTNEXTLINE(runtime/references)
-  explicit LEArrayType(pbuf_type* &pbuf): pbuf_(pbuf) {}
-  // NOLINTNEXTLINE(runtime/references)
-  explicit LEArrayType(VStruct &baseStruct): pbuf_(baseStruct.internal_buf_) {}
-
-  // index operator is exposed. returns the temporary array object
-  internals::LEArrayTemp<T, Sz> operator[](size_t index) {
-    return internals::LEArrayTemp<T, Sz>{&pbuf_[LEArrayType::B], LEArrayType::bits + index * LEArrayType::Sz};
-  }
-};
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// Bool Types
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-template<size_t bits>
-struct BoolItemType final : public internals::TypeBase<bool, bits, 1, 1> {
-  pbuf_type* &pbuf_;
-  // Google Style-guide disallows non-const reference for API, we need this
-  // NOLINTNEXTLINE(runtime/references)
-  explicit BoolItemType(pbuf_type* &pbuf): pbuf_(pbuf) {}
-  // NOLINTNEXTLINE(runtime/references)
-  explicit BoolItemType(VStruct &baseStruct): pbuf_(baseStruct.internal_buf_) {}
-
-  operator bool () const {
-    return vstruct::internals::ByteAccess<1, BoolItemType::b>::get(&pbuf_[BoolItemType::B]);
-  }
-
-  BoolItemType<BoolItemType::b>& operator= (const bool& value) {
-    vstruct::internals::ByteAccess<1, BoolItemType::b>::set(&pbuf_[BoolItemType::B], static_cast<uint8_t>(value));
-  }
-};
-
-template<size_t bits, size_t N>
-struct BoolArrayType final : public internals::TypeBase<bool, bits, 1, N> {
-  static_assert(N > 0, "Size must be 1 or more");
-  pbuf_type* &pbuf_;
-  // Google Style-guide disallows non-const reference for API, we need this
-  // NOLINTNEXTLINE(runtime/references)
-  explicit BoolArrayType(pbuf_type* &pbuf): pbuf_(pbuf) {}
-  // NOLINTNEXTLINE(runtime/references)
-  explicit BoolArrayType(VStruct &baseStruct): pbuf_(baseStruct.internal_buf_) {}
-
-  internals::BoolArrayTemp<BoolArrayType::b, N> operator[](size_t index) {
-    return internals::BoolArrayTemp<BoolArrayType::b, N>{ &pbuf_[BoolArrayType::B], index};
-  }
-};
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// Padding for alignment
-////////////////////////////////////////////////////////////////////////////////////////////////////////
-template<size_t bits, size_t AlignByte>
-struct AlignPadType final {
-  static_assert(AlignByte <= 8, "Maximum 8 byte allignment allowed");
-  enum : size_t {
-    misalignment = (bits % (AlignByte * 8)),
-    next_bit = (misalignment > 0) ? bits + ((AlignByte * 8) - misalignment): bits
-  };
-  explicit AlignPadType(){}
-};
-
-template<typename Prev, typename T, size_t Sz>
-struct LEItem {
-  using type = LEItemType<T, Prev::next_bit, Sz>;
-  LEItem() = delete;
-};
-
-template<typename Prev, typename T, size_t Sz, size_t N>
-struct LEArray {
-  using type = LEArrayType<T, Prev::next_bit, Sz, N>;
-  LEArray() = delete;
-};
-
-template<typename Prev>
-struct BoolItem {
-  using type = BoolItemType<Prev::next_bit>;
-  BoolItem() = delete;
-};
-
-template<typename Prev, size_t N>
-struct BoolArray{
-  using type = BoolArrayType<Prev::next_bit, N>;
-  BoolArray() = delete;
-};
-
-template<typename Prev, size_t AlignByte>
-struct AlignPad{
-  using type = AlignPadType<Prev::next_bit, AlignByte>;
-};
-
-struct Root final {
-  enum : size_t {
-    next_bit = 0
-  };
-  Root() = delete;
-};
-
-
-
-}  // namespace vstruct
-
-
-#endif  // VSTRUCT_ITEMTYPES_H_
+// todo: some copyright here
+//
+// xvstruct.h
+//
+//
+// todo: description here
+//
+
+#ifndef VSTRUCT_ITEMTYPES_H_
+#define VSTRUCT_ITEMTYPES_H_
+
+
+#include <stdint.h>
+#include "./internals.h"
+#include "./bulk.h"
+
+
+namespace vstruct {
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Type generator for different types, byte position is inferred from Prev type
+/// Template args:
+///   Prev: type of the previous object. for first item use Root
+///   T: Storage Type
+///   Sz: Number of storage bits
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename Prev, typename T, size_t Sz>
+struct LEItem;  // type generator for Little Endian items
+
+template<typename Prev, typename T, size_t Sz, size_t N>
+struct LEArray;  // type generator for  Little Endian Arrays
+
+template<typename Prev>
+struct BoolItem;  // type generator for single bool
+
+template<typename Prev, size_t N>
+struct BoolArray;  // type generator for bool Arrays
+
+template<typename Prev, typename T, size_t Sz>
+struct BEItem;  // type generator for Big Endian items
+
+template<typename Prev, typename T, size_t Sz, size_t N>
+struct BEArray;  // type generator for Big Endian Arrays
+
+template<typename Prev, size_t AlignByte>
+struct AlignPad;  // type generator for byte alignment
+
+struct Root;  // root item for first to attach
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Buffer holders, how a storage type finds the buffer
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct BufferRef final {  // reference to the buffer pointer of the owning VStruct, follows setBuffer()
+  typedef pbuf_type* &type;
+  enum : bool { read_only = false };
+  BufferRef() = delete;
+};
+
+struct BufferPtr final {  // copy of the buffer pointer, for the proxies returned by a VStructView
+  typedef pbuf_type* type;
+  enum : bool { read_only = false };
+  BufferPtr() = delete;
+};
+
+struct ConstBufferPtr final {  // copy of a read only buffer pointer, for the proxies returned by a ConstVStructView
+  typedef const pbuf_type* type;
+  enum : bool { read_only = true };
+  ConstBufferPtr() = delete;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Actual Type declarations
+/// Template args:
+///   T: Storage Type
+///   bits: first bit position
+///   Sz: Number of storage bits
+///   Holder: BufferRef, BufferPtr or ConstBufferPtr
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename T, size_t bits, size_t Sz, typename Holder = BufferRef>
+struct LEItemType;  // storage type for Little Endian items
+
+template<typename T, size_t bits, size_t Sz, size_t N, typename Holder = BufferRef>
+struct LEArrayType;  // storage type for Little Endian Arrays
+
+template<size_t bits, typename Holder = BufferRef>
+struct BoolItemType;  // storage type for single bool
+
+template<size_t bits, size_t N, typename Holder = BufferRef>
+struct BoolArrayType;  // storage type for bool Arrays
+
+template<typename T, size_t bits, size_t Sz, typename Holder = BufferRef>
+struct BEItemType;  // storage type for Big Endian items, bits numbered MSB first
+
+template<typename T, size_t bits, size_t Sz, size_t N, typename Holder = BufferRef>
+struct BEArrayType;  // storage type for Big Endian Arrays, bits numbered MSB first
+
+template<size_t bits, size_t AlignByte>
+struct AlignPadType;  // dummy storage for byte alignment
+
+template<typename T, size_t bits, size_t Sz, typename Holder>
+struct IsBigEndian<BEItemType<T, bits, Sz, Holder>> : public std::true_type {};
+
+template<typename T, size_t bits, size_t Sz, size_t N, typename Holder>
+struct IsBigEndian<BEArrayType<T, bits, Sz, N, Holder>> : public std::true_type {};
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Vstruct declaration is needed as we want to attach to the base
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct VStruct{
+ public:
+  pbuf_type* internal_buf_;
+  pbuf_type* getBuffer() {
+    return internal_buf_;
+  }
+  void setBuffer(pbuf_type* pBuffer) {
+    internal_buf_ = pBuffer;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// VStructView - base of the generated views, the buffer pointer is the only member
+/// Fields are accessed through member functions returning BufferPtr proxies,
+/// so a view is trivially copyable and the size of one pointer.
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct VStructView {
+ public:
+  pbuf_type* internal_buf_;
+  VStructView() = default;
+  explicit VStructView(pbuf_type* pBuffer): internal_buf_(pBuffer) {}
+  pbuf_type* getBuffer() const {
+    return internal_buf_;
+  }
+  void setBuffer(pbuf_type* pBuffer) {
+    internal_buf_ = pBuffer;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// ConstVStructView - base of the generated read only views, over a const buffer
+/// Fields are returned as ConstBufferPtr proxies which only have getters, so a layout can be
+/// read in place from a read only mapping or a const network buffer.
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct ConstVStructView {
+ public:
+  const pbuf_type* internal_buf_;
+  ConstVStructView() = default;
+  explicit ConstVStructView(const pbuf_type* pBuffer): internal_buf_(pBuffer) {}
+  ConstVStructView(const VStructView& view): internal_buf_(view.getBuffer()) {}  // NOLINT(runtime/explicit)
+  const pbuf_type* getBuffer() const {
+    return internal_buf_;
+  }
+  void setBuffer(const pbuf_type* pBuffer) {
+    internal_buf_ = pBuffer;
+  }
+};
+
+/// FieldList - storage types of the fields of a generated struct, in declaration order
+template<typename... Fields>
+struct FieldList final {
+  enum : size_t {
+    size = sizeof...(Fields)
+  };
+  FieldList() = delete;
+};
+
+/// WithHolder - the storage type Field with its Holder replaced
+template<typename Field, typename Holder>
+struct WithHolder;
+
+/// ViewField - proxy type returned by a view for the VStruct member type Field
+template<typename Field>
+using ViewField = typename WithHolder<Field, BufferPtr>::type;
+
+/// ConstViewField - read only proxy type returned by a const view for the VStruct member type Field
+template<typename Field>
+using ConstViewField = typename WithHolder<Field, ConstBufferPtr>::type;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Little Endian Integer / Float
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename T, size_t bits, size_t Sz, typename Holder>
+struct LEItemType final : public internals::TypeBase<T, bits, Sz, 1> {
+  static_assert(!std::is_base_of<bool, T>::value, "bool type is not allowed, use BoolItem instead");
+  static_assert(!std::is_floating_point<T>::value ||(std::is_floating_point<T>::value && (Sz == (sizeof(T) << 3))),
+                "No compression allowed for floating point types, Sz must match floating point sizeof");
+  static_assert(Sz > 0, "Size must be 1 or more");
+  static_assert(Sz <= 64, "Maximum 64bit _ItemBase supported");
+  static_assert(Sz <= 8 * sizeof(T), "Bit packed _ItemBase should be equal or less than Raw _ItemBase");
+
+  typename Holder::type pbuf_;
+  // Google Style-guide disallows non-const reference for API, we need this
+  // NOLINTNEXTLINE(runtime/references)
+  explicit LEItemType(typename Holder::type pbuf): pbuf_(pbuf) {}
+  // NOLINTNEXTLINE(runtime/references)
+  explicit LEItemType(VStruct &baseStruct): pbuf_(baseStruct.internal_buf_) {}
+
+  operator T() const {  // getter
+      return internals::Packer<T, Sz>::unpack(
+               internals::LEOrderAt<typename LEItemType::packedT, Sz, bits>::get(pbuf_));
+  }
+
+  LEItemType& operator= (const T& value) {  // setter
+      static_assert(!Holder::read_only, "field of a read only view cannot be written");
+      internals::LEOrderAt<typename LEItemType::packedT, Sz, bits>::set(
+        pbuf_, internals::Packer<T, Sz>::pack(value));
+      return *this;
+  }
+
+  LEItemType& operator= (const LEItemType& other) {  // copies the value, not the buffer
+      return *this = static_cast<T>(other);
+  }
+};
+
+template<typename T, size_t bits, size_t Sz, size_t N, typename Holder>
+struct LEArrayType final : public internals::TypeBase<T, bits, Sz, N> {
+  static_assert(!std::is_base_of<T, bool>::value, "bool type is not allowed");
+  static_assert(Sz > 0, "Size must be 1 or more");
+  static_assert(Sz <= 64, "Maximum 64bit supported");
+  static_assert(Sz <= 8 * sizeof(T), "Bit packed should be equal or less than original type");
+
+  typename Holder::type pbuf_;
+  // Google Style-guide disallows non-const reference for API, we need this
+  // NOLINTNEXTLINE(runtime/references)
+  explicit LEArrayType(typename Holder::type pbuf): pbuf_(pbuf) {}
+  // NOLINTNEXTLINE(runtime/references)
+  explicit LEArrayType(VStruct &baseStruct): pbuf_(baseStruct.internal_buf_) {}
+  LEArrayType(const LEArrayType&) = default;
+  LEArrayType& operator= (const LEArrayType&) = delete;  // would rebind a BufferPtr proxy
+
+  using Element = internals::LEArrayElement<T, Sz, Holder::read_only>;
+
+  // index operator is exposed. returns the temporary array object, or the value for a read only view
+  typename Element::type operator[](size_t index) {
+    return Element::make(
+      &pbuf_[LEArrayType::B], LEArrayType::b + index * LEArrayType::Sz, LEArrayType::total_bytes - LEArrayType::B);
+  }
+
+  T operator[](size_t index) const {
+    return internals::LEArrayTemp<T, Sz>::get(
+      &pbuf_[LEArrayType::B], LEArrayType::b + index * LEArrayType::Sz, LEArrayType::total_bytes - LEArrayType::B);
+  }
+
+  typedef typename Element::iterator iterator;  // const_iterator for a read only view
+  typedef internals::LEArrayConstIterator<T, Sz> const_iterator;
+
+  iterator begin() {
+    return iterator(&pbuf_[LEArrayType::B], LEArrayType::b, LEArrayType::total_bytes - LEArrayType::B, 0);
+  }
+  iterator end() {
+    return iterator(&pbuf_[LEArrayType::B], LEArrayType::b, LEArrayType::total_bytes - LEArrayType::B, N);
+  }
+  const_iterator begin() const {
+    return cbegin();
+  }
+  const_iterator end() const {
+    return cend();
+  }
+  const_iterator cbegin() const {
+    return const_iterator(&pbuf_[LEArrayType::B], LEArrayType::b, LEArrayType::total_bytes - LEArrayType::B, 0);
+  }
+  const_iterator cend() const {
+    return const_iterator(&pbuf_[LEArrayType::B], LEArrayType::b, LEArrayType::total_bytes - LEArrayType::B, N);
+  }
+
+  // decode count elements starting at index first to out, uses simd kernels when supported by the cpu
+  void unpack_to(T* out, size_t first, size_t count) const {
+    assert(first + count <= N && "Index is out of bounds!");
+    internals::LEArrayUnpack<T, Sz, LEArrayType::b>::run(
+      &pbuf_[LEArrayType::B], LEArrayType::total_bytes - LEArrayType::B, first, count, out);
+  }
+
+  // encode count elements from in starting at index first, returns the number of values clipped by saturation
+  size_t pack_from(const T* in, size_t first, size_t count) {
+    static_assert(!Holder::read_only, "field of a read only view cannot be written");
+    assert(first + count <= N && "Index is out of bounds!");
+    return internals::LEArrayPack<T, Sz, LEArrayType::b>::run(&pbuf_[LEArrayType::B], first, count, in);
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Big Endian Integer / Float
+/// The first bit of the field holds the most significant bit of the value, whole bytes are in network order.
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename T, size_t bits, size_t Sz, typename Holder>
+struct BEItemType final : public internals::TypeBase<T, bits, Sz, 1> {
+  static_assert(!std::is_base_of<bool, T>::value, "bool type is not allowed, use BoolItem instead");
+  static_assert(!std::is_floating_point<T>::value ||(std::is_floating_point<T>::value && (Sz == (sizeof(T) << 3))),
+                "No compression allowed for floating point types, Sz must match floating point sizeof");
+  static_assert(Sz > 0, "Size must be 1 or more");
+  static_assert(Sz <= 64, "Maximum 64bit _ItemBase supported");
+  static_assert(Sz <= 8 * sizeof(T), "Bit packed _ItemBase should be equal or less than Raw _ItemBase");
+
+  typename Holder::type pbuf_;
+  // NOLINTNEXTLINE(runtime/references)
+  explicit BEItemType(typename Holder::type pbuf): pbuf_(pbuf) {}
+  // NOLINTNEXTLINE(runtime/references)
+  explicit BEItemType(VStruct &baseStruct): pbuf_(baseStruct.internal_buf_) {}
+
+  operator T() const {  // getter
+      return internals::Packer<T, Sz>::unpack(
+               internals::BEOrderAt<typename BEItemType::packedT, Sz, bits>::get(pbuf_));
+  }
+
+  BEItemType& operator= (const T& value) {  // setter
+      static_assert(!Holder::read_only, "field of a read only view cannot be written");
+      internals::BEOrderAt<typename BEItemType::packedT, Sz, bits>::set(
+        pbuf_, internals::Packer<T, Sz>::pack(value));
+      return *this;
+  }
+
+  BEItemType& operator= (const BEItemType& other) {  // copies the value, not the buffer
+      return *this = static_cast<T>(other);
+  }
+};
+
+template<typename T, size_t bits, size_t Sz, size_t N, typename Holder>
+struct BEArrayType final : public internals::TypeBase<T, bits, Sz, N> {
+  static_assert(!std::is_base_of<T, bool>::value, "bool type is not allowed");
+  static_assert(Sz > 0, "Size must be 1 or more");
+  static_assert(Sz <= 64, "Maximum 64bit supported");
+  static_assert(Sz <= 8 * sizeof(T), "Bit packed should be equal or less than original type");
+
+  typename Holder::type pbuf_;
+  // NOLINTNEXTLINE(runtime/references)
+  explicit BEArrayType(typename Holder::type pbuf): pbuf_(pbuf) {}
+  // NOLINTNEXTLINE(runtime/references)
+  explicit BEArrayType(VStruct &baseStruct): pbuf_(baseStruct.internal_buf_) {}
+  BEArrayType(const BEArrayType&) = default;
+  BEArrayType& operator= (const BEArrayType&) = delete;  // would rebind a BufferPtr proxy
+
+  using Element = internals::BEArrayElement<T, Sz, Holder::read_only>;
+
+  // returns the temporary array object, or the value for a read only view
+  typename Element::type operator[](size_t index) {
+    return Element::make(
+      &pbuf_[BEArrayType::B], BEArrayType::b + index * BEArrayType::Sz, BEArrayType::total_bytes - BEArrayType::B);
+  }
+
+  T operator[](size_t index) const {
+    return internals::BEArrayTemp<T, Sz>::get(
+      &pbuf_[BEArrayType::B], BEArrayType::b + index * BEArrayType::Sz, BEArrayType::total_bytes - BEArrayType::B);
+  }
+
+  typedef typename Element::iterator iterator;  // const_iterator for a read only view
+  typedef internals::BEArrayConstIterator<T, Sz> const_iterator;
+
+  iterator begin() {
+    return iterator(&pbuf_[BEArrayType::B], BEArrayType::b, BEArrayType::total_bytes - BEArrayType::B, 0);
+  }
+  iterator end() {
+    return iterator(&pbuf_[BEArrayType::B], BEArrayType::b, BEArrayType::total_bytes - BEArrayType::B, N);
+  }
+  const_iterator begin() const {
+    return cbegin();
+  }
+  const_iterator end() const {
+    return cend();
+  }
+  const_iterator cbegin() const {
+    return const_iterator(&pbuf_[BEArrayType::B], BEArrayType::b, BEArrayType::total_bytes - BEArrayType::B, 0);
+  }
+  const_iterator cend() const {
+    return const_iterator(&pbuf_[BEArrayType::B], BEArrayType::b, BEArrayType::total_bytes - BEArrayType::B, N);
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Bool Types
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<size_t bits, typename Holder>
+struct BoolItemType final : public internals::TypeBase<bool, bits, 1, 1> {
+  typename Holder::type pbuf_;
+  // Google Style-guide disallows non-const reference for API, we need this
+  // NOLINTNEXTLINE(runtime/references)
+  explicit BoolItemType(typename Holder::type pbuf): pbuf_(pbuf) {}
+  // NOLINTNEXTLINE(runtime/references)
+  explicit BoolItemType(VStruct &baseStruct): pbuf_(baseStruct.internal_buf_) {}
+
+  operator bool () const {
+    return vstruct::internals::ByteAccess<1, BoolItemType::b>::get(&pbuf_[BoolItemType::B]);
+  }
+
+  BoolItemType& operator= (const bool& value) {
+    static_assert(!Holder::read_only, "field of a read only view cannot be written");
+    vstruct::internals::ByteAccess<1, BoolItemType::b>::set(&pbuf_[BoolItemType::B], static_cast<uint8_t>(value));
+    return *this;
+  }
+
+  BoolItemType& operator= (const BoolItemType& other) {  // copies the value, not the buffer
+    return *this = static_cast<bool>(other);
+  }
+};
+
+template<size_t bits, size_t N, typename Holder>
+struct BoolArrayType final : public internals::TypeBase<bool, bits, 1, N> {
+  static_assert(N > 0, "Size must be 1 or more");
+  typename Holder::type pbuf_;
+  // Google Style-guide disallows non-const reference for API, we need this
+  // NOLINTNEXTLINE(runtime/references)
+  explicit BoolArrayType(typename Holder::type pbuf): pbuf_(pbuf) {}
+  // NOLINTNEXTLINE(runtime/references)
+  explicit BoolArrayType(VStruct &baseStruct): pbuf_(baseStruct.internal_buf_) {}
+  BoolArrayType(const BoolArrayType&) = default;
+  BoolArrayType& operator= (const BoolArrayType&) = delete;  // would rebind a BufferPtr proxy
+
+  using Element = internals::BoolArrayElement<BoolArrayType::b, N, Holder::read_only>;
+
+  // returns the temporary array object, or the value for a read only view
+  typename Element::type operator[](size_t index) {
+    return Element::make(&pbuf_[BoolArrayType::B], index);
+  }
+
+  bool operator[](size_t index) const {
+    return internals::BoolArrayTemp<BoolArrayType::b, N>::get(&pbuf_[BoolArrayType::B], index);
+  }
+
+  typedef typename Element::iterator iterator;  // const_iterator for a read only view
+  typedef internals::BoolArrayConstIterator<BoolArrayType::b, N> const_iterator;
+
+  iterator begin() {
+    return iterator(&pbuf_[BoolArrayType::B], 0);
+  }
+  iterator end() {
+    return iterator(&pbuf_[BoolArrayType::B], N);
+  }
+  const_iterator begin() const {
+    return cbegin();
+  }
+  const_iterator end() const {
+    return cend();
+  }
+  const_iterator cbegin() const {
+    return const_iterator(&pbuf_[BoolArrayType::B], 0);
+  }
+  const_iterator cend() const {
+    return const_iterator(&pbuf_[BoolArrayType::B], N);
+  }
+
+  // word wise operations, 64 elements at a time
+  using Words = internals::BoolArrayWords<BoolArrayType::b, N>;
+
+  // number of true elements
+  size_t count() const {
+    return Words::count(&pbuf_[BoolArrayType::B]);
+  }
+
+  bool any() const {
+    return Words::any(&pbuf_[BoolArrayType::B]);
+  }
+
+  bool all() const {
+    return Words::all(&pbuf_[BoolArrayType::B]);
+  }
+
+  bool none() const {
+    return !any();
+  }
+
+  // index of the first element equal to value, N if there is none
+  size_t find_first(bool value = true) const {
+    return Words::find_from(&pbuf_[BoolArrayType::B], 0, value);
+  }
+
+  // index of the first element after pos equal to value, N if there is none
+  size_t find_next(size_t pos, bool value = true) const {
+    return Words::find_from(&pbuf_[BoolArrayType::B], pos + 1, value);
+  }
+
+  template<size_t other_bits, typename OtherHolder>
+  BoolArrayType& and_with(const BoolArrayType<other_bits, N, OtherHolder>& other) {
+    return combine(other, [](uint64_t x, uint64_t y) { return x & y; });
+  }
+
+  template<size_t other_bits, typename OtherHolder>
+  BoolArrayType& or_with(const BoolArrayType<other_bits, N, OtherHolder>& other) {
+    return combine(other, [](uint64_t x, uint64_t y) { return x | y; });
+  }
+
+  template<size_t other_bits, typename OtherHolder>
+  BoolArrayType& xor_with(const BoolArrayType<other_bits, N, OtherHolder>& other) {
+    return combine(other, [](uint64_t x, uint64_t y) { return x ^ y; });
+  }
+
+ private:
+  template<size_t other_bits, typename OtherHolder, typename Op>
+  BoolArrayType& combine(const BoolArrayType<other_bits, N, OtherHolder>& other, Op op) {
+    static_assert(!Holder::read_only, "field of a read only view cannot be written");
+    using Other = BoolArrayType<other_bits, N, OtherHolder>;
+    using OtherWords = typename Other::Words;
+    pbuf_type* pData = &pbuf_[BoolArrayType::B];
+    const pbuf_type* pOther = &other.pbuf_[Other::B];
+    for (size_t w = 0; w < Words::words; w++) {
+      Words::store(pData, w, op(Words::load(pData, w), OtherWords::load(pOther, w)));
+    }
+    return *this;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Padding for alignment
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<size_t bits, size_t AlignByte>
+struct AlignPadType final {
+  static_assert(AlignByte <= 8, "Maximum 8 byte allignment allowed");
+  enum : size_t {
+    misalignment = (bits % (AlignByte * 8)),
+    next_bit = (misalignment > 0) ? bits + ((AlignByte * 8) - misalignment): bits
+  };
+  explicit AlignPadType(){}
+};
+
+template<typename T, size_t bits, size_t Sz, typename H, typename Holder>
+struct WithHolder<LEItemType<T, bits, Sz, H>, Holder> {
+  using type = LEItemType<T, bits, Sz, Holder>;
+};
+
+template<typename T, size_t bits, size_t Sz, size_t N, typename H, typename Holder>
+struct WithHolder<LEArrayType<T, bits, Sz, N, H>, Holder> {
+  using type = LEArrayType<T, bits, Sz, N, Holder>;
+};
+
+template<size_t bits, typename H, typename Holder>
+struct WithHolder<BoolItemType<bits, H>, Holder> {
+  using type = BoolItemType<bits, Holder>;
+};
+
+template<size_t bits, size_t N, typename H, typename Holder>
+struct WithHolder<BoolArrayType<bits, N, H>, Holder> {
+  using type = BoolArrayType<bits, N, Holder>;
+};
+
+template<typename T, size_t bits, size_t Sz, typename H, typename Holder>
+struct WithHolder<BEItemType<T, bits, Sz, H>, Holder> {
+  using type = BEItemType<T, bits, Sz, Holder>;
+};
+
+template<typename T, size_t bits, size_t Sz, size_t N, typename H, typename Holder>
+struct WithHolder<BEArrayType<T, bits, Sz, N, H>, Holder> {
+  using type = BEArrayType<T, bits, Sz, N, Holder>;
+};
+
+namespace internals {
+/// SharesByte - true if a field of the other byte order than Prev would start inside the last byte of Prev,
+/// little and big endian fields number the bits of a byte in opposite directions
+template<typename Prev, bool big_endian>
+struct SharesByte {
+  enum : bool {
+    value = (IsBigEndian<Prev>::value != big_endian) && (Prev::next_bit & 0x7)
+  };
+};
+}  // namespace internals
+
+template<typename Prev, typename T, size_t Sz>
+struct LEItem {
+  static_assert(!internals::SharesByte<Prev, false>::value,
+                "LEItem cannot share a byte with a BEItem, use AlignPad");
+  using type = LEItemType<T, Prev::next_bit, Sz>;
+  LEItem() = delete;
+};
+
+template<typename Prev, typename T, size_t Sz, size_t N>
+struct LEArray {
+  static_assert(!internals::SharesByte<Prev, false>::value,
+                "LEArray cannot share a byte with a BEItem, use AlignPad");
+  using type = LEArrayType<T, Prev::next_bit, Sz, N>;
+  LEArray() = delete;
+};
+
+template<typename Prev>
+struct BoolItem {
+  static_assert(!internals::SharesByte<Prev, false>::value,
+                "BoolItem cannot share a byte with a BEItem, use AlignPad");
+  using type = BoolItemType<Prev::next_bit>;
+  BoolItem() = delete;
+};
+
+template<typename Prev, size_t N>
+struct BoolArray{
+  static_assert(!internals::SharesByte<Prev, false>::value,
+                "BoolArray cannot share a byte with a BEItem, use AlignPad");
+  using type = BoolArrayType<Prev::next_bit, N>;
+  BoolArray() = delete;
+};
+
+template<typename Prev, typename T, size_t Sz>
+struct BEItem {
+  static_assert(!internals::SharesByte<Prev, true>::value,
+                "BEItem cannot share a byte with an LEItem, use AlignPad");
+  using type = BEItemType<T, Prev::next_bit, Sz>;
+  BEItem() = delete;
+};
+
+template<typename Prev, typename T, size_t Sz, size_t N>
+struct BEArray {
+  static_assert(!internals::SharesByte<Prev, true>::value,
+                "BEArray cannot share a byte with an LEItem, use AlignPad");
+  using type = BEArrayType<T, Prev::next_bit, Sz, N>;
+  BEArray() = delete;
+};
+
+template<typename Prev, size_t AlignByte>
+struct AlignPad{
+  using type = AlignPadType<Prev::next_bit, AlignByte>;
+};
+
+struct Root final {
+  enum : size_t {
+    next_bit = 0
+  };
+  Root() = delete;
+};
+
+
+
+}  // namespace vstruct
+
+
+#endif  // VSTRUCT_ITEMTYPES_H_
@@ -0,0 +1,275 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// This file provides a flat variadic form for declaring a layout.
+///
+/// With the LEItem<decltype(prev), ...> chain every field type depends on the type before it, so the
+/// offsets are resolved one dependent type at a time. Layout<Specs...> lists the fields as plain specs
+/// instead, and the first bits of all fields come from one prefix sum over the spec sizes: the storage
+/// type of field I depends only on its own spec and its offset. The bit layout, the storage types and
+/// the padding rules are the same as the chain.
+///
+/// Example Usage:
+///
+/// struct x4;  // tag
+/// using Example = vstruct::Layout<
+///     vstruct::Pad<4>,
+///     vstruct::Bool,
+///     vstruct::Field<int8_t, 3>,
+///     vstruct::Named<x4, vstruct::Field<uint32_t, 26>>,
+///     vstruct::Array<uint16_t, 11, 8>>;
+/// Example s(buffer);
+/// s.get<2>() = -1;
+/// s.get<x4>() = 1000;
+/// s.get<4>()[7] = 5;
+///
+#ifndef VSTRUCT_LAYOUT_H_
+#define VSTRUCT_LAYOUT_H_
+
+#include <stddef.h>
+#include <type_traits>
+#include "./internals.h"
+#include "./itemtypes.h"
+
+namespace vstruct {
+
+/// Field - item of type T packed in Sz bits
+template <typename T, size_t Sz = (sizeof(T) << 3)>
+struct Field {
+  enum : size_t {
+    bit_size = Sz,
+    align_bits = 1,
+    is_pad = 0
+  };
+  template <size_t bits>
+  using type = LEItemType<T, bits, Sz>;
+  typedef void tag;
+};
+
+/// Array - N elements of type T, each packed in Sz bits
+template <typename T, size_t Sz, size_t N>
+struct Array {
+  enum : size_t {
+    bit_size = Sz * N,
+    align_bits = 1,
+    is_pad = 0
+  };
+  template <size_t bits>
+  using type = LEArrayType<T, bits, Sz, N>;
+  typedef void tag;
+};
+
+/// Bool - single bool
+struct Bool {
+  enum : size_t {
+    bit_size = 1,
+    align_bits = 1,
+    is_pad = 0
+  };
+  template <size_t bits>
+  using type = BoolItemType<bits>;
+  typedef void tag;
+};
+
+/// Bools - N bools
+template <size_t N>
+struct Bools {
+  enum : size_t {
+    bit_size = N,
+    align_bits = 1,
+    is_pad = 0
+  };
+  template <size_t bits>
+  using type = BoolArrayType<bits, N>;
+  typedef void tag;
+};
+
+/// Pad - align the next field to AlignByte bytes, same as AlignPad
+template <size_t AlignByte>
+struct Pad {
+  static_assert(AlignByte >= 1 && AlignByte <= 8, "Maximum 8 byte allignment allowed");
+  enum : size_t {
+    bit_size = 0,
+    align_bits = AlignByte * 8,
+    is_pad = 1
+  };
+  template <size_t bits>
+  using type = AlignPadType<bits, AlignByte>;
+  typedef void tag;
+};
+
+/// Named - Spec with a tag type, the field can then be accessed by tag
+template <typename Tag, typename Spec>
+struct Named : public Spec {
+  typedef Tag tag;
+};
+
+namespace internals {
+
+constexpr size_t align_bit(size_t bit, size_t align_bits) {
+  return (bit + align_bits - 1) / align_bits * align_bits;
+}
+
+/// SpecLeaf/TagLeaf - bases of LayoutIndex, one per spec
+template <size_t I, typename Spec>
+struct SpecLeaf {};
+
+template <size_t I>
+struct Untagged {};
+
+template <typename Tag, size_t I>
+struct TagLeaf {};
+
+/// LayoutIndex - spec at index I and index of a tag, found by overload resolution against the bases
+/// instead of a recursive walk over the specs
+template <typename Indices, typename... Specs>
+struct LayoutIndex;
+
+template <size_t... I, typename... Specs>
+struct LayoutIndex<IndexList<I...>, Specs...>
+    : public SpecLeaf<I, Specs>...,
+      public TagLeaf<typename std::conditional<std::is_same<typename Specs::tag, void>::value,
+                                               Untagged<I>, typename Specs::tag>::type, I>... {
+  template <size_t J, typename Spec>
+  static Spec spec_at(const SpecLeaf<J, Spec>*);
+
+  template <typename Tag, size_t J>
+  static std::integral_constant<size_t, J> tag_index(const TagLeaf<Tag, J>*);
+};
+
+template <typename Low, typename High>
+struct JoinIndexList;
+
+template <size_t... I, size_t... J>
+struct JoinIndexList<IndexList<I...>, IndexList<J...>> {
+  using type = IndexList<I..., J...>;
+};
+
+/// LayoutBits - first bits of the N specs of Index from spec J, the running bit starts at Bit: each spec
+/// aligns the running bit then adds its size. The range is halved at each step like MakeIndexList, so every
+/// offset is computed once and the instantiation depth is log2(N)
+template <typename Index, size_t J, size_t N, size_t Bit>
+struct LayoutBits {
+  using Low = LayoutBits<Index, J, N / 2, Bit>;
+  using High = LayoutBits<Index, J + N / 2, N - N / 2, Low::end_bit>;
+  using type = typename JoinIndexList<typename Low::type, typename High::type>::type;
+  enum : size_t {
+    end_bit = High::end_bit
+  };
+};
+
+template <typename Index, size_t J, size_t Bit>
+struct LayoutBits<Index, J, 0, Bit> {
+  using type = IndexList<>;
+  enum : size_t {
+    end_bit = Bit
+  };
+};
+
+template <typename Index, size_t J, size_t Bit>
+struct LayoutBits<Index, J, 1, Bit> {
+  using Spec = decltype(Index::template spec_at<J>(static_cast<Index*>(nullptr)));
+  using type = IndexList<Bit>;
+  enum : size_t {
+    end_bit = align_bit(Bit, Spec::align_bits) + Spec::bit_size
+  };
+};
+
+/// LayoutBitArray - the first bits of a LayoutBits list as a constexpr array
+template <typename Bits>
+struct LayoutBitArray;
+
+template <size_t... B>
+struct LayoutBitArray<IndexList<B...>> {
+  static constexpr size_t value[sizeof...(B)] = {B...};
+};
+
+template <size_t... B>
+constexpr size_t LayoutBitArray<IndexList<B...>>::value[sizeof...(B)];
+
+/// LayoutFields - FieldList of the storage types that are not void (padding)
+template <typename List, typename... Types>
+struct LayoutFields;
+
+template <typename... Fields>
+struct LayoutFields<FieldList<Fields...>> {
+  using type = FieldList<Fields...>;
+};
+
+template <typename... Fields, typename T, typename... Rest>
+struct LayoutFields<FieldList<Fields...>, T, Rest...> {
+  using type = typename LayoutFields<
+      typename std::conditional<std::is_same<T, void>::value, FieldList<Fields...>, FieldList<Fields..., T>>::type,
+      Rest...>::type;
+};
+
+/// LayoutFieldTypes - field_types of layout L
+template <typename L, typename Indices = typename MakeIndexList<L::size>::type>
+struct LayoutFieldTypes;
+
+template <typename L, size_t... I>
+struct LayoutFieldTypes<L, IndexList<I...>> {
+  using type = typename LayoutFields<
+      FieldList<>,
+      typename std::conditional<L::template spec<I>::is_pad, void, typename L::template type<I>>::type...>::type;
+};
+
+}  // namespace internals
+
+/// Layout - view of a buffer laid out as Specs, fields are accessed with get<I>() or get<Tag>()
+/// Template args:
+///   Specs: Field, Array, Bool, Bools, Pad or Named specs in declaration order
+template <typename... Specs>
+struct Layout : public VStructView {
+  static_assert(sizeof...(Specs) > 0, "Layout needs at least one spec");
+  using VStructView::VStructView;
+  using Index_ = internals::LayoutIndex<typename internals::MakeIndexList<sizeof...(Specs)>::type, Specs...>;
+
+  using Bits_ = internals::LayoutBits<Index_, 0, sizeof...(Specs), 0>;
+  using BitArray_ = internals::LayoutBitArray<typename Bits_::type>;
+
+  enum : size_t {
+    size = sizeof...(Specs),
+    record_bits = Bits_::end_bit,
+    record_bytes = (record_bits + 7) >> 3  // stride of consecutive records
+  };
+
+  // first bit of spec I
+  static constexpr size_t first_bit(size_t I) {
+    return BitArray_::value[I];
+  }
+
+  // spec I as declared
+  template <size_t I>
+  using spec = decltype(Index_::template spec_at<I>(static_cast<Index_*>(nullptr)));
+
+  // index of the spec named Tag
+  template <typename Tag>
+  using index_of = decltype(Index_::template tag_index<Tag>(static_cast<Index_*>(nullptr)));
+
+  // storage type of spec I, the same type as the LEItem/LEArray/BoolItem/BoolArray/AlignPad chain gives
+  template <size_t I>
+  using type = typename spec<I>::template type<BitArray_::value[I]>;
+
+  template <size_t I>
+  ViewField<type<I>> get() const {
+    static_assert(!spec<I>::is_pad, "padding has no storage");
+    return ViewField<type<I>>{internal_buf_};
+  }
+
+  template <typename Tag>
+  ViewField<type<index_of<Tag>::value>> get() const {
+    return get<index_of<Tag>::value>();
+  }
+};
+
+/// LayoutFieldList - FieldList of the storage types of the fields of L, padding excluded
+template <typename L>
+using LayoutFieldList = typename internals::LayoutFieldTypes<L>::type;
+
+}  // namespace vstruct
+
+#endif  // VSTRUCT_LAYOUT_H_
@@ -0,0 +1,274 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// This file provides a file of packed records mapped into memory (POSIX only, not included by vstruct.h).
+///
+/// The file holds records of a generated layout back to back, record_bytes apart, like a RecordArray.
+/// Records are read and written in place through the generated views, nothing is copied to the heap.
+/// A writable file grows by doubling for appends and is truncated to the records in use when closed.
+///
+/// Example Usage:
+///
+/// vstruct::MappedRecordFile<Example1> file;
+/// if (!file.open("records.bin", vstruct::MappedRecordFile<Example1>::Mode::read_only)) {
+///   perror("records.bin");
+/// }
+/// file.advise_sequential();
+/// for (auto it = file.cbegin(); it != file.cend(); ++it) {
+///   total += it->x4();
+/// }
+/// vstruct::extract_column(&Example1::x4, file.cdata(), file.size(), x4.data());
+///
+#ifndef VSTRUCT_MAPPED_H_
+#define VSTRUCT_MAPPED_H_
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "./internals.h"
+#include "./itemtypes.h"
+#include "./records.h"
+
+namespace vstruct {
+
+/// MappedRecordFile - records of a generated layout in a memory mapped file
+/// Growing the file remaps it, which invalidates views and cursors, like std::vector.
+/// Functions touching the file return false on failure and leave errno set.
+/// Template args:
+///   Layout: generated struct, provides View, ConstView and record_bytes
+template <typename Layout>
+class MappedRecordFile {
+ public:
+  typedef typename Layout::View View;
+  typedef typename Layout::ConstView ConstView;
+  typedef RecordCursor<View> iterator;
+  typedef RecordCursor<ConstView> const_iterator;
+  enum : size_t {
+    stride = Layout::record_bytes
+  };
+  enum class Mode {
+    read_only,
+    read_write  // the file is created if it does not exist
+  };
+
+  MappedRecordFile(): fd_(-1), data_(nullptr), size_(0), capacity_(0), writable_(false) {}
+
+  MappedRecordFile(const MappedRecordFile&) = delete;
+  MappedRecordFile& operator=(const MappedRecordFile&) = delete;
+
+  ~MappedRecordFile() {
+    close();
+  }
+
+  // map the records of the file at path, bytes after the last whole record are ignored
+  bool open(const char* path, Mode mode) {
+    close();
+    writable_ = (mode == Mode::read_write);
+    fd_ = writable_ ? ::open(path, O_RDWR | O_CREAT, 0644) : ::open(path, O_RDONLY);
+    if (fd_ < 0) {
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+      return fail();
+    }
+    size_ = static_cast<size_t>(st.st_size) / stride;
+    capacity_ = size_;
+    if (capacity_ > 0 && !map()) {
+      return fail();
+    }
+    return true;
+  }
+
+  // unmap and close, a writable file is truncated to the records in use
+  bool close() {
+    if (fd_ < 0) {
+      return true;
+    }
+    bool ok = unmap();
+    if (writable_ && capacity_ != size_) {
+      ok = (ftruncate(fd_, static_cast<off_t>(size_ * stride)) == 0) && ok;
+    }
+    ok = (::close(fd_) == 0) && ok;
+    fd_ = -1;
+    size_ = 0;
+    capacity_ = 0;
+    return ok;
+  }
+
+  bool is_open() const {
+    return fd_ >= 0;
+  }
+  bool writable() const {
+    return writable_;
+  }
+  size_t size() const {
+    return size_;
+  }
+  size_t capacity() const {
+    return capacity_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+  size_t size_bytes() const {
+    return size_ * stride;
+  }
+
+  const pbuf_type* cdata() const {
+    return data_;
+  }
+  pbuf_type* data() const {
+    assert(writable_ && "File is mapped read only!");
+    return data_;
+  }
+
+  // view of record index, only for writable files
+  View operator[](size_t index) const {
+    assert(index < size_ && "Index is out of bounds!");
+    return View(data() + index * stride);
+  }
+
+  // read only view of record index
+  ConstView cget(size_t index) const {
+    assert(index < size_ && "Index is out of bounds!");
+    return ConstView(data_ + index * stride);
+  }
+
+  // cursors over the records, only for writable files
+  iterator begin() const {
+    return iterator(data());
+  }
+  iterator end() const {
+    return iterator(data() + size_ * stride);
+  }
+
+  // read only cursors over the records
+  const_iterator cbegin() const {
+    return const_iterator(data_);
+  }
+  const_iterator cend() const {
+    return const_iterator(data_ + size_ * stride);
+  }
+
+  // records as a RecordArray wrapping the mapping, only for writable files
+  RecordArray<View> records() const {
+    return RecordArray<View>(data(), size_);
+  }
+
+  // grow the file to hold count records
+  bool reserve(size_t count) {
+    assert(writable_ && "File is mapped read only!");
+    if (count <= capacity_) {
+      return true;
+    }
+    if (!unmap()) {
+      return false;
+    }
+    if (ftruncate(fd_, static_cast<off_t>(count * stride)) != 0) {
+      map();
+      return false;
+    }
+    capacity_ = count;
+    return map();
+  }
+
+  // new records are zero filled
+  bool resize(size_t count) {
+    if (count > capacity_ && !reserve(grow_to(count))) {
+      return false;
+    }
+    if (count > size_) {
+      memset(data_ + size_ * stride, 0, (count - size_) * stride);
+    }
+    size_ = count;
+    return true;
+  }
+
+  // append a zero filled record, returns a view with a null buffer if the file cannot grow
+  View push_back() {
+    if (!resize(size_ + 1)) {
+      return View(nullptr);
+    }
+    return (*this)[size_ - 1];
+  }
+
+  // the records will be read in order
+  bool advise_sequential() {
+    return advise(0, size_, MADV_SEQUENTIAL);
+  }
+
+  // records first to first + count will be needed soon
+  bool advise_willneed(size_t first, size_t count) {
+    return advise(first, count, MADV_WILLNEED);
+  }
+
+  // write changed records back to the file
+  bool sync() {
+    return !data_ || msync(data_, capacity_ * stride, MS_SYNC) == 0;
+  }
+
+ private:
+  bool map() {
+    data_ = nullptr;
+    if (capacity_ == 0) {
+      return true;
+    }
+    int prot = writable_ ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* p = mmap(nullptr, capacity_ * stride, prot, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) {
+      return false;
+    }
+    data_ = static_cast<pbuf_type*>(p);
+    return true;
+  }
+
+  bool unmap() {
+    bool ok = !data_ || munmap(data_, capacity_ * stride) == 0;
+    data_ = nullptr;
+    return ok;
+  }
+
+  bool advise(size_t first, size_t count, int advice) {
+    if (!data_ || count == 0) {
+      return true;
+    }
+    // madvise needs a page aligned start
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = first * stride;
+    size_t aligned = begin - begin % page;
+    return madvise(data_ + aligned, begin + count * stride - aligned, advice) == 0;
+  }
+
+  bool fail() {  // close after a failed open, keeps errno of the failure
+    int error = errno;
+    ::close(fd_);
+    fd_ = -1;
+    size_ = 0;
+    capacity_ = 0;
+    errno = error;
+    return false;
+  }
+
+  size_t grow_to(size_t count) const {  // amortized growth
+    return (count > 2 * capacity_) ? count : 2 * capacity_;
+  }
+
+  int fd_;
+  pbuf_type* data_;
+  size_t size_;
+  size_t capacity_;
+  bool writable_;
+};
+
+}  // namespace vstruct
+
+#endif  // VSTRUCT_MAPPED_H_
@@ -0,0 +1,169 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// This file provides whole record decode/encode to plain native structs.
+///
+/// The generator emits a <Name>Native struct with one native member per field, and load()/store()
+/// functions that convert a whole record. Every field, and every element of an array field, is converted
+/// with the fixed offset accessor, unrolled at compile time: the conversion is straight line code without
+/// loops, branches or runtime offsets.
+///
+/// The generated load()/store() group neighbouring elements into 64 bit windows: a window is loaded once
+/// and each element in it is a shift and a mask (window_get), store() updates the window and writes it
+/// back once (window_set). Only elements that do not fit in a window starting at their first byte,
+/// 58 to 64 bit elements that are not byte aligned, are accessed on their own (load_element).
+/// Big endian elements are also accessed on their own, through BEOrderAt.
+///
+/// Example Usage:
+///
+/// Example1Native n;
+/// load(pRecord, n);
+/// n.x4 += 1;
+/// store(n, pRecord);
+///
+#ifndef VSTRUCT_NATIVE_H_
+#define VSTRUCT_NATIVE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include "./internals.h"
+#include "./columns.h"
+
+// the element recursion of large arrays is past the default inlining limits
+#if defined(__GNUC__)
+#define VSTRUCT_FORCE_INLINE inline __attribute__((always_inline))
+#else
+#define VSTRUCT_FORCE_INLINE inline
+#endif
+
+namespace vstruct {
+namespace internals {
+
+/// NativeElement - element I of field F, at a fixed bit offset
+template <typename F, size_t I>
+struct NativeElement {
+  static_assert(I < F::N, "element index is out of bounds");
+  typedef typename F::unpackedT T;
+  using Packer_ = ColumnPacker<T, F::Sz>;
+  typedef typename Packer_::packedT packedT;
+  using Order = typename std::conditional<IsBigEndian<F>::value,
+                                          BEOrderAt<packedT, F::Sz, F::first_bit + I * F::Sz>,
+                                          LEOrderAt<packedT, F::Sz, F::first_bit + I * F::Sz>>::type;
+  enum : size_t {
+    first_bit = F::first_bit + I * F::Sz
+  };
+  enum : uint64_t {
+    mask = MaskMax<uint64_t, F::Sz>::value
+  };
+};
+
+/// NativeElements - convert elements I to N - 1 of field F, one fixed offset access per element
+template <typename F, size_t I = 0, bool done = (I >= F::N)>
+struct NativeElements {
+  typedef typename F::unpackedT T;
+  using Element = NativeElement<F, I>;
+  using Next = NativeElements<F, I + 1>;
+
+  VSTRUCT_FORCE_INLINE static void load(const pbuf_type* pRoot, T* out) {
+    out[I] = Element::Packer_::unpack(Element::Order::get(pRoot));
+    Next::load(pRoot, out);
+  }
+  VSTRUCT_FORCE_INLINE static void store(pbuf_type* pRoot, const T* in) {
+    Element::Order::set(pRoot, Element::Packer_::pack(in[I]));
+    Next::store(pRoot, in);
+  }
+};
+
+template <typename F, size_t I>
+struct NativeElements<F, I, true> {
+  typedef typename F::unpackedT T;
+  VSTRUCT_FORCE_INLINE static void load(const pbuf_type*, T*) {}
+  VSTRUCT_FORCE_INLINE static void store(pbuf_type*, const T*) {}
+};
+
+}  // namespace internals
+
+/// load_field - decode field F of the record at pRoot, for example
+/// load_field<decltype(Example1::x4)>(pRoot, n.x4)
+template <typename F>
+VSTRUCT_FORCE_INLINE void load_field(const pbuf_type* pRoot,
+                                     typename F::unpackedT& out) {  // NOLINT(runtime/references)
+  static_assert(F::N == 1, "array field needs an array");
+  internals::NativeElements<F>::load(pRoot, &out);
+}
+
+template <typename F>
+VSTRUCT_FORCE_INLINE void load_field(const pbuf_type* pRoot,
+                                     typename F::unpackedT (&out)[F::N]) {  // NOLINT(runtime/references)
+  internals::NativeElements<F>::load(pRoot, out);
+}
+
+/// store_field - encode field F to the record at pRoot, values out of range saturate as in the setters
+template <typename F>
+VSTRUCT_FORCE_INLINE void store_field(pbuf_type* pRoot, const typename F::unpackedT& in) {
+  static_assert(F::N == 1, "array field needs an array");
+  internals::NativeElements<F>::store(pRoot, &in);
+}
+
+template <typename F>
+VSTRUCT_FORCE_INLINE void store_field(pbuf_type* pRoot, const typename F::unpackedT (&in)[F::N]) {
+  internals::NativeElements<F>::store(pRoot, in);
+}
+
+/// load_element - decode element I of field F on its own, for elements that do not fit a shared window
+template <typename F, size_t I>
+VSTRUCT_FORCE_INLINE void load_element(const pbuf_type* pRoot,
+                                       typename F::unpackedT& out) {  // NOLINT(runtime/references)
+  using Element = internals::NativeElement<F, I>;
+  out = Element::Packer_::unpack(Element::Order::get(pRoot));
+}
+
+template <typename F, size_t I>
+VSTRUCT_FORCE_INLINE void store_element(pbuf_type* pRoot, const typename F::unpackedT& in) {
+  using Element = internals::NativeElement<F, I>;
+  Element::Order::set(pRoot, Element::Packer_::pack(in));
+}
+
+/// load_window - n bytes of the record from base_byte, one span access shared by the fields within it
+template <size_t base_byte, size_t n>
+VSTRUCT_FORCE_INLINE uint64_t load_window(const pbuf_type* pRoot) {
+  return internals::SpanAccess<n>::load(&pRoot[base_byte]);
+}
+
+template <size_t base_byte, size_t n>
+VSTRUCT_FORCE_INLINE void store_window(pbuf_type* pRoot, uint64_t window) {
+  internals::SpanAccess<n>::store(&pRoot[base_byte], window);
+}
+
+/// window_get - decode element I of field F from a window loaded at base_byte, a shift and a mask
+template <typename F, size_t I, size_t base_byte>
+VSTRUCT_FORCE_INLINE void window_get(uint64_t window, typename F::unpackedT& out) {  // NOLINT(runtime/references)
+  using Element = internals::NativeElement<F, I>;
+  enum : size_t {
+    shift = Element::first_bit - (base_byte << 3)
+  };
+  static_assert(Element::first_bit >= (base_byte << 3) && shift + F::Sz <= 64, "element is outside the window");
+  static_assert(!IsBigEndian<F>::value, "big endian element needs load_element/store_element");
+  out = Element::Packer_::unpack(static_cast<typename Element::packedT>((window >> shift) & Element::mask));
+}
+
+/// window_set - returns window with element I of field F replaced, other bits are unchanged
+template <typename F, size_t I, size_t base_byte>
+VSTRUCT_FORCE_INLINE uint64_t window_set(uint64_t window, const typename F::unpackedT& in) {
+  using Element = internals::NativeElement<F, I>;
+  enum : size_t {
+    shift = Element::first_bit - (base_byte << 3)
+  };
+  static_assert(Element::first_bit >= (base_byte << 3) && shift + F::Sz <= 64, "element is outside the window");
+  static_assert(!IsBigEndian<F>::value, "big endian element needs load_element/store_element");
+  uint64_t value = static_cast<uint64_t>(Element::Packer_::pack(in)) & Element::mask;
+  return (window & ~(static_cast<uint64_t>(Element::mask) << shift)) | (value << shift);
+}
+
+}  // namespace vstruct
+
+#endif  // VSTRUCT_NATIVE_H_
@@ -0,0 +1,285 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// This file provides containers of contiguous packed records.
+///
+/// Records of a generated struct are stored back to back, record_bytes apart.
+/// Records are accessed through the generated stateless view, a cursor moves the view's
+/// buffer pointer by the stride instead of attaching every record to a VStruct.
+///
+/// Example Usage:
+///
+/// vstruct::RecordArray<Example1View> records;
+/// records.reserve(1000);
+/// Example1View r = records.push_back();
+/// r.x0() = 1;
+/// for (Example1View v : records) {
+///   total += v.x4();
+/// }
+///
+#ifndef VSTRUCT_RECORDS_H_
+#define VSTRUCT_RECORDS_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "./internals.h"
+
+namespace vstruct {
+
+/// RecordCursor - random access iterator over records, dereferences to a view of the current record
+/// Template args:
+///   View: generated view or read only view type, provides record_bytes
+template <typename View>
+class RecordCursor {
+ public:
+  typedef decltype(std::declval<const View&>().getBuffer()) buffer_type;  // const pbuf_type* for a read only view
+  typedef std::random_access_iterator_tag iterator_category;
+  typedef View value_type;
+  typedef ptrdiff_t difference_type;
+  typedef const View* pointer;
+  typedef View reference;
+  enum : size_t {
+    stride = View::record_bytes
+  };
+
+  RecordCursor(): view_(nullptr) {}
+  explicit RecordCursor(buffer_type pRecord): view_(pRecord) {}
+
+  buffer_type getBuffer() const {
+    return view_.getBuffer();
+  }
+
+  View operator*() const {
+    return view_;
+  }
+  const View* operator->() const {
+    return &view_;
+  }
+  View operator[](difference_type n) const {
+    return View(view_.getBuffer() + n * static_cast<difference_type>(stride));
+  }
+
+  RecordCursor& operator+=(difference_type n) {
+    view_.setBuffer(view_.getBuffer() + n * static_cast<difference_type>(stride));
+    return *this;
+  }
+  RecordCursor& operator-=(difference_type n) {
+    return *this += -n;
+  }
+  RecordCursor& operator++() {
+    return *this += 1;
+  }
+  RecordCursor& operator--() {
+    return *this -= 1;
+  }
+  RecordCursor operator++(int) {
+    RecordCursor temp = *this;
+    *this += 1;
+    return temp;
+  }
+  RecordCursor operator--(int) {
+    RecordCursor temp = *this;
+    *this -= 1;
+    return temp;
+  }
+  RecordCursor operator+(difference_type n) const {
+    RecordCursor temp = *this;
+    return temp += n;
+  }
+  RecordCursor operator-(difference_type n) const {
+    RecordCursor temp = *this;
+    return temp -= n;
+  }
+  friend RecordCursor operator+(difference_type n, const RecordCursor& it) {
+    return it + n;
+  }
+  difference_type operator-(const RecordCursor& other) const {
+    return (getBuffer() - other.getBuffer()) / static_cast<difference_type>(stride);
+  }
+
+  bool operator==(const RecordCursor& other) const {
+    return getBuffer() == other.getBuffer();
+  }
+  bool operator!=(const RecordCursor& other) const {
+    return getBuffer() != other.getBuffer();
+  }
+  bool operator<(const RecordCursor& other) const {
+    return getBuffer() < other.getBuffer();
+  }
+  bool operator>(const RecordCursor& other) const {
+    return getBuffer() > other.getBuffer();
+  }
+  bool operator<=(const RecordCursor& other) const {
+    return getBuffer() <= other.getBuffer();
+  }
+  bool operator>=(const RecordCursor& other) const {
+    return getBuffer() >= other.getBuffer();
+  }
+
+ private:
+  View view_;
+};
+
+/// RecordArray - contiguous records of a generated layout
+/// Owns a growable buffer, or wraps an existing buffer of records. Growing a wrapped array past its
+/// capacity copies the records into an owned buffer, the wrapped buffer is then no longer used.
+/// An owned buffer always has vstruct::slack_bytes spare bytes after the last record.
+/// Growing an owned buffer invalidates views and cursors, like std::vector.
+/// Template args:
+///   View: generated view type, provides Layout and record_bytes
+template <typename View>
+class RecordArray {
+ public:
+  typedef typename View::Layout Layout;
+  typedef RecordCursor<View> iterator;
+  enum : size_t {
+    stride = View::record_bytes
+  };
+
+  RecordArray(): data_(nullptr), size_(0), capacity_(0), owning_(true) {}
+
+  explicit RecordArray(size_t count): RecordArray() {
+    resize(count);
+  }
+
+  // wrap count records at pData, the buffer is not owned
+  RecordArray(pbuf_type* pData, size_t count): data_(pData), size_(count), capacity_(count), owning_(false) {}
+
+  RecordArray(const RecordArray& other)
+  : storage_(other.storage_),
+    data_(other.owning_ ? storage_.data() : other.data_),
+    size_(other.size_),
+    capacity_(other.capacity_),
+    owning_(other.owning_) {
+  }
+
+  RecordArray(RecordArray&& other): RecordArray() {
+    swap(other);
+  }
+
+  RecordArray& operator=(RecordArray other) {
+    swap(other);
+    return *this;
+  }
+
+  void swap(RecordArray& other) {
+    storage_.swap(other.storage_);  // buffer moves with the vector, data_ stays valid
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(owning_, other.owning_);
+  }
+
+  size_t size() const {
+    return size_;
+  }
+  size_t capacity() const {
+    return capacity_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+  bool owning() const {
+    return owning_;
+  }
+  pbuf_type* data() const {
+    return data_;
+  }
+  size_t size_bytes() const {
+    return size_ * stride;
+  }
+
+  View operator[](size_t index) const {
+    assert(index < size_ && "Index is out of bounds!");
+    return View(data_ + index * stride);
+  }
+  View front() const {
+    return (*this)[0];
+  }
+  View back() const {
+    return (*this)[size_ - 1];
+  }
+
+  iterator begin() const {
+    return iterator(data_);
+  }
+  iterator end() const {
+    return iterator(data_ + size_ * stride);
+  }
+
+  // allocate space for count records, a wrapped buffer is copied into an owned buffer
+  void reserve(size_t count) {
+    if (count <= capacity_) {
+      return;
+    }
+    if (!owning_) {
+      storage_.assign(data_, data_ + size_ * stride);
+      owning_ = true;
+    }
+    storage_.resize(count * stride + slack_bytes);
+    data_ = storage_.data();
+    capacity_ = count;
+  }
+
+  // new records are zero filled
+  void resize(size_t count) {
+    if (count > capacity_) {
+      reserve(grow_to(count));
+    }
+    if (count > size_) {
+      memset(data_ + size_ * stride, 0, (count - size_) * stride);
+    }
+    size_ = count;
+  }
+
+  // append a zero filled record
+  View push_back() {
+    if (size_ == capacity_) {
+      reserve(grow_to(size_ + 1));
+    }
+    pbuf_type* pRecord = data_ + size_ * stride;
+    memset(pRecord, 0, stride);
+    size_++;
+    return View(pRecord);
+  }
+
+  // append a copy of the record viewed by source, which may be a record of this array
+  View push_back(const View& source) {
+    pbuf_type temp[stride];
+    memcpy(temp, source.getBuffer(), stride);
+    View record = push_back();
+    memcpy(record.getBuffer(), temp, stride);
+    return record;
+  }
+
+  void pop_back() {
+    assert(size_ > 0 && "RecordArray is empty!");
+    size_--;
+  }
+
+  void clear() {
+    size_ = 0;
+  }
+
+ private:
+  size_t grow_to(size_t count) const {  // amortized growth
+    return (count > 2 * capacity_) ? count : 2 * capacity_;
+  }
+
+  std::vector<pbuf_type> storage_;
+  pbuf_type* data_;
+  size_t size_;
+  size_t capacity_;
+  bool owning_;
+};
+
+}  // namespace vstruct
+
+#endif  // VSTRUCT_RECORDS_H_
@@ -0,0 +1,309 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// This file provides predicate scans of one field across many records.
+///
+/// A scan returns a selection bitmap, bit i of word i / 64 is set when record i matches.
+/// Integer and bool fields are compared on the packed bits without unpacking: signed fields are
+/// biased by flipping the sign bit, which keeps the order of the values, and every comparison
+/// becomes a single unsigned range check (key - lo) <= width. On cpus with AVX2, integer fields within
+/// 32 bits are checked 8 records at a time with a gather. Float fields are unpacked and compared.
+///
+/// Example Usage:
+///
+/// std::vector<uint64_t> selection(vstruct::selection_words(count));
+/// size_t n = vstruct::scan(&Example1::x5, records, count, vstruct::Compare::lt, -100, selection.data());
+/// std::vector<uint32_t> rows(n);
+/// vstruct::selection_indices(selection.data(), count, rows.data());
+///
+#ifndef VSTRUCT_SCAN_H_
+#define VSTRUCT_SCAN_H_
+
+#include <stdint.h>
+#include <type_traits>
+#include "./internals.h"
+#include "./cpu.h"
+#include "./records.h"
+#include "./columns.h"
+
+namespace vstruct {
+
+/// Compare - comparison of a field value against a constant, field op value
+enum class Compare {
+  eq,
+  ne,
+  lt,
+  le,
+  gt,
+  ge
+};
+
+namespace internals {
+
+/// KeyRange - a predicate as an inclusive range of keys, key = packed bits with the sign bit flipped
+struct KeyRange {
+  uint64_t lo;
+  uint64_t width;  // hi - lo
+  bool empty;  // no key is in the range
+  bool invert;  // match keys outside the range
+
+  bool match(uint64_t key) const {
+    return (!empty && (key - lo <= width)) != invert;
+  }
+};
+
+/// ScanKeys - build the key range of a predicate on an integer or bool field of Sz bits
+template <typename T, size_t Sz>
+struct ScanKeys {
+  typedef typename std::conditional<std::is_signed<T>::value, int64_t, uint64_t>::type W;
+  enum : uint64_t {
+    bias = std::is_signed<T>::value ? (1ull << (Sz - 1)) : 0,
+    max_key = MaskMax<uint64_t, Sz>::value
+  };
+
+  // smallest and largest values that the field can hold
+  static W min_value() {
+    return static_cast<W>(0 - static_cast<uint64_t>(bias));
+  }
+  static W max_value() {
+    return static_cast<W>(static_cast<uint64_t>(max_key) - static_cast<uint64_t>(bias));
+  }
+
+  static uint64_t key(W x) {
+    return static_cast<uint64_t>(x) - static_cast<uint64_t>(min_value());
+  }
+
+  // lo <= x <= hi, clipped to the field range
+  static KeyRange between(W lo, W hi, bool invert = false) {
+    lo = (lo < min_value()) ? min_value() : lo;
+    hi = (hi > max_value()) ? max_value() : hi;
+    if (lo > hi) {
+      return KeyRange{0, 0, true, invert};
+    }
+    return KeyRange{key(lo), key(hi) - key(lo), false, invert};
+  }
+
+  static KeyRange make(Compare op, T value) {
+    W x = static_cast<W>(value);
+    switch (op) {
+      case Compare::eq:
+        return between(x, x);
+      case Compare::ne:
+        return between(x, x, true);
+      case Compare::lt:
+        return (x <= min_value()) ? KeyRange{0, 0, true, false} : between(min_value(), x - 1);
+      case Compare::le:
+        return between(min_value(), x);
+      case Compare::gt:
+        return (x >= max_value()) ? KeyRange{0, 0, true, false} : between(x + 1, max_value());
+      case Compare::ge:
+        return between(x, max_value());
+    }
+    return KeyRange{0, 0, true, false};
+  }
+};
+
+/// ScanAvx2 - check 8 records at a time, for fields that CanGather8
+/// Template args:
+///   F: storage type of the field
+///   stride: bytes between records
+template <typename F, size_t stride, bool enable = CanGather8<F, stride>::value>
+struct ScanAvx2 {
+  enum : size_t { enabled = 0 };
+  static size_t run(const pbuf_type*, size_t, const KeyRange&, uint64_t*) {
+    return 0;
+  }
+};
+
+#if VSTRUCT_X86_SIMD
+template <typename F, size_t stride>
+struct ScanAvx2<F, stride, true> {
+  typedef typename F::unpackedT T;
+  using Load = Gather8<F, stride>;
+  enum : size_t {
+    enabled = 1,
+    lanes = Load::lanes
+  };
+  enum : uint32_t {
+    bias = static_cast<uint32_t>(ScanKeys<T, F::Sz>::bias)
+  };
+
+  // fill whole selection words of 64 records, returns the number of records checked
+  VSTRUCT_TARGET("avx2") static size_t run(const pbuf_type* records, size_t count, const KeyRange& range,
+                                           uint64_t* selection) {
+    const __m256i vbias = _mm256_set1_epi32(static_cast<int>(bias));
+    const __m256i vlo = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(range.lo)));
+    const __m256i vwidth = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(range.width)));
+    const uint64_t invert = range.invert ? 0xff : 0;
+    size_t words = count / 64;
+    const pbuf_type* p = records + Load::offset_byte;
+    for (size_t w = 0; w < words; w++) {
+      uint64_t word = 0;
+      for (size_t g = 0; g < 64 / lanes; g++) {
+        __m256i key = _mm256_add_epi32(Load::load(p), vbias);  // the sign extended value plus the bias
+        __m256i d = _mm256_sub_epi32(key, vlo);
+        __m256i hit = _mm256_cmpeq_epi32(_mm256_min_epu32(d, vwidth), d);  // unsigned d <= width
+        uint64_t mask = static_cast<uint64_t>(_mm256_movemask_ps(_mm256_castsi256_ps(hit)));
+        word |= (mask ^ invert) << (g * lanes);
+        p += lanes * stride;
+      }
+      selection[w] = word;
+    }
+    return words * 64;
+  }
+};
+#endif  // VSTRUCT_X86_SIMD
+
+/// ScanField - predicate scan of field F of count records, stride bytes apart
+template <typename F, size_t stride, bool packed = std::is_integral<typename F::unpackedT>::value>
+struct ScanField {
+  static_assert(F::N == 1, "scan of an array field is not supported");
+  static_assert(!IsBigEndian<F>::value, "scan of a big endian field is not supported");
+  static_assert(F::total_bytes <= stride, "field is outside the record");
+  typedef typename F::unpackedT T;
+  using Keys = ScanKeys<T, F::Sz>;
+  using Order = LEOrderAt<uint64_t, F::Sz, F::first_bit>;
+  using Simd = ScanAvx2<F, stride>;
+
+  static void run(const pbuf_type* records, size_t count, const KeyRange& range, uint64_t* selection) {
+    size_t i = 0;
+#if VSTRUCT_X86_SIMD
+    if (Simd::enabled && !range.empty && CpuFeatures::get().avx2) {
+      i = Simd::run(records, count, range, selection);
+    }
+#endif
+    for (; i < count; i += 64) {
+      size_t n = (count - i < 64) ? count - i : 64;
+      uint64_t word = 0;
+      const pbuf_type* p = records + i * stride;
+      for (size_t k = 0; k < n; k++) {
+        uint64_t key = Order::get(p) ^ static_cast<uint64_t>(Keys::bias);
+        word |= static_cast<uint64_t>(range.match(key)) << k;
+        p += stride;
+      }
+      selection[i / 64] = word;
+    }
+  }
+
+  static void run(const pbuf_type* records, size_t count, Compare op, T value, uint64_t* selection) {
+    run(records, count, Keys::make(op, value), selection);
+  }
+
+  static void run_between(const pbuf_type* records, size_t count, T lo, T hi, uint64_t* selection) {
+    run(records, count, Keys::between(lo, hi), selection);
+  }
+};
+
+template <typename F, size_t stride>
+struct ScanField<F, stride, false> {  // floating point fields are unpacked
+  static_assert(F::N == 1, "scan of an array field is not supported");
+  static_assert(!IsBigEndian<F>::value, "scan of a big endian field is not supported");
+  static_assert(F::total_bytes <= stride, "field is outside the record");
+  typedef typename F::unpackedT T;
+  using Packer_ = Packer<T, F::Sz>;
+  using Order = LEOrderAt<typename Packer_::packedT, F::Sz, F::first_bit>;
+
+  template <typename Pred>
+  static void run_pred(const pbuf_type* records, size_t count, Pred pred, uint64_t* selection) {
+    for (size_t i = 0; i < count; i += 64) {
+      size_t n = (count - i < 64) ? count - i : 64;
+      uint64_t word = 0;
+      const pbuf_type* p = records + i * stride;
+      for (size_t k = 0; k < n; k++) {
+        word |= static_cast<uint64_t>(pred(Packer_::unpack(Order::get(p)))) << k;
+        p += stride;
+      }
+      selection[i / 64] = word;
+    }
+  }
+
+  static void run(const pbuf_type* records, size_t count, Compare op, T value, uint64_t* selection) {
+    switch (op) {
+      case Compare::eq:
+        return run_pred(records, count, [=](T x) { return x == value; }, selection);
+      case Compare::ne:
+        return run_pred(records, count, [=](T x) { return x != value; }, selection);
+      case Compare::lt:
+        return run_pred(records, count, [=](T x) { return x < value; }, selection);
+      case Compare::le:
+        return run_pred(records, count, [=](T x) { return x <= value; }, selection);
+      case Compare::gt:
+        return run_pred(records, count, [=](T x) { return x > value; }, selection);
+      case Compare::ge:
+        return run_pred(records, count, [=](T x) { return x >= value; }, selection);
+    }
+  }
+
+  static void run_between(const pbuf_type* records, size_t count, T lo, T hi, uint64_t* selection) {
+    run_pred(records, count, [=](T x) { return (lo <= x) && (x <= hi); }, selection);
+  }
+};
+
+}  // namespace internals
+
+/// selection_words - number of 64 bit words of the selection bitmap of count records
+inline size_t selection_words(size_t count) {
+  return (count + 63) / 64;
+}
+
+/// selection_count - number of selected records, bits after the last record must be zero
+inline size_t selection_count(const uint64_t* selection, size_t count) {
+  size_t total = 0;
+  for (size_t w = 0; w < selection_words(count); w++) {
+    total += static_cast<size_t>(__builtin_popcountll(selection[w]));
+  }
+  return total;
+}
+
+/// selection_indices - write the indices of the selected records to out, returns the number written
+inline size_t selection_indices(const uint64_t* selection, size_t count, uint32_t* out) {
+  size_t n = 0;
+  for (size_t w = 0; w < selection_words(count); w++) {
+    uint64_t word = selection[w];
+    while (word) {
+      out[n++] = static_cast<uint32_t>(w * 64 + static_cast<size_t>(__builtin_ctzll(word)));
+      word &= word - 1;
+    }
+  }
+  return n;
+}
+
+/// scan - select records where field op value, returns the number of selected records
+/// selection must hold selection_words(count) words, bits after the last record are zero
+template <typename Layout, typename Field>
+size_t scan(Field Layout::*, const pbuf_type* records, size_t count, Compare op,
+            typename Field::unpackedT value, uint64_t* selection) {
+  internals::ScanField<Field, Layout::record_bytes>::run(records, count, op, value, selection);
+  return selection_count(selection, count);
+}
+
+/// scan_between - select records where lo <= field <= hi, returns the number of selected records
+template <typename Layout, typename Field>
+size_t scan_between(Field Layout::*, const pbuf_type* records, size_t count, typename Field::unpackedT lo,
+                    typename Field::unpackedT hi, uint64_t* selection) {
+  internals::ScanField<Field, Layout::record_bytes>::run_between(records, count, lo, hi, selection);
+  return selection_count(selection, count);
+}
+
+/// scan - select records of a RecordArray
+template <typename Layout, typename Field, typename View>
+size_t scan(Field Layout::* field, const RecordArray<View>& records, Compare op, typename Field::unpackedT value,
+            uint64_t* selection) {
+  static_assert(std::is_same<Layout, typename View::Layout>::value, "field is not a member of the record layout");
+  return scan(field, records.data(), records.size(), op, value, selection);
+}
+
+/// scan_between - select records of a RecordArray
+template <typename Layout, typename Field, typename View>
+size_t scan_between(Field Layout::* field, const RecordArray<View>& records, typename Field::unpackedT lo,
+                    typename Field::unpackedT hi, uint64_t* selection) {
+  static_assert(std::is_same<Layout, typename View::Layout>::value, "field is not a member of the record layout");
+  return scan_between(field, records.data(), records.size(), lo, hi, selection);
+}
+
+}  // namespace vstruct
+
+#endif  // VSTRUCT_SCAN_H_
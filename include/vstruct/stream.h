@@ -0,0 +1,430 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// This file provides batched streaming of packed records over file descriptors and iostreams
+/// (POSIX only, not included by vstruct.h).
+///
+/// Records are moved in batches of batch_records records, record_bytes apart, through a fixed ring of
+/// reusable buffers. A reader hands out one batch at a time as a RecordArray wrapping the batch buffer,
+/// a writer fills a batch in place through the generated views. There is one read or write call per
+/// batch and no allocation after construction. With prefetch, a background thread reads the next
+/// batches (or writes the previous ones) while the caller decodes the current batch.
+///
+/// Example Usage:
+///
+/// vstruct::RecordReader<Example1> reader{vstruct::FdSource{fd}};
+/// for (auto batch = reader.next(); !batch.empty(); batch = reader.next()) {
+///   for (Example1View v : batch) {
+///     total += v.x4();
+///   }
+/// }
+///
+#ifndef VSTRUCT_STREAM_H_
+#define VSTRUCT_STREAM_H_
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <condition_variable>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+#include "./internals.h"
+#include "./itemtypes.h"
+#include "./records.h"
+
+namespace vstruct {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Sources and sinks, one call moves a whole batch
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// FdSource - read from a file descriptor or pipe, the descriptor is not closed
+struct FdSource {
+  int fd;
+  bool failed = false;
+
+  explicit FdSource(int file): fd(file) {}
+
+  // read up to n bytes, fewer only at the end of the input or on failure
+  size_t read(pbuf_type* p, size_t n) {
+    size_t total = 0;
+    while (total < n) {
+      ssize_t got = ::read(fd, p + total, n - total);
+      if (got > 0) {
+        total += static_cast<size_t>(got);
+      } else if (got == 0) {
+        break;
+      } else if (errno != EINTR) {
+        failed = true;
+        break;
+      }
+    }
+    return total;
+  }
+};
+
+/// IStreamSource - read from a std::istream opened in binary mode
+struct IStreamSource {
+  std::istream* in;
+  bool failed = false;
+
+  explicit IStreamSource(std::istream& stream): in(&stream) {}  // NOLINT(runtime/references)
+
+  size_t read(pbuf_type* p, size_t n) {
+    in->read(reinterpret_cast<char*>(p), static_cast<std::streamsize>(n));
+    failed = in->bad();
+    return static_cast<size_t>(in->gcount());
+  }
+};
+
+/// FdSink - write to a file descriptor or pipe, the descriptor is not closed
+struct FdSink {
+  int fd;
+  bool failed = false;
+
+  explicit FdSink(int file): fd(file) {}
+
+  bool write(const pbuf_type* p, size_t n) {
+    size_t total = 0;
+    while (total < n) {
+      ssize_t put = ::write(fd, p + total, n - total);
+      if (put >= 0) {
+        total += static_cast<size_t>(put);
+      } else if (errno != EINTR) {
+        failed = true;
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+/// OStreamSink - write to a std::ostream opened in binary mode
+struct OStreamSink {
+  std::ostream* out;
+  bool failed = false;
+
+  explicit OStreamSink(std::ostream& stream): out(&stream) {}  // NOLINT(runtime/references)
+
+  bool write(const pbuf_type* p, size_t n) {
+    out->write(reinterpret_cast<const char*>(p), static_cast<std::streamsize>(n));
+    failed = !out->good();
+    return !failed;
+  }
+};
+
+namespace internals {
+
+/// BatchRing - fixed ring of batch buffers handed from a producer to a consumer
+/// Batches are passed in order, the producer blocks while all buffers are full and the consumer
+/// blocks while all are empty. Every buffer is followed by vstruct::slack_bytes spare bytes.
+class BatchRing {
+ public:
+  BatchRing(size_t batch_bytes, size_t batches)
+  : batch_bytes_(batch_bytes), storage_(batches * (batch_bytes + slack_bytes)), bytes_(batches),
+    head_(0), tail_(0), closed_(false) {
+    assert(batches > 0 && "Ring needs at least one batch!");
+  }
+
+  size_t batch_bytes() const {
+    return batch_bytes_;
+  }
+  size_t batches() const {
+    return bytes_.size();
+  }
+  pbuf_type* buffer(size_t seq) {
+    return &storage_[(seq % batches()) * (batch_bytes_ + slack_bytes)];
+  }
+
+  // producer: wait for a free buffer, returns false once the ring is closed
+  bool acquire_free(size_t* seq) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this] { return closed_ || head_ - tail_ < batches(); });
+    *seq = head_;
+    return !closed_;
+  }
+
+  // producer: pass the buffer acquired last to the consumer
+  void publish(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bytes_[head_ % batches()] = bytes;
+    head_++;
+    changed_.notify_all();
+  }
+
+  // consumer: wait for a full buffer, returns false once the ring is closed and drained
+  bool acquire_full(size_t* seq, size_t* bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this] { return closed_ || head_ > tail_; });
+    if (head_ == tail_) {
+      return false;
+    }
+    *seq = tail_;
+    *bytes = bytes_[tail_ % batches()];
+    return true;
+  }
+
+  // consumer: return the buffer acquired last to the producer
+  void release() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tail_++;
+    changed_.notify_all();
+  }
+
+  // wait until the consumer has released every published buffer
+  void drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this] { return head_ == tail_; });
+  }
+
+  // no more batches, wakes both sides
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    changed_.notify_all();
+  }
+
+ private:
+  size_t batch_bytes_;
+  std::vector<pbuf_type> storage_;
+  std::vector<size_t> bytes_;  // bytes in each published buffer
+  size_t head_;  // batches published
+  size_t tail_;  // batches released
+  bool closed_;
+  std::mutex mutex_;
+  std::condition_variable changed_;
+};
+
+}  // namespace internals
+
+/// RecordReader - read records of a generated layout from a stream, a batch at a time
+/// A batch stays valid until the next call to next().
+/// Template args:
+///   Layout: generated struct, provides View and record_bytes
+///   Source: FdSource, IStreamSource or any type with size_t read(pbuf_type*, size_t) and bool failed
+template <typename Layout, typename Source = FdSource>
+class RecordReader {
+ public:
+  typedef typename Layout::View View;
+  typedef RecordArray<View> Batch;
+  enum : size_t {
+    stride = Layout::record_bytes
+  };
+
+  explicit RecordReader(Source source, size_t batch_records = 4096, size_t ring_batches = 4, bool prefetch = true)
+  : source_(source), ring_(batch_records * stride, ring_batches), held_(false), eof_(false), truncated_(false),
+    records_(0) {
+    if (prefetch) {
+      thread_ = std::thread([this] {
+        while (fill()) {}
+      });
+    }
+  }
+
+  RecordReader(const RecordReader&) = delete;
+  RecordReader& operator=(const RecordReader&) = delete;
+
+  ~RecordReader() {
+    ring_.close();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  // next batch of records, empty at the end of the input
+  Batch next() {
+    if (held_) {
+      ring_.release();
+      held_ = false;
+    }
+    if (!thread_.joinable()) {
+      fill();
+    }
+    size_t seq;
+    size_t bytes;
+    if (!ring_.acquire_full(&seq, &bytes)) {
+      return Batch(nullptr, 0);
+    }
+    held_ = true;
+    records_ += bytes / stride;
+    return Batch(ring_.buffer(seq), bytes / stride);
+  }
+
+  // records handed out so far
+  size_t records() const {
+    return records_;
+  }
+
+  // read failed, valid after next() returned an empty batch
+  bool failed() const {
+    return source_.failed;
+  }
+
+  // the input ended inside a record, the partial record is dropped
+  bool truncated() const {
+    return truncated_;
+  }
+
+ private:
+  // read one batch into the ring, returns false at the end of the input
+  bool fill() {
+    size_t seq;
+    if (eof_ || !ring_.acquire_free(&seq)) {
+      return false;
+    }
+    size_t bytes = source_.read(ring_.buffer(seq), ring_.batch_bytes());
+    if (bytes < ring_.batch_bytes()) {
+      eof_ = true;
+      truncated_ = (bytes % stride) != 0;
+      bytes -= bytes % stride;
+    }
+    if (bytes > 0) {
+      ring_.publish(bytes);
+    }
+    if (eof_) {
+      ring_.close();
+    }
+    return !eof_;
+  }
+
+  Source source_;
+  internals::BatchRing ring_;
+  bool held_;  // a batch is handed out
+  bool eof_;
+  bool truncated_;
+  size_t records_;
+  std::thread thread_;
+};
+
+/// RecordWriter - write records of a generated layout to a stream, a batch at a time
+/// Records are built in place in the current batch, full batches are written in order.
+/// Template args:
+///   Layout: generated struct, provides View and record_bytes
+///   Sink: FdSink, OStreamSink or any type with bool write(const pbuf_type*, size_t) and bool failed
+template <typename Layout, typename Sink = FdSink>
+class RecordWriter {
+ public:
+  typedef typename Layout::View View;
+  enum : size_t {
+    stride = Layout::record_bytes
+  };
+
+  explicit RecordWriter(Sink sink, size_t batch_records = 4096, size_t ring_batches = 4, bool background = true)
+  : sink_(sink), ring_(batch_records * stride, ring_batches), seq_(0), count_(0), held_(false), records_(0) {
+    if (background) {
+      thread_ = std::thread([this] {
+        while (drain_one()) {}
+      });
+    }
+  }
+
+  RecordWriter(const RecordWriter&) = delete;
+  RecordWriter& operator=(const RecordWriter&) = delete;
+
+  ~RecordWriter() {
+    close();
+  }
+
+  // append a zero filled record, valid until the next push_back or flush
+  View push_back() {
+    if (held_ && count_ * stride == ring_.batch_bytes()) {  // the last record of a full batch is written now
+      submit();
+    }
+    if (!held_) {
+      bool open = ring_.acquire_free(&seq_);
+      assert(open && "Writer is closed!");
+      (void)open;
+      held_ = true;
+      count_ = 0;
+    }
+    pbuf_type* pRecord = ring_.buffer(seq_) + count_ * stride;
+    memset(pRecord, 0, stride);
+    count_++;
+    records_++;
+    return View(pRecord);
+  }
+
+  // append a copy of the record at pRecord
+  void push_back(const pbuf_type* pRecord) {
+    memcpy(push_back().getBuffer(), pRecord, stride);
+  }
+
+  // write every record appended so far
+  bool flush() {
+    if (held_ && count_ > 0) {
+      submit();
+    }
+    if (thread_.joinable()) {
+      ring_.drain();
+    }
+    return !sink_.failed;
+  }
+
+  // flush and stop the background thread
+  bool close() {
+    if (closed_) {
+      return !sink_.failed;
+    }
+    bool ok = flush();
+    closed_ = true;
+    ring_.close();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+    return ok;
+  }
+
+  // records appended so far
+  size_t records() const {
+    return records_;
+  }
+
+  bool failed() const {
+    return sink_.failed;
+  }
+
+ private:
+  // pass the current batch on, written inline without a background thread
+  void submit() {
+    ring_.publish(count_ * stride);
+    held_ = false;
+    if (!thread_.joinable()) {
+      drain_one();
+    }
+  }
+
+  // write one published batch, returns false once the ring is closed
+  bool drain_one() {
+    size_t seq;
+    size_t bytes;
+    if (!ring_.acquire_full(&seq, &bytes)) {
+      return false;
+    }
+    if (!sink_.failed) {
+      sink_.write(ring_.buffer(seq), bytes);
+    }
+    ring_.release();
+    return true;
+  }
+
+  Sink sink_;
+  internals::BatchRing ring_;
+  size_t seq_;  // batch being filled
+  size_t count_;  // records in the batch being filled
+  bool held_;
+  bool closed_ = false;
+  size_t records_;
+  std::thread thread_;
+};
+
+}  // namespace vstruct
+
+#endif  // VSTRUCT_STREAM_H_
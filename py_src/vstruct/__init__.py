@@ -1 +1 @@
-from ._classes import Type, VStruct, BoolItem, BoolArray, LEItem, LEArray, AlignPad
\ No newline at end of file
+from ._classes import Type, VStruct, BoolItem, BoolArray, LEItem, LEArray, BEItem, BEArray, AlignPad
\ No newline at end of file
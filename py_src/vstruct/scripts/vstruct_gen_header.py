@@ -1,172 +1,410 @@
-import sys
-import os
-import argparse
-from collections import OrderedDict
-import inspect
-import importlib.util
-import vstruct
-
-
-def header_guard(args):
-    if args.guard is None:
-        s = args.output.name.upper().replace(
-            "\\", "_").replace("/", "_").replace(" ", "_").replace(
-            ".", "_") + "_"
-    else:
-        s = args.guard
-    return s
-
-
-def header_start(args, code_obj, modules):
-    c = code_obj
-    d = OrderedDict()
-    c.comment("*** THIS FILE IS AUTO GENERATED BY {} ***".format(
-        os.path.split(__file__)[-1]))
-    c.comment('')
-    for m in modules:
-        d[m.__file__] = m.__doc__
-    for f, doc in d.items():
-        c.comment(
-            os.path.split(f)[-1])
-        c.comments(doc.splitlines())
-        c.comment("")
-        c.comment("")
-    c.code("#ifndef {}".format(header_guard(args)))
-    c.code("#define {}".format(header_guard(args)))
-    c.code("#include \"vstruct.h\"")
-    c.blank_line()
-    # File level namespace
-    if args.namespace is not None:
-        for n in args.namespace:
-            c.code("namespace {}".format(n) + " {")
-    c.blank_lines(2)
-
-
-def header_end(args, code_obj):
-    c = code_obj
-    # close namespaces
-    c.blank_lines(1)
-    if args.namespace is not None:
-        for n in list(args.namespace)[::-1]:
-            c.code("}")
-            c.inline_comment("namespace {}".format(n))
-    c.blank_lines(2)
-    c.code("#endif")
-    c.inline_comment(header_guard(args))
-    c.blank_line()
-
-
-def header_structs(args, code_obj, struct):
-    c = code_obj
-    S = struct
-    S.build()
-    c.comments(S._comments)
-    c.code("struct {} : public vstruct::VStruct".format(
-        S.__name__) + " {")
-    c.indent()
-    for item in S.items():
-        c.comments(item.get_comments())
-        c.code(item.get_code())
-        c.blank_line()
-    c.dedent()
-    c.code("};")
-    c.inline_comment(S.__name__)
-    c.blank_lines(2)
-
-
-def main():
-    parser = argparse.ArgumentParser(
-        description="generate C++ header based on vstructs in source file")
-    parser.add_argument(
-        '-f', '--files',  nargs='*', type=argparse.FileType('r'),
-        help="Source .py files to parse")
-    parser.add_argument(
-        '-o', '--output', type=argparse.FileType('w'),
-        help="Output header file to generate")
-    parser.add_argument(
-        '-n', '--namespace', nargs='*',
-        help="namespaces for header")
-    parser.add_argument(
-        '-g', '--guard', type=str,
-        help="custom header guard, if option is not given,"
-             " defaults to a pattern generated from the output filename")
-    args = parser.parse_args()
-
-    assert args.output is not None, "Missing argument --output"
-
-    code_obj = Code()
-    modules = []
-    for i, f in enumerate(args.files):
-        dir_path = os.path.abspath(os.path.split(f.name)[0])
-        module_name = os.path.split(f.name)[-1].split('.')[0]
-        sys.path.insert(0, dir_path)
-        try:
-            m = importlib.import_module(module_name, module_name)
-            modules.append(m)
-        finally:
-            del sys.path[0]
-    header_start(args, code_obj, modules)
-    for m in modules:
-        f = inspect.getfile(m)
-        for obj_name in dir(m):
-            try:
-                obj = m.__dict__[obj_name]
-                issubclass(obj, vstruct.VStruct)
-            except:
-                continue
-            if (inspect.isclass(obj)   # only classes
-                    and issubclass(obj, vstruct.VStruct)
-                    and obj != vstruct.VStruct):  # expect not equal
-                header_structs(args, code_obj, obj)
-    header_end(args, code_obj)
-    for cc in code_obj._code:
-        args.output.writelines(cc + '\n')
-        print(cc)
-
-
-class Code(object):
-    def __init__(self):
-        self._indent = 0
-        self._code = []
-        self._indent_char = "  "
-
-    def set_indent_char(self, str):
-        self._indent_char = str
-
-    def indent(self):
-        self._indent += 1
-
-    def dedent(self):
-        if self._indent > 0:
-            self._indent -= 1
-
-    def comments(self, list_of_str):
-        for str in list_of_str:
-            self.comment(str)
-
-    def comment(self, str):
-        self._code.append(r"{}/// {}".format(
-            self._indent * self._indent_char, str.rstrip()))
-
-    def codes(self, list_of_str):
-        for str in list_of_str:
-            self.code(str)
-
-    def code(self, str):
-        self._code.append(r"{}{}".format(
-            self._indent * self._indent_char, str.rstrip()))
-
-    def inline_comment(self, str):
-        self._code[-1] += r"  // {}".format(
-            str.rstrip())
-
-    def blank_lines(self, number_of_lines):
-        for _ in range(number_of_lines):
-            self.blank_line()
-
-    def blank_line(self):
-        self._code.append("{}".format(
-            self._indent * self._indent_char))
-
-if __name__ == "__main__":
-    main()
+import sys
+import os
+import argparse
+import json
+from collections import OrderedDict
+import inspect
+import importlib.util
+import vstruct
+
+
+def header_guard(args):
+    if args.guard is None:
+        s = args.output.name.upper().replace(
+            "\\", "_").replace("/", "_").replace(" ", "_").replace(
+            ".", "_") + "_"
+    else:
+        s = args.guard
+    return s
+
+
+def header_start(args, code_obj, modules):
+    c = code_obj
+    d = OrderedDict()
+    c.comment("*** THIS FILE IS AUTO GENERATED BY {} ***".format(
+        os.path.split(__file__)[-1]))
+    c.comment('')
+    for m in modules:
+        d[m.__file__] = m.__doc__
+    for f, doc in d.items():
+        c.comment(
+            os.path.split(f)[-1])
+        c.comments(doc.splitlines())
+        c.comment("")
+        c.comment("")
+    c.code("#ifndef {}".format(header_guard(args)))
+    c.code("#define {}".format(header_guard(args)))
+    c.code("#include \"vstruct.h\"")
+    c.blank_line()
+    # File level namespace
+    if args.namespace is not None:
+        for n in args.namespace:
+            c.code("namespace {}".format(n) + " {")
+    c.blank_lines(2)
+
+
+def header_end(args, code_obj):
+    c = code_obj
+    # close namespaces
+    c.blank_lines(1)
+    if args.namespace is not None:
+        for n in list(args.namespace)[::-1]:
+            c.code("}")
+            c.inline_comment("namespace {}".format(n))
+    c.blank_lines(2)
+    c.code("#endif")
+    c.inline_comment(header_guard(args))
+    c.blank_line()
+
+
+NAME_CHAIN = 16  # longest (i == n) ? chain in field_name, longer lists are split in halves
+
+
+def name_lookup(names, first, last):
+    """ lines of the field_name expression for names[first:last]
+
+    A chain of conditionals nests once per name and the compiler parses it in quadratic time,
+    so long lists are split by (i < mid) into a tree nested log2(n) deep.
+    """
+    if last - first <= NAME_CHAIN:
+        return ["(i == {}) ? \"{}\" :".format(i, names[i]) for i in range(first, last)] + ["\"\""]
+    mid = (first + last) // 2
+    return (["(i < {}) ? (".format(mid)] + ["  " + line for line in name_lookup(names, first, mid)] +
+            [") : ("] + ["  " + line for line in name_lookup(names, mid, last)] + [")"])
+
+
+def header_structs(args, code_obj, struct):
+    c = code_obj
+    S = struct
+    S.build()
+    c.code("struct {}View;".format(S.__name__))
+    c.code("struct {}ConstView;".format(S.__name__))
+    c.code("struct {}Native;".format(S.__name__))
+    c.blank_line()
+    c.comments(S._comments)
+    c.code("struct {} : public vstruct::VStruct".format(
+        S.__name__) + " {")
+    c.indent()
+    last = None
+    for item in S.items():
+        c.comments(item.get_comments())
+        c.code(item.get_code())
+        c.blank_line()
+        last = item
+    fields = ["decltype({})".format(item.get_name())
+              for item in S.items() if item.has_storage()]
+    if fields:
+        c.code("using field_types = vstruct::FieldList<")
+        c.indent()
+        c.indent()
+        c.codes([f + "," for f in fields[:-1]] + [fields[-1] + ">;"])
+        c.dedent()
+        c.dedent()
+        names = [item.get_name() for item in S.items() if item.has_storage()]
+        c.code("static constexpr const char* field_name(size_t i) {  // names of field_types")
+        c.indent()
+        c.code("return")
+        c.indent()
+        c.indent()
+        lookup = name_lookup(names, 0, len(names))
+        c.codes(lookup[:-1] + [lookup[-1] + ";"])
+        c.dedent()
+        c.dedent()
+        c.dedent()
+        c.code("}")
+    if last is not None:
+        c.code("enum : size_t {")
+        c.indent()
+        c.code("record_bits = decltype({})::next_bit,".format(last.get_name()))
+        c.code("record_bytes = (record_bits + 7) >> 3  // stride of consecutive records")
+        c.dedent()
+        c.code("};")
+    c.code("using View = {}View;".format(S.__name__))
+    c.code("using ConstView = {}ConstView;".format(S.__name__))
+    c.code("using Native = {}Native;".format(S.__name__))
+    c.dedent()
+    c.code("};")
+    c.inline_comment(S.__name__)
+    c.blank_lines(2)
+    header_view(args, code_obj, struct)
+    header_view(args, code_obj, struct, read_only=True)
+    header_native(args, code_obj, struct)
+
+
+def header_view(args, code_obj, struct, read_only=False):
+    c = code_obj
+    S = struct
+    if read_only:
+        view_name = "{}ConstView".format(S.__name__)
+        base_name = "ConstVStructView"
+        field_alias = "vstruct::ConstViewField"
+        c.comment("{} - read only view of {}, over a const buffer".format(
+            view_name, S.__name__))
+    else:
+        view_name = "{}View".format(S.__name__)
+        base_name = "VStructView"
+        field_alias = "vstruct::ViewField"
+        c.comment("{} - stateless view of {}, holds only the buffer pointer".format(
+            view_name, S.__name__))
+    c.code("struct {} : public vstruct::{}".format(view_name, base_name) + " {")
+    c.indent()
+    c.code("using {}::{};".format(base_name, base_name))
+    c.code("using Layout = {};".format(S.__name__))
+    c.code("using field_types = Layout::field_types;")
+    c.code("enum : size_t {")
+    c.indent()
+    c.code("record_bits = Layout::record_bits,")
+    c.code("record_bytes = Layout::record_bytes")
+    c.dedent()
+    c.code("};")
+    c.blank_line()
+    for item in S.items():
+        view_code = item.get_view_code(S.__name__, field_alias)
+        if view_code:
+            c.codes(view_code)
+            c.blank_line()
+    c.dedent()
+    c.code("};")
+    c.inline_comment(view_name)
+    c.blank_lines(2)
+
+
+def span_loads(nbytes):
+    """ loads of a SpanAccess of nbytes, split into power of 2 moves """
+    return bin(nbytes).count("1")
+
+
+def element_loads(first_bit, bit_size):
+    """ loads of a fixed offset access (LEOrderAt) of one element """
+    total_bytes = ((first_bit & 7) + bit_size + 7) >> 3
+    spill = total_bytes > 8
+    return span_loads(8 if spill else total_bytes) + (1 if spill else 0)
+
+
+def decode_windows(struct):
+    """ group the elements of struct into 64 bit windows, in bit order, big endian
+    elements are always accessed on their own.
+    returns a list of (base_byte, nbytes, elements), base_byte is None for an
+    element accessed on its own. elements are (item, index, first_bit)
+    """
+    S = struct
+    elements = []
+    last = None
+    for item in S.items():
+        last = item
+        if not item.has_storage():
+            continue
+        for k in range(item._array_size):
+            elements.append((item, k, item._start_bit + k * item._bit_size))
+    record_bytes = (last._next_bit + 7) >> 3 if last is not None else 0
+    windows = []
+    i = 0
+    while i < len(elements):
+        item, k, first_bit = elements[i]
+        base_byte = first_bit >> 3
+        if (first_bit & 7) + item._bit_size > 64 or item._big_endian:
+            windows.append((None, None, [elements[i]]))
+            i += 1
+            continue
+        group = []
+        while i < len(elements):
+            item, k, first_bit = elements[i]
+            if first_bit + item._bit_size - (base_byte << 3) > 64 or item._big_endian:
+                break
+            group.append(elements[i])
+            i += 1
+        end_bit = max(e[2] + e[0]._bit_size for e in group)
+        needed = (end_bit - (base_byte << 3) + 7) >> 3
+        nbytes = 1
+        while nbytes < needed:
+            nbytes <<= 1
+        if base_byte + nbytes > record_bytes:  # stay within the record
+            nbytes = needed
+        windows.append((base_byte, nbytes, group))
+    return windows
+
+
+def decode_report(struct, windows):
+    """ loads per full decode with shared windows, and with one access per element """
+    shared = 0
+    single = 0
+    for base_byte, nbytes, group in windows:
+        if base_byte is None:
+            shared += element_loads(group[0][2], group[0][0]._bit_size)
+        else:
+            shared += span_loads(nbytes)
+        for item, k, first_bit in group:
+            single += element_loads(first_bit, item._bit_size)
+    return shared, single
+
+
+def element_code(S, item, k, base_byte, prefix):
+    """ template arguments and native member of an element """
+    target = "{}.{}".format(prefix, item.get_name())
+    if item._array_size > 1:
+        target += "[{}]".format(k)
+    field = "decltype({}::{}), {}".format(S.__name__, item.get_name(), k)
+    if base_byte is not None:
+        field += ", {}".format(base_byte)
+    return field, target
+
+
+def header_native(args, code_obj, struct):
+    c = code_obj
+    S = struct
+    native_name = "{}Native".format(S.__name__)
+    items = [item for item in S.items() if item.has_storage()]
+    windows = decode_windows(S)
+    shared, single = decode_report(S, windows)
+    report = "{} loads in {} window{}, {} with one access per element".format(
+        shared, len(windows), "" if len(windows) == 1 else "s", single)
+    sys.stderr.write("{}: {}\n".format(S.__name__, report))
+    c.comment("{} - unpacked copy of {}, one native member per field".format(
+        native_name, S.__name__))
+    c.code("struct {}".format(native_name) + " {")
+    c.indent()
+    for item in items:
+        c.code(item.get_native_code())
+    c.dedent()
+    c.code("};")
+    c.inline_comment(native_name)
+    c.blank_line()
+    c.comment("decode a whole {} record at pRecord".format(S.__name__))
+    c.comment(report)
+    c.code("inline void load(const vstruct::pbuf_type* pRecord, {}& out) {{  // NOLINT(runtime/references)".format(
+        native_name))
+    c.indent()
+    for w, (base_byte, nbytes, group) in enumerate(windows):
+        if base_byte is None:
+            field, target = element_code(S, group[0][0], group[0][1], None, "out")
+            c.code("vstruct::load_element<{}>(pRecord, {});".format(field, target))
+            continue
+        c.code("const uint64_t w{} = vstruct::load_window<{}, {}>(pRecord);".format(w, base_byte, nbytes))
+        for item, k, first_bit in group:
+            field, target = element_code(S, item, k, base_byte, "out")
+            c.code("vstruct::window_get<{}>(w{}, {});".format(field, w, target))
+    c.dedent()
+    c.code("}")
+    c.blank_line()
+    c.comment("encode a whole {} record to pRecord, padding bits are left as they are".format(S.__name__))
+    c.code("inline void store(const {}& in, vstruct::pbuf_type* pRecord) {{".format(native_name))
+    c.indent()
+    for w, (base_byte, nbytes, group) in enumerate(windows):
+        if base_byte is None:
+            field, target = element_code(S, group[0][0], group[0][1], None, "in")
+            c.code("vstruct::store_element<{}>(pRecord, {});".format(field, target))
+            continue
+        c.code("uint64_t w{} = vstruct::load_window<{}, {}>(pRecord);".format(w, base_byte, nbytes))
+        for item, k, first_bit in group:
+            field, target = element_code(S, item, k, base_byte, "in")
+            c.code("w{} = vstruct::window_set<{}>(w{}, {});".format(w, field, w, target))
+        c.code("vstruct::store_window<{}, {}>(pRecord, w{});".format(base_byte, nbytes, w))
+    c.dedent()
+    c.code("}")
+    c.blank_lines(2)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="generate C++ header based on vstructs in source file")
+    parser.add_argument(
+        '-f', '--files',  nargs='*', type=argparse.FileType('r'),
+        help="Source .py files to parse")
+    parser.add_argument(
+        '-o', '--output', type=argparse.FileType('w'),
+        help="Output header file to generate")
+    parser.add_argument(
+        '-n', '--namespace', nargs='*',
+        help="namespaces for header")
+    parser.add_argument(
+        '-s', '--schema', type=argparse.FileType('w'),
+        help="also write the layouts as a JSON schema for vstruct::DynamicLayout")
+    parser.add_argument(
+        '-g', '--guard', type=str,
+        help="custom header guard, if option is not given,"
+             " defaults to a pattern generated from the output filename")
+    args = parser.parse_args()
+
+    assert args.output is not None, "Missing argument --output"
+
+    code_obj = Code()
+    modules = []
+    for i, f in enumerate(args.files):
+        dir_path = os.path.abspath(os.path.split(f.name)[0])
+        module_name = os.path.split(f.name)[-1].split('.')[0]
+        sys.path.insert(0, dir_path)
+        try:
+            m = importlib.import_module(module_name, module_name)
+            modules.append(m)
+        finally:
+            del sys.path[0]
+    header_start(args, code_obj, modules)
+    schemas = []
+    for m in modules:
+        f = inspect.getfile(m)
+        for obj_name in dir(m):
+            try:
+                obj = m.__dict__[obj_name]
+                issubclass(obj, vstruct.VStruct)
+            except:
+                continue
+            if (inspect.isclass(obj)   # only classes
+                    and issubclass(obj, vstruct.VStruct)
+                    and obj != vstruct.VStruct):  # expect not equal
+                header_structs(args, code_obj, obj)
+                schemas.append(obj.schema())
+    header_end(args, code_obj)
+    if args.schema is not None:
+        json.dump(schemas, args.schema, indent=1)
+        args.schema.write('\n')
+    for cc in code_obj._code:
+        args.output.writelines(cc + '\n')
+        print(cc)
+
+
+class Code(object):
+    def __init__(self):
+        self._indent = 0
+        self._code = []
+        self._indent_char = "  "
+
+    def set_indent_char(self, str):
+        self._indent_char = str
+
+    def indent(self):
+        self._indent += 1
+
+    def dedent(self):
+        if self._indent > 0:
+            self._indent -= 1
+
+    def comments(self, list_of_str):
+        for str in list_of_str:
+            self.comment(str)
+
+    def comment(self, str):
+        self._code.append(r"{}/// {}".format(
+            self._indent * self._indent_char, str.rstrip()))
+
+    def codes(self, list_of_str):
+        for str in list_of_str:
+            self.code(str)
+
+    def code(self, str):
+        self._code.append(r"{}{}".format(
+            self._indent * self._indent_char, str.rstrip()))
+
+    def inline_comment(self, str):
+        self._code[-1] += r"  // {}".format(
+            str.rstrip())
+
+    def blank_lines(self, number_of_lines):
+        for _ in range(number_of_lines):
+            self.blank_line()
+
+    def blank_line(self):
+        self._code.append("{}".format(
+            self._indent * self._indent_char))
+
+if __name__ == "__main__":
+    main()
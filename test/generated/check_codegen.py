@@ -0,0 +1,78 @@
+""" check_codegen.py
+
+copyright Joseph Lee Yuan Sheng 2019
+
+Compares the assembly of each vstruct_<name> function against hand_<name>
+in the assembly file produced from codegen_example1.cpp.
+
+A vstruct accessor passes when it has no branch or call, does the same
+memory accesses as the hand written shifts, and uses at most
+SLACK_INSTRUCTIONS more instructions (register allocation differences).
+"""
+import re
+import sys
+
+SLACK_INSTRUCTIONS = 1
+BRANCH = re.compile(r'^(j[a-z]*|call|b|b\.[a-z]+|bl|cbz|cbnz|tbz|tbnz)$')
+
+
+def read_functions(filename):
+    functions = {}
+    current = None
+    for line in open(filename):
+        label = re.match(r'^([A-Za-z_]\w*):', line)
+        if label:
+            current = label.group(1)
+            functions[current] = []
+            continue
+        line = line.split('#')[0].strip()
+        if current is None or not line or line.startswith('.'):
+            continue
+        functions[current].append(re.sub(r'\s+', ' ', line))
+    return functions
+
+
+def memory_accesses(instructions):
+    """ (address, is_store) of each memory operand, registers are ignored """
+    accesses = []
+    for i in instructions:
+        operands = i.split(' ', 1)[-1]
+        for address in re.findall(r'-?\w*\(%\w+\)|\[[^\]]*\]', operands):
+            accesses.append((address, operands.rstrip().endswith(address)))
+    return sorted(accesses)
+
+
+def check(functions, name):
+    vstruct_code = functions[name]
+    hand_code = functions['hand_' + name[len('vstruct_'):]]
+    errors = []
+    branches = [i for i in vstruct_code if BRANCH.match(i.split(' ')[0])]
+    if branches:
+        errors.append("branch in accessor: {}".format(branches))
+    if memory_accesses(vstruct_code) != memory_accesses(hand_code):
+        errors.append("memory access differs: {} != {}".format(
+            memory_accesses(vstruct_code), memory_accesses(hand_code)))
+    if len(vstruct_code) > len(hand_code) + SLACK_INSTRUCTIONS:
+        errors.append("{} instructions, hand written uses {}".format(
+            len(vstruct_code), len(hand_code)))
+    return errors
+
+
+def main():
+    functions = read_functions(sys.argv[1])
+    names = sorted(n for n in functions if n.startswith('vstruct_'))
+    assert names, "no vstruct_* functions found"
+    failed = 0
+    for name in names:
+        errors = check(functions, name)
+        print("{:20} {}".format(name, "FAILED" if errors else "OK"))
+        for e in errors:
+            print("    " + e)
+        if errors:
+            failed += 1
+            print("\n".join("    | " + i for i in functions[name]))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,117 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+/// Compiled to assembly only, check_codegen.py compares each vstruct_* function
+/// against the hand written hand_* function with the same suffix.
+/// Bit positions of the hand written functions are taken from the layout comment of example1.h
+///
+#include <stdint.h>
+#include <string.h>
+#include "gen/example1.h"
+
+namespace {
+
+using Example1 = outer_ns::inner_ns::Example1;
+
+template <typename Item>
+struct Access {
+  using type = vstruct::internals::LEOrderAt<typename Item::packedT, Item::Sz, Item::bits>;
+};
+
+// plain fixed width moves
+inline uint64_t load16(const uint8_t* p) { uint16_t x; memcpy(&x, p, 2); return x; }
+inline uint64_t load32(const uint8_t* p) { uint32_t x; memcpy(&x, p, 4); return x; }
+inline uint64_t load64(const uint8_t* p) { uint64_t x; memcpy(&x, p, 8); return x; }
+inline void store16(uint8_t* p, uint64_t x) { uint16_t y = x; memcpy(p, &y, 2); }
+inline void store32(uint8_t* p, uint64_t x) { uint32_t y = x; memcpy(p, &y, 4); }
+inline void store64(uint8_t* p, uint64_t x) { memcpy(p, &x, 8); }
+
+}  // namespace
+
+#define VSTRUCT_GET(name) \
+  extern "C" uint64_t vstruct_get_##name(const uint8_t* p) { \
+    return Access<decltype(Example1::name)>::type::get(p); \
+  }
+#define VSTRUCT_SET(name) \
+  extern "C" void vstruct_set_##name(uint8_t* p, uint64_t x) { \
+    Access<decltype(Example1::name)>::type::set(p, x); \
+  }
+
+VSTRUCT_GET(x0)  // [2].0 ... [2].1
+VSTRUCT_GET(x1)  // [2].2 ... [2].4
+VSTRUCT_GET(x2)  // [2].5 ... [4].2
+VSTRUCT_GET(x3)  // [4].3 ... [6].1
+VSTRUCT_GET(x4)  // [6].2 ... [9].3
+VSTRUCT_GET(x5)  // [9].4 ... [12].6
+VSTRUCT_GET(x6)  // [12].7 ... [20].0
+VSTRUCT_GET(x7)  // [20].1 ... [27].3
+
+VSTRUCT_SET(x0)
+VSTRUCT_SET(x1)
+VSTRUCT_SET(x2)
+VSTRUCT_SET(x3)
+VSTRUCT_SET(x4)
+VSTRUCT_SET(x5)
+VSTRUCT_SET(x6)
+VSTRUCT_SET(x7)
+
+extern "C" uint64_t hand_get_x0(const uint8_t* p) {
+  return p[2] & 0x3;
+}
+extern "C" uint64_t hand_get_x1(const uint8_t* p) {
+  return (p[2] >> 2) & 0x7;
+}
+extern "C" uint64_t hand_get_x2(const uint8_t* p) {
+  return ((load16(p + 2) | (static_cast<uint64_t>(p[4]) << 16)) >> 5) & 0x3fff;
+}
+extern "C" uint64_t hand_get_x3(const uint8_t* p) {
+  return ((load16(p + 4) | (static_cast<uint64_t>(p[6]) << 16)) >> 3) & 0x7fff;
+}
+extern "C" uint64_t hand_get_x4(const uint8_t* p) {
+  return (load32(p + 6) >> 2) & 0x3ffffff;
+}
+extern "C" uint64_t hand_get_x5(const uint8_t* p) {
+  return (load32(p + 9) >> 4) & 0x7ffffff;
+}
+extern "C" uint64_t hand_get_x6(const uint8_t* p) {
+  return ((load64(p + 12) >> 7) | (static_cast<uint64_t>(p[20]) << 57)) & 0x3ffffffffffffff;
+}
+extern "C" uint64_t hand_get_x7(const uint8_t* p) {
+  return (load64(p + 20) >> 1) & 0x7ffffffffffffff;
+}
+
+extern "C" void hand_set_x0(uint8_t* p, uint64_t x) {
+  p[2] = (p[2] & ~0x3) | (x & 0x3);
+}
+extern "C" void hand_set_x1(uint8_t* p, uint64_t x) {
+  p[2] = (p[2] & ~(0x7 << 2)) | ((x & 0x7) << 2);
+}
+extern "C" void hand_set_x2(uint8_t* p, uint64_t x) {
+  uint64_t w = load16(p + 2) | (static_cast<uint64_t>(p[4]) << 16);
+  w = (w & ~(0x3fffull << 5)) | ((x & 0x3fff) << 5);
+  store16(p + 2, w);
+  p[4] = w >> 16;
+}
+extern "C" void hand_set_x3(uint8_t* p, uint64_t x) {
+  uint64_t w = load16(p + 4) | (static_cast<uint64_t>(p[6]) << 16);
+  w = (w & ~(0x7fffull << 3)) | ((x & 0x7fff) << 3);
+  store16(p + 4, w);
+  p[6] = w >> 16;
+}
+extern "C" void hand_set_x4(uint8_t* p, uint64_t x) {
+  store32(p + 6, (load32(p + 6) & ~(0x3ffffffull << 2)) | ((x & 0x3ffffff) << 2));
+}
+extern "C" void hand_set_x5(uint8_t* p, uint64_t x) {
+  store32(p + 9, (load32(p + 9) & ~(0x7ffffffull << 4)) | ((x & 0x7ffffff) << 4));
+}
+extern "C" void hand_set_x6(uint8_t* p, uint64_t x) {
+  x &= 0x3ffffffffffffff;
+  store64(p + 12, (load64(p + 12) & ~(0x3ffffffffffffffull << 7)) | (x << 7));
+  p[20] = (p[20] & ~(0x3ffffffffffffffull >> 57)) | (x >> 57);
+}
+extern "C" void hand_set_x7(uint8_t* p, uint64_t x) {
+  store64(p + 20, (load64(p + 20) & ~(0x7ffffffffffffffull << 1)) | ((x & 0x7ffffffffffffff) << 1));
+}
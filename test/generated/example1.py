@@ -3,7 +3,7 @@
 copyright Joseph Lee Yuan Sheng 2019
 
 """
-from vstruct import BoolItem, AlignPad, LEItem, LEArray, Type, VStruct
+from vstruct import BoolItem, AlignPad, LEItem, LEArray, BEItem, BEArray, Type, VStruct
 
 
 class Example1(VStruct):
@@ -43,3 +43,32 @@ class Example1(VStruct):
     pad4 = AlignPad(4)  # Pad to 4 bytes
 
 
+
+
+class Sensor1(VStruct):
+    """ Sensor1
+
+    37 bit record, not a whole number of bytes
+    """
+    valid = BoolItem()
+    channel = LEItem(Type.uint8_t, bit_size=4)
+    value = LEItem(Type.int32_t, bit_size=20)
+    stamp = LEItem(Type.uint16_t, bit_size=12)
+
+
+class Packet1(VStruct):
+    """ Packet1
+
+    network order header with a little endian payload, the byte orders
+    are separated by padding
+    """
+    version = BEItem(Type.uint8_t, bit_size=4)
+    flags = BEItem(Type.uint8_t, bit_size=4)
+    length = BEItem(Type.uint16_t)
+    seq = BEItem(Type.uint32_t, bit_size=24)
+    offsets = BEArray(Type.int16_t, bit_size=12, array_size=5)
+    stamp = BEItem(Type.uint64_t, bit_size=61)  # reaches into a 9th byte
+    pad0 = AlignPad(1)
+    payload = LEItem(Type.int32_t, bit_size=20)
+    pad1 = AlignPad(1)
+    crc = BEItem(Type.uint32_t)
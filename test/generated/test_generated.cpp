@@ -8,13 +8,27 @@
 ///
 ///
 
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <type_traits>
 #include <vector>
 #include "gtest/gtest.h"
 #include "gen/example1.h"
+#include "vstruct/dense.h"
+#include "vstruct/dynamic.h"
+#include "vstruct/mapped.h"
+#include "vstruct/stream.h"
 // #include "gen/teststruct2.h"
 // #include "gen/teststruct3.h"
 
 using TestStruct = outer_ns::inner_ns::Example1;
+using TestView = outer_ns::inner_ns::Example1View;
+using TestRecords = vstruct::RecordArray<TestView>;
 // using TestStruct2;
 // using TestStruct3;
 
@@ -73,6 +87,949 @@ TEST(GenTest1, TestContinuity){
   EXPECT_EQ(S.dbl.next_bit, S.arr_flt.bits);
 }
 
+// bit positions as listed in the layout comment of the generated header
+TEST(GenTest1, TestPosition){
+  EXPECT_EQ(0, S.b0.bits);
+  EXPECT_EQ(1, S.b1.bits);
+  EXPECT_EQ(2, S.b2.bits);
+  EXPECT_EQ(16, S.pad2.next_bit);
+  EXPECT_EQ(16, S.x0.bits);
+  EXPECT_EQ(18, S.x1.bits);
+  EXPECT_EQ(21, S.x2.bits);
+  EXPECT_EQ(35, S.x3.bits);
+  EXPECT_EQ(50, S.x4.bits);
+  EXPECT_EQ(76, S.x5.bits);
+  EXPECT_EQ(103, S.x6.bits);
+  EXPECT_EQ(161, S.x7.bits);
+  EXPECT_EQ(220, S.arr0.bits);
+  EXPECT_EQ(232, S.arr1.bits);
+  EXPECT_EQ(353, S.arr2.bits);
+  EXPECT_EQ(544, S.flt.bits);
+  EXPECT_EQ(576, S.dbl.bits);
+  EXPECT_EQ(640, S.arr_flt.bits);
+  EXPECT_EQ(768, S.arr_dbl.bits);
+  EXPECT_EQ(1024, S.pad4.next_bit);
+  EXPECT_EQ(128, S.arr_dbl.total_bytes);
+}
+
+TEST(GenTest1, TestSetGet){
+  std::vector<vstruct::pbuf_type> buf(128, 0xa5);
+  TestStruct s;
+  s.setBuffer(buf.data());
+  s.x0 = 3;
+  s.x1 = -4;
+  s.x2 = 0x2345;
+  s.x3 = -0x1234;
+  s.x4 = 0x3456789;
+  s.x5 = -0x3456789;
+  s.x6 = 0x23456789abcdef0;
+  s.x7 = -0x23456789abcdef0;
+  s.arr1[10] = -1000;
+  s.dbl = 0.25;
+  EXPECT_EQ(3, s.x0);
+  EXPECT_EQ(-4, s.x1);
+  EXPECT_EQ(0x2345, s.x2);
+  EXPECT_EQ(-0x1234, s.x3);
+  EXPECT_EQ(0x3456789, s.x4);
+  EXPECT_EQ(-0x3456789, s.x5);
+  EXPECT_EQ(0x23456789abcdef0, s.x6);
+  EXPECT_EQ(-0x23456789abcdef0, s.x7);
+  EXPECT_EQ(-1000, s.arr1[10]);
+  EXPECT_EQ(0.25, s.dbl);
+  EXPECT_EQ(0xa5, buf[1]);  // padding untouched
+  EXPECT_EQ(0xa5, buf[67]);
+}
+
+TEST(GenTest1, TestViewSize){
+  EXPECT_EQ(sizeof(vstruct::pbuf_type*), sizeof(TestView));
+  EXPECT_TRUE(std::is_trivially_copyable<TestView>::value);
+}
+
+// view and struct attached to the same buffer see the same values
+TEST(GenTest1, TestView){
+  std::vector<vstruct::pbuf_type> buf(128, 0xa5);
+  TestStruct s;
+  s.setBuffer(buf.data());
+  TestView v(buf.data());
+  v.b1() = true;
+  v.x0() = 2;
+  v.x1() = -3;
+  v.x4() = 0x3456789;
+  v.x7() = -0x23456789abcdef0;
+  v.arr1()[3] = -1000;
+  v.arr_flt()[1] = 1.5f;
+  EXPECT_TRUE(s.b1);
+  EXPECT_EQ(2, s.x0);
+  EXPECT_EQ(-3, s.x1);
+  EXPECT_EQ(0x3456789, s.x4);
+  EXPECT_EQ(-0x23456789abcdef0, s.x7);
+  EXPECT_EQ(-1000, s.arr1[3]);
+  EXPECT_EQ(1.5f, s.arr_flt[1]);
+  s.x5 = -0x1234567;
+  s.dbl = -0.5;
+  EXPECT_EQ(-0x1234567, v.x5());
+  EXPECT_EQ(-0.5, v.dbl());
+  EXPECT_EQ(0xa5, buf[1]);  // padding untouched
+
+  // copying a view copies the pointer, assigning a field copies the value
+  std::vector<vstruct::pbuf_type> buf2(128, 0);
+  TestView v2 = v;
+  EXPECT_EQ(buf.data(), v2.getBuffer());
+  v2.setBuffer(buf2.data());
+  v2.x4() = v.x4();
+  v2.b1() = v.b1();
+  EXPECT_EQ(0x3456789, v2.x4());
+  EXPECT_TRUE(v2.b1());
+  EXPECT_EQ(buf2.data(), v2.getBuffer());
+  EXPECT_EQ(buf.data(), v.getBuffer());
+}
+
+TEST(GenTest1, TestConstView){
+  using TestConstView = outer_ns::inner_ns::Example1ConstView;
+  static_assert(sizeof(TestConstView) == sizeof(void*), "const view holds only the buffer pointer");
+  static_assert(std::is_same<decltype(std::declval<TestConstView>().arr1()[0]), int16_t>::value,
+                "read only array elements are values");
+  std::vector<vstruct::pbuf_type> buf(128);
+  unsigned int seed = 5;
+  for (auto& x : buf) {
+    x = static_cast<vstruct::pbuf_type>(rand_r(&seed));
+  }
+  TestView v(buf.data());
+  const vstruct::pbuf_type* pConst = buf.data();
+  TestConstView cv(pConst);
+  EXPECT_EQ(pConst, cv.getBuffer());
+  EXPECT_EQ(v.b1(), cv.b1());
+  EXPECT_EQ(v.x1(), cv.x1());
+  EXPECT_EQ(v.x4(), cv.x4());
+  EXPECT_EQ(v.x7(), cv.x7());
+  double dbl = cv.dbl();
+  double expected_dbl = v.dbl();
+  EXPECT_EQ(0, memcmp(&expected_dbl, &dbl, sizeof(double)));  // random doubles may be nan
+  for (size_t k = 0; k < 11; k++) {
+    EXPECT_EQ(v.arr1()[k], cv.arr1()[k]) << "index:" << k;
+  }
+  EXPECT_TRUE(std::equal(cv.arr2().begin(), cv.arr2().end(), v.arr2().cbegin()));
+
+  // a view converts to a const view of the same record
+  TestConstView cv2 = v;
+  EXPECT_EQ(pConst, cv2.getBuffer());
+  v.x4() = 12345;
+  EXPECT_EQ(12345, cv2.x4());
+}
+
+TEST(GenTest1, TestRecordStride){
+  EXPECT_EQ(1024, TestStruct::record_bits);
+  EXPECT_EQ(128, TestStruct::record_bytes);
+  EXPECT_EQ(128, TestView::record_bytes);
+  EXPECT_EQ(128, TestRecords::stride);
+}
+
+TEST(GenTest1, TestRecordArray){
+  TestRecords records;
+  EXPECT_TRUE(records.empty());
+  for (int i = 0; i < 100; i++) {
+    TestView r = records.push_back();
+    r.x4() = i * 3;
+    r.arr1()[2] = -i;
+  }
+  EXPECT_EQ(100, records.size());
+  EXPECT_LE(100, records.capacity());
+  for (size_t i = 0; i < records.size(); i++) {
+    EXPECT_EQ(i * 3, records[i].x4());
+    EXPECT_EQ(-static_cast<int>(i), records[i].arr1()[2]);
+    EXPECT_EQ(0, records[i].x0());  // new records are zero filled
+  }
+  // records are stride apart, the same layout a VStruct sees
+  TestStruct s;
+  s.setBuffer(records.data() + 7 * TestRecords::stride);
+  EXPECT_EQ(21, s.x4);
+
+  // cursor walks the records without rebinding the fields
+  uint32_t total = 0;
+  for (TestView v : records) {
+    total += v.x4();
+  }
+  EXPECT_EQ(3 * 99 * 100 / 2, total);
+  TestRecords::iterator it = records.begin();
+  EXPECT_EQ(100, records.end() - it);
+  EXPECT_EQ(30, it[10].x4());
+  it += 20;
+  EXPECT_EQ(60, it->x4());
+  EXPECT_EQ(57, (--it)->x4());
+  EXPECT_EQ(63, (it + 2)->x4());
+  EXPECT_TRUE(records.begin() < it);
+
+  // standard algorithms over the cursor
+  EXPECT_EQ(50, std::count_if(records.begin(), records.end(), [](TestView v) { return v.x4() % 2 == 0; }));
+
+  // copy of a record of the same array, growth keeps the content
+  records.push_back(records[5]);
+  EXPECT_EQ(101, records.size());
+  EXPECT_EQ(15, records.back().x4());
+  EXPECT_EQ(-5, records.back().arr1()[2]);
+
+  records.resize(50);
+  EXPECT_EQ(50, records.size());
+  records.resize(60);
+  EXPECT_EQ(0, records[55].x4());
+  EXPECT_EQ(147, records[49].x4());
+
+  TestRecords copy = records;
+  copy[0].x4() = 1234;
+  EXPECT_EQ(0, records[0].x4());
+  EXPECT_EQ(1234, copy[0].x4());
+}
+
+TEST(GenTest1, TestRecordArrayWrap){
+  std::vector<vstruct::pbuf_type> buf(4 * TestRecords::stride, 0);
+  TestRecords records(buf.data(), 4);
+  EXPECT_FALSE(records.owning());
+  EXPECT_EQ(4, records.size());
+  records[3].x7() = -42;
+  TestStruct s;
+  s.setBuffer(buf.data() + 3 * TestRecords::stride);
+  EXPECT_EQ(-42, s.x7);
+  records.pop_back();
+  EXPECT_EQ(3, records.size());
+  records.push_back();  // fits in the wrapped capacity
+  EXPECT_EQ(0, s.x7);
+}
+
+TEST(GenTest1, TestRecordArrayWrapGrow){
+  std::vector<vstruct::pbuf_type> buf(4 * TestRecords::stride, 0);
+  TestRecords records(buf.data(), 4);
+  for (size_t i = 0; i < 4; i++) {
+    records[i].x4() = static_cast<uint32_t>(100 + i);
+  }
+  records.push_back();  // past the wrapped capacity, copied into an owned buffer
+  EXPECT_TRUE(records.owning());
+  EXPECT_NE(buf.data(), records.data());
+  EXPECT_EQ(5, records.size());
+  for (size_t i = 0; i < 4; i++) {
+    EXPECT_EQ(100 + i, records[i].x4());
+  }
+  EXPECT_EQ(0, records[4].x4());
+  records[0].x4() = 7;
+  EXPECT_EQ(7, records[0].x4());
+  TestStruct s;
+  s.setBuffer(buf.data());
+  EXPECT_EQ(100, s.x4);  // the wrapped buffer is no longer written
+
+  TestRecords copy = records;
+  EXPECT_NE(records.data(), copy.data());
+  copy[1].x4() = 55;
+  EXPECT_EQ(101, records[1].x4());
+
+  TestRecords wrapped(buf.data(), 4);
+  wrapped.resize(9);
+  EXPECT_TRUE(wrapped.owning());
+  EXPECT_EQ(103, wrapped[3].x4());
+  EXPECT_EQ(0, wrapped[8].x4());
+}
+
+// column of each field must match the values seen through the view
+TEST(GenTest1, TestColumns){
+  const size_t count = 37;  // not a multiple of the 8 record gather
+  TestRecords records(count);
+  unsigned int seed = 1234;
+  for (size_t i = 0; i < records.size_bytes(); i++) {
+    records.data()[i] = static_cast<vstruct::pbuf_type>(rand_r(&seed));
+  }
+  std::vector<int8_t> x1(count);
+  std::vector<uint32_t> x4(count);
+  std::vector<int32_t> x5(count);
+  std::vector<uint64_t> x6(count);
+  std::vector<float> flt(count);
+  vstruct::extract_column(&TestStruct::x1, records, x1.data());
+  vstruct::extract_column(&TestStruct::x4, records, x4.data());
+  vstruct::extract_column(&TestStruct::x5, records.data(), count, x5.data());
+  vstruct::extract_column(&TestStruct::x6, records.data(), count, x6.data());
+  bool b1_out[count];
+  vstruct::extract_column(&TestStruct::b1, records, b1_out);
+  vstruct::extract_column(&TestStruct::flt, records, flt.data());
+  for (size_t i = 0; i < count; i++) {
+    EXPECT_EQ(records[i].x1(), x1[i]) << "index:" << i;
+    EXPECT_EQ(records[i].x4(), x4[i]) << "index:" << i;
+    EXPECT_EQ(records[i].x5(), x5[i]) << "index:" << i;
+    EXPECT_EQ(records[i].x6(), x6[i]) << "index:" << i;
+    EXPECT_EQ(records[i].b1(), b1_out[i]) << "index:" << i;
+    float expected = records[i].flt();
+    EXPECT_EQ(0, memcmp(&expected, &flt[i], sizeof(float))) << "index:" << i;  // random floats may be nan
+  }
+
+  // scatter writes only the field
+  TestRecords before = records;
+  for (size_t i = 0; i < count; i++) {
+    x4[i] = static_cast<uint32_t>(i * 1000);
+    x5[i] = -static_cast<int32_t>(i * 3);
+  }
+  x4[3] = 0xffffffff;  // above 26 bits
+  x5[4] = std::numeric_limits<int32_t>::min();  // below 27 bits
+  EXPECT_EQ(1, vstruct::scatter_column(&TestStruct::x4, records, x4.data()));
+  EXPECT_EQ(1, vstruct::scatter_column(&TestStruct::x5, records.data(), count, x5.data()));
+  for (size_t i = 0; i < count; i++) {
+    if (i == 3) {
+      EXPECT_EQ(0x3ffffff, records[i].x4());
+    } else {
+      EXPECT_EQ(i * 1000, records[i].x4()) << "index:" << i;
+    }
+    if (i == 4) {
+      EXPECT_EQ(-0x4000000, records[i].x5());
+    } else {
+      EXPECT_EQ(-static_cast<int32_t>(i * 3), records[i].x5()) << "index:" << i;
+    }
+    EXPECT_EQ(before[i].x3(), records[i].x3()) << "index:" << i;
+    EXPECT_EQ(before[i].x6(), records[i].x6()) << "index:" << i;
+  }
+}
+
+TEST(GenTest1, TestColumnStore){
+  const size_t count = 3000;  // 3 blocks, the last one partial
+  TestRecords records(count);
+  unsigned int seed = 4321;
+  for (size_t i = 0; i < records.size_bytes(); i++) {
+    records.data()[i] = static_cast<vstruct::pbuf_type>(rand_r(&seed));
+  }
+  for (unsigned threads = 1; threads <= 4; threads += 3) {
+    vstruct::ColumnStore<TestStruct> store;
+    store.from_records(records.data(), count, threads);
+    EXPECT_EQ(count, store.size());
+    EXPECT_EQ((count * 58 + 7) / 8, store.column_bytes(9));  // x6, padding has no column
+    auto b1 = store.column(&TestStruct::b1);
+    auto x1 = store.column(&TestStruct::x1);
+    auto x6 = store.column(&TestStruct::x6);
+    auto x7 = store.column(&TestStruct::x7);
+    auto arr1 = store.column(&TestStruct::arr1);
+    auto flt = store.column(&TestStruct::flt);
+    auto arr_dbl = store.column(&TestStruct::arr_dbl);
+    for (size_t i = 0; i < count; i++) {
+      EXPECT_EQ(records[i].b1(), b1.get(i)) << "index:" << i;
+      EXPECT_EQ(records[i].x1(), x1.get(i)) << "index:" << i;
+      EXPECT_EQ(records[i].x6(), x6.get(i)) << "index:" << i;
+      EXPECT_EQ(records[i].x7(), x7.get(i)) << "index:" << i;
+      for (size_t k = 0; k < 11; k++) {
+        EXPECT_EQ(records[i].arr1()[k], arr1.get(i, k)) << "index:" << i << " element:" << k;
+      }
+      float expected_flt = records[i].flt();
+      float actual_flt = flt.get(i);
+      EXPECT_EQ(0, memcmp(&expected_flt, &actual_flt, sizeof(float))) << "index:" << i;  // random floats may be nan
+      double expected_dbl = records[i].arr_dbl()[3];
+      double actual_dbl = arr_dbl.get(i, 3);
+      EXPECT_EQ(0, memcmp(&expected_dbl, &actual_dbl, sizeof(double))) << "index:" << i;
+    }
+
+    // back to records, padding bits are left as they are
+    TestRecords copy(count);
+    store.to_records(copy.data(), threads);
+    for (size_t i = 0; i < count; i++) {
+      vstruct::pbuf_type* a = records.data() + i * TestRecords::stride;
+      vstruct::pbuf_type* b = copy.data() + i * TestRecords::stride;
+      EXPECT_EQ(0, memcmp(a + 2, b + 2, 64)) << "index:" << i;  // x0 to arr2
+      EXPECT_EQ(0, memcmp(a + 68, b + 68, 60)) << "index:" << i;  // flt to arr_dbl
+      EXPECT_EQ(a[0] & 0x7, b[0]) << "index:" << i;  // bools only
+    }
+
+    // set writes one record of the column
+    x6.set(5, 12345);
+    EXPECT_EQ(12345u, x6.get(5));
+    EXPECT_EQ(records[4].x6(), x6.get(4));
+    EXPECT_EQ(records[6].x6(), x6.get(6));
+  }
+}
+
+// brute force selection through the view
+template <typename T, typename Get>
+std::vector<uint64_t> expectedSelection(size_t count, vstruct::Compare op, T value, Get get) {
+  std::vector<uint64_t> selection(vstruct::selection_words(count), 0);
+  for (size_t i = 0; i < count; i++) {
+    T x = get(i);
+    bool hit = false;
+    switch (op) {
+      case vstruct::Compare::eq: hit = x == value; break;
+      case vstruct::Compare::ne: hit = x != value; break;
+      case vstruct::Compare::lt: hit = x < value; break;
+      case vstruct::Compare::le: hit = x <= value; break;
+      case vstruct::Compare::gt: hit = x > value; break;
+      case vstruct::Compare::ge: hit = x >= value; break;
+    }
+    selection[i / 64] |= static_cast<uint64_t>(hit) << (i % 64);
+  }
+  return selection;
+}
+
+TEST(GenTest1, TestScan){
+  const size_t count = 1000;  // not a multiple of 64
+  TestRecords records(count);
+  unsigned int seed = 99;
+  for (size_t i = 0; i < records.size_bytes(); i++) {
+    records.data()[i] = static_cast<vstruct::pbuf_type>(rand_r(&seed));
+  }
+  const vstruct::Compare ops[] = {vstruct::Compare::eq, vstruct::Compare::ne, vstruct::Compare::lt,
+                                  vstruct::Compare::le, vstruct::Compare::gt, vstruct::Compare::ge};
+  std::vector<uint64_t> selection(vstruct::selection_words(count));
+  for (vstruct::Compare op : ops) {
+    int op_index = static_cast<int>(op);
+    // values inside, at the edges of and outside the field range
+    for (int8_t value : {-5, -4, -1, 0, 2, 3, 4, 100}) {
+      size_t n = vstruct::scan(&TestStruct::x1, records, op, value, selection.data());
+      auto expected = expectedSelection<int8_t>(count, op, value, [&](size_t i) { return records[i].x1(); });
+      EXPECT_EQ(expected, selection) << "x1 op:" << op_index << " value:" << static_cast<int>(value);
+      EXPECT_EQ(vstruct::selection_count(expected.data(), count), n);
+    }
+    for (uint32_t value : {0u, 1u, 0x1000000u, 0x3ffffffu, 0x4000000u}) {
+      vstruct::scan(&TestStruct::x4, records, op, value, selection.data());
+      auto expected = expectedSelection<uint32_t>(count, op, value, [&](size_t i) { return records[i].x4(); });
+      EXPECT_EQ(expected, selection) << "x4 op:" << op_index << " value:" << value;
+    }
+    int32_t x5_value = records[7].x5();  // eq must find it
+    for (int32_t value : {-0x4000000, x5_value, 0, 0x3ffffff, std::numeric_limits<int32_t>::max()}) {
+      vstruct::scan(&TestStruct::x5, records.data(), count, op, value, selection.data());
+      auto expected = expectedSelection<int32_t>(count, op, value, [&](size_t i) { return records[i].x5(); });
+      EXPECT_EQ(expected, selection) << "x5 op:" << op_index << " value:" << value;
+    }
+    int64_t x7_value = records[11].x7();
+    for (int64_t value : {std::numeric_limits<int64_t>::min(), x7_value, int64_t(0)}) {
+      vstruct::scan(&TestStruct::x7, records, op, value, selection.data());
+      auto expected = expectedSelection<int64_t>(count, op, value, [&](size_t i) { return records[i].x7(); });
+      EXPECT_EQ(expected, selection) << "x7 op:" << op_index << " value:" << value;
+    }
+    for (bool value : {false, true}) {
+      vstruct::scan(&TestStruct::b1, records, op, value, selection.data());
+      auto expected = expectedSelection<bool>(count, op, value, [&](size_t i) { return records[i].b1(); });
+      EXPECT_EQ(expected, selection) << "b1 op:" << op_index << " value:" << value;
+    }
+    vstruct::scan(&TestStruct::flt, records, op, 0.0f, selection.data());
+    auto expected = expectedSelection<float>(count, op, 0.0f, [&](size_t i) { return records[i].flt(); });
+    EXPECT_EQ(expected, selection) << "flt op:" << op_index;
+  }
+
+  size_t n = vstruct::scan_between(&TestStruct::x3, records, int16_t(-1000), int16_t(1000), selection.data());
+  std::vector<uint32_t> indices(n);
+  EXPECT_EQ(n, vstruct::selection_indices(selection.data(), count, indices.data()));
+  size_t k = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (records[i].x3() >= -1000 && records[i].x3() <= 1000) {
+      ASSERT_LT(k, n);
+      EXPECT_EQ(i, indices[k++]);
+    }
+  }
+  EXPECT_EQ(n, k);
+}
+
+// aggregates through the view
+template <typename T, typename Get>
+vstruct::FieldStats<T> expectedStats(size_t count, Get get) {
+  vstruct::FieldStats<T> stats;
+  for (size_t i = 0; i < count; i++) {
+    stats.add(get(i));
+  }
+  return stats;
+}
+
+template <typename T>
+void expectStats(const vstruct::FieldStats<T>& expected, const vstruct::FieldStats<T>& actual, const char* name) {
+  EXPECT_EQ(expected.count, actual.count) << name;
+  EXPECT_EQ(expected.sum, actual.sum) << name;
+  EXPECT_EQ(expected.min, actual.min) << name;
+  EXPECT_EQ(expected.max, actual.max) << name;
+  EXPECT_EQ(expected.nonzero, actual.nonzero) << name;
+}
+
+TEST(GenTest1, TestAggregate){
+  for (size_t count : {0, 5, 1003}) {  // empty, scalar only, gather with a scalar tail
+    TestRecords records(count);
+    unsigned int seed = 7;
+    for (size_t i = 0; i < records.size_bytes(); i++) {
+      records.data()[i] = static_cast<vstruct::pbuf_type>(rand_r(&seed));
+    }
+    for (size_t i = 0; i < count; i += 10) {
+      records[i].x4() = 0;  // some zeros
+    }
+    expectStats(expectedStats<int8_t>(count, [&](size_t i) { return records[i].x1(); }),
+                vstruct::aggregate(&TestStruct::x1, records), "x1");
+    expectStats(expectedStats<int16_t>(count, [&](size_t i) { return records[i].x3(); }),
+                vstruct::aggregate(&TestStruct::x3, records), "x3");
+    expectStats(expectedStats<uint32_t>(count, [&](size_t i) { return records[i].x4(); }),
+                vstruct::aggregate(&TestStruct::x4, records.data(), count), "x4");
+    expectStats(expectedStats<int32_t>(count, [&](size_t i) { return records[i].x5(); }),
+                vstruct::aggregate(&TestStruct::x5, records), "x5");
+    expectStats(expectedStats<int64_t>(count, [&](size_t i) { return records[i].x7(); }),
+                vstruct::aggregate(&TestStruct::x7, records), "x7");
+    expectStats(expectedStats<bool>(count, [&](size_t i) { return records[i].b1(); }),
+                vstruct::aggregate(&TestStruct::b1, records), "b1");
+  }
+
+  // 64 bit accumulators do not overflow
+  const size_t count = 2000;
+  TestRecords records(count);
+  for (size_t i = 0; i < count; i++) {
+    records[i].x4() = 0x3ffffff;
+    records[i].x5() = -0x4000000;
+  }
+  vstruct::FieldStats<uint32_t> x4 = vstruct::aggregate(&TestStruct::x4, records);
+  EXPECT_EQ(count * 0x3ffffffull, x4.sum);
+  EXPECT_DOUBLE_EQ(0x3ffffff, x4.mean());
+  vstruct::FieldStats<int32_t> x5 = vstruct::aggregate(&TestStruct::x5, records);
+  EXPECT_EQ(-static_cast<int64_t>(count) * 0x4000000, x5.sum);
+  EXPECT_EQ(-0x4000000, x5.min);
+  EXPECT_EQ(-0x4000000, x5.max);
+
+  // elements of an array
+  for (size_t k = 0; k < 11; k++) {
+    records[3].arr2()[k] = static_cast<int16_t>(1000 * k - 5000);
+  }
+  vstruct::FieldStats<int16_t> arr2 = vstruct::aggregate(records[3].arr2());
+  EXPECT_EQ(11u, arr2.count);
+  EXPECT_EQ(0, arr2.sum);
+  EXPECT_EQ(-5000, arr2.min);
+  EXPECT_EQ(5000, arr2.max);
+  EXPECT_EQ(10u, arr2.nonzero);
+}
+
+TEST(GenTest1, TestMappedRecordFile){
+  using MappedFile = vstruct::MappedRecordFile<TestStruct>;
+  static_assert(std::is_same<MappedFile::View, TestView>::value, "layout names its view");
+  char path[] = "/tmp/vstruct_mapped_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  close(fd);
+
+  const size_t count = 1000;
+  {
+    MappedFile file;
+    ASSERT_TRUE(file.open(path, MappedFile::Mode::read_write));
+    EXPECT_EQ(0u, file.size());
+    for (size_t i = 0; i < count; i++) {
+      TestView v = file.push_back();
+      v.x4() = static_cast<uint32_t>(i * 7);
+      v.x7() = -static_cast<int64_t>(i);
+      v.arr1()[10] = static_cast<int16_t>(i);
+    }
+    EXPECT_EQ(count, file.size());
+    EXPECT_GE(file.capacity(), count);
+    EXPECT_TRUE(file.sync());
+    EXPECT_TRUE(file.close());
+  }
+  struct stat st;
+  ASSERT_EQ(0, stat(path, &st));
+  EXPECT_EQ(count * TestStruct::record_bytes, static_cast<size_t>(st.st_size));  // truncated to the records
+
+  {
+    MappedFile file;
+    ASSERT_TRUE(file.open(path, MappedFile::Mode::read_only));
+    EXPECT_FALSE(file.writable());
+    ASSERT_EQ(count, file.size());
+    EXPECT_TRUE(file.advise_sequential());
+    EXPECT_TRUE(file.advise_willneed(100, 50));
+    for (size_t i = 0; i < count; i++) {
+      TestStruct::ConstView v = file.cget(i);
+      EXPECT_EQ(i * 7, v.x4()) << "index:" << i;
+      EXPECT_EQ(-static_cast<int64_t>(i), v.x7()) << "index:" << i;
+      EXPECT_EQ(static_cast<int16_t>(i), v.arr1()[10]) << "index:" << i;
+    }
+
+    // read only cursors and column kernels over the mapping
+    size_t n = 0;
+    for (MappedFile::const_iterator it = file.cbegin(); it != file.cend(); ++it) {
+      EXPECT_EQ(n * 7, it->x4()) << "index:" << n;
+      n++;
+    }
+    EXPECT_EQ(count, n);
+    EXPECT_EQ(count, static_cast<size_t>(file.cend() - file.cbegin()));
+    EXPECT_EQ(-500, file.cbegin()[500].x7());
+    std::vector<uint32_t> x4(count);
+    vstruct::extract_column(&TestStruct::x4, file.cdata(), file.size(), x4.data());
+    for (size_t i = 0; i < count; i++) {
+      EXPECT_EQ(i * 7, x4[i]) << "index:" << i;
+    }
+    std::vector<uint64_t> selection(vstruct::selection_words(count));
+    EXPECT_EQ(100u, vstruct::scan(&TestStruct::x4, file.cdata(), file.size(), vstruct::Compare::lt, 700,
+                                  selection.data()));
+    vstruct::FieldStats<int64_t> x7 = vstruct::aggregate(&TestStruct::x7, file.cdata(), file.size());
+    EXPECT_EQ(-static_cast<int64_t>(count - 1), x7.min);
+    EXPECT_EQ(0, x7.max);
+  }
+
+  {  // append to the existing records
+    MappedFile file;
+    ASSERT_TRUE(file.open(path, MappedFile::Mode::read_write));
+    ASSERT_EQ(count, file.size());
+    file.push_back().x4() = 42;
+    size_t n = 0;
+    for (TestView v : file) {
+      EXPECT_EQ((n < count) ? n * 7 : 42, v.x4()) << "index:" << n;
+      n++;
+    }
+    EXPECT_EQ(count + 1, n);
+    EXPECT_EQ(count + 1, file.records().size());
+  }
+  ASSERT_EQ(0, stat(path, &st));
+  EXPECT_EQ((count + 1) * TestStruct::record_bytes, static_cast<size_t>(st.st_size));
+
+  MappedFile missing;
+  EXPECT_FALSE(missing.open("/nonexistent/vstruct_records", MappedFile::Mode::read_only));
+  EXPECT_FALSE(missing.is_open());
+  unlink(path);
+}
+
+TEST(GenTest1, TestDenseRecords){
+  using Sensor = outer_ns::inner_ns::Sensor1;
+  using SensorView = outer_ns::inner_ns::Sensor1View;
+  EXPECT_EQ(37u, Sensor::record_bits);
+  EXPECT_EQ(5u, Sensor::record_bytes);
+  const size_t count = 1000;
+  vstruct::RecordArray<SensorView> records(count);
+  for (size_t i = 0; i < count; i++) {
+    records[i].valid() = (i % 3) == 0;
+    records[i].channel() = static_cast<uint8_t>(i & 0xF);
+    records[i].value() = static_cast<int32_t>(i * 37) - 20000;
+    records[i].stamp() = static_cast<uint16_t>(i & 0xFFF);
+  }
+  vstruct::DenseRecords<Sensor> dense;
+  dense.encode(records);
+  EXPECT_EQ(count, dense.size());
+  EXPECT_EQ((count * 37 + 7) / 8, dense.size_bytes());  // 4625 bytes instead of 5000
+  for (size_t i = 0; i < count; i++) {
+    ASSERT_EQ(records[i].valid(), dense.get(&Sensor::valid, i)) << "index:" << i;
+    ASSERT_EQ(records[i].channel(), dense.get(&Sensor::channel, i)) << "index:" << i;
+    ASSERT_EQ(records[i].value(), dense.get(&Sensor::value, i)) << "index:" << i;
+    ASSERT_EQ(records[i].stamp(), dense.get(&Sensor::stamp, i)) << "index:" << i;
+  }
+
+  // batch decode from a record that is not byte aligned
+  auto batch = dense.decode(101, 200);
+  ASSERT_EQ(200u, batch.size());
+  for (size_t i = 0; i < batch.size(); i++) {
+    EXPECT_EQ(0, memcmp(records[101 + i].getBuffer(), batch[i].getBuffer(), 5)) << "index:" << i;
+  }
+
+  // set and encode only touch their own record
+  dense.set(&Sensor::value, 7, -5);
+  EXPECT_EQ(-5, dense.get(&Sensor::value, 7));
+  EXPECT_EQ(records[6].stamp(), dense.get(&Sensor::stamp, 6));
+  EXPECT_EQ(records[8].valid(), dense.get(&Sensor::valid, 8));
+  records[50].stamp() = 4095;
+  dense.encode(50, 1, records[50].getBuffer());
+  EXPECT_EQ(4095u, dense.get(&Sensor::stamp, 50));
+  EXPECT_EQ(records[49].stamp(), dense.get(&Sensor::stamp, 49));
+  EXPECT_EQ(records[51].valid(), dense.get(&Sensor::valid, 51));
+
+  // shrinking clears the removed records, appended records start after the last one
+  dense.resize(3);
+  dense.push_back(records[999].getBuffer());
+  dense.resize(5);
+  EXPECT_EQ(records[999].value(), dense.get(&Sensor::value, 3));
+  EXPECT_EQ(0, dense.get(&Sensor::value, 4));
+  EXPECT_EQ(0u, dense.get(&Sensor::stamp, 4));
+
+  // arrays and floats of a byte padded layout
+  TestRecords wide(20);
+  unsigned int seed = 99;
+  for (size_t i = 0; i < wide.size_bytes(); i++) {
+    wide.data()[i] = static_cast<vstruct::pbuf_type>(rand_r(&seed));
+  }
+  vstruct::DenseRecords<TestStruct> dense_wide;
+  dense_wide.encode(wide);
+  for (size_t i = 0; i < wide.size(); i++) {
+    EXPECT_EQ(wide[i].x7(), dense_wide.get(&TestStruct::x7, i));
+    EXPECT_EQ(wide[i].arr1()[5], dense_wide.get(&TestStruct::arr1, i, 5));
+  }
+  EXPECT_EQ(0, memcmp(wide.data(), dense_wide.decode(0, 20).data(), wide.size_bytes()));
+}
+
+TEST(GenTest1, TestNative){
+  using TestNative = TestStruct::Native;
+  TestRecords records(50);
+  unsigned int seed = 2468;
+  for (size_t i = 0; i < records.size_bytes(); i++) {
+    records.data()[i] = static_cast<vstruct::pbuf_type>(rand_r(&seed));
+  }
+  for (size_t i = 0; i < records.size(); i++) {
+    TestView v = records[i];
+    TestNative n;
+    load(v.getBuffer(), n);
+    EXPECT_EQ(v.b0(), n.b0);
+    EXPECT_EQ(v.b2(), n.b2);
+    EXPECT_EQ(v.x1(), n.x1);
+    EXPECT_EQ(v.x3(), n.x3);
+    EXPECT_EQ(v.x5(), n.x5);
+    EXPECT_EQ(v.x6(), n.x6);
+    EXPECT_EQ(v.x7(), n.x7);
+    for (size_t k = 0; k < 3; k++) {
+      EXPECT_EQ(v.arr0()[k], n.arr0[k]) << "index:" << i << " element:" << k;
+    }
+    for (size_t k = 0; k < 11; k++) {
+      EXPECT_EQ(v.arr1()[k], n.arr1[k]) << "index:" << i << " element:" << k;
+      EXPECT_EQ(v.arr2()[k], n.arr2[k]) << "index:" << i << " element:" << k;
+    }
+    double expected_dbl = v.arr_dbl()[2];
+    EXPECT_EQ(0, memcmp(&expected_dbl, &n.arr_dbl[2], sizeof(double)));  // random doubles may be nan
+
+    // store writes back the same field bits
+    TestRecords copy(1);
+    store(n, copy.data());
+    EXPECT_EQ(0, memcmp(v.getBuffer() + 2, copy.data() + 2, 64)) << "index:" << i;  // x0 to arr2
+    EXPECT_EQ(0, memcmp(v.getBuffer() + 68, copy.data() + 68, 60)) << "index:" << i;  // flt to arr_dbl
+    EXPECT_EQ(v.getBuffer()[0] & 0x7, copy.data()[0]) << "index:" << i;  // bools only
+  }
+
+  // out of range values saturate like the setters
+  TestNative n;
+  load(records.data(), n);
+  n.x1 = 100;  // 3 bits signed
+  n.arr0[1] = 0xFF;  // 4 bits
+  store(n, records.data());
+  EXPECT_EQ(3, records[0].x1());
+  EXPECT_EQ(15, records[0].arr0()[1]);
 
+  // 37 bit layout without padding
+  using Sensor = outer_ns::inner_ns::Sensor1;
+  vstruct::pbuf_type buf[Sensor::record_bytes] = {0};
+  Sensor::Native s = {true, 9, -12345, 4000};
+  store(s, buf);
+  Sensor::Native t;
+  load(buf, t);
+  EXPECT_TRUE(t.valid);
+  EXPECT_EQ(9, t.channel);
+  EXPECT_EQ(-12345, t.value);
+  EXPECT_EQ(4000, t.stamp);
+}
+
+TEST(GenTest1, TestFieldTable){
+  using Table = vstruct::FieldTable<TestStruct>;
+  static_assert(Table::size == 18, "padding has no descriptor");
+  static_assert(Table::fields[7].first_bit == decltype(S.x4)::first_bit, "compile time access");
+  static_assert(Table::find("arr1") == 12, "compile time lookup");
+  static_assert(Table::find("pad0") == Table::size, "padding has no descriptor");
+  EXPECT_STREQ("x4", Table::fields[7].name);
+  EXPECT_EQ(vstruct::FieldKind::le_item, Table::fields[7].kind);
+  EXPECT_STREQ("uint32_t", Table::fields[7].type);
+  EXPECT_EQ(26u, Table::fields[7].Sz);
+  EXPECT_FALSE(Table::fields[7].is_signed);
+
+  const vstruct::FieldDescriptor& arr1 = Table::fields[Table::find("arr1")];
+  EXPECT_EQ(vstruct::FieldKind::le_array, arr1.kind);
+  EXPECT_STREQ("int16_t", arr1.type);
+  EXPECT_EQ(11u, arr1.N);
+  EXPECT_EQ(121u, arr1.bit_size());
+  EXPECT_TRUE(arr1.is_signed);
+  EXPECT_EQ(vstruct::FieldKind::bool_item, Table::fields[0].kind);
+
+  // fields are in bit order without overlap, and end within the record
+  size_t next_bit = 0;
+  for (const vstruct::FieldDescriptor& d : Table()) {
+    EXPECT_LE(next_bit, d.first_bit) << d.name;
+    next_bit = d.next_bit();
+  }
+  EXPECT_LE(next_bit, TestStruct::record_bits);
+
+  using SensorTable = vstruct::FieldTable<outer_ns::inner_ns::Sensor1>;
+  static_assert(SensorTable::fields[SensorTable::size - 1].next_bit() == 37, "Sensor1 is 37 bits");
+  EXPECT_STREQ("stamp", SensorTable::fields[3].name);
+}
+
+TEST(GenTest1, TestDynamicLayout){
+  std::ifstream file(VSTRUCT_GEN_DIR "/example1.json");
+  ASSERT_TRUE(file.good());
+  std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  vstruct::DynamicLayout layout;
+  ASSERT_TRUE(layout.parse_json(text, "Example1"));
+  EXPECT_EQ("Example1", layout.name());
+  EXPECT_EQ(TestStruct::record_bits, layout.record_bits());
+  EXPECT_EQ(TestStruct::record_bytes, layout.record_bytes());
+  ASSERT_EQ(18u, layout.fields().size());
+  EXPECT_EQ(3u + 8 + 3 + 11 + 11 + 2 + 4 + 4, layout.slots());  // one per element
+
+  // same layout as the compiled table, and the binary form round trips
+  vstruct::DynamicLayout compiled = vstruct::DynamicLayout::from_table<TestStruct>();
+  std::vector<vstruct::pbuf_type> binary = layout.to_binary();
+  EXPECT_TRUE(compiled.to_binary() != binary);  // the compiled table has no struct name
+  vstruct::DynamicLayout loaded;
+  ASSERT_TRUE(loaded.parse_binary(binary.data(), binary.size()));
+  EXPECT_TRUE(loaded.to_binary() == binary);
+  for (size_t i = 0; i < layout.fields().size(); i++) {
+    EXPECT_EQ(compiled.fields()[i].name, layout.fields()[i].name);
+    EXPECT_EQ(compiled.fields()[i].first_bit, layout.fields()[i].first_bit);
+    EXPECT_EQ(compiled.fields()[i].type, loaded.fields()[i].type);
+  }
+
+  // decode matches the views
+  const size_t count = 40;
+  TestRecords records(count);
+  unsigned int seed = 1357;
+  for (size_t i = 0; i < records.size_bytes(); i++) {
+    records.data()[i] = static_cast<vstruct::pbuf_type>(rand_r(&seed));
+  }
+  std::vector<uint64_t> slots(count * layout.slots());
+  layout.decode(records.data(), count, slots.data());
+  size_t x1 = layout.find("x1"), x6 = layout.find("x6"), x7 = layout.find("x7");
+  size_t arr1 = layout.find("arr1"), b2 = layout.find("b2"), arr_dbl = layout.find("arr_dbl");
+  EXPECT_EQ(layout.fields().size(), layout.find("pad0"));
+  for (size_t r = 0; r < count; r++) {
+    TestView v = records[r];
+    const uint64_t* slot = slots.data() + r * layout.slots();
+    const auto& f = layout.fields();
+    EXPECT_EQ(v.x1(), layout.convert<int8_t>(f[x1], slot[f[x1].slot])) << "index:" << r;
+    EXPECT_EQ(v.x6(), layout.convert<uint64_t>(f[x6], slot[f[x6].slot])) << "index:" << r;
+    EXPECT_EQ(v.x7(), layout.convert<int64_t>(f[x7], slot[f[x7].slot])) << "index:" << r;
+    EXPECT_EQ(v.b2(), slot[f[b2].slot] != 0) << "index:" << r;
+    for (size_t k = 0; k < 11; k++) {
+      EXPECT_EQ(v.arr1()[k], layout.get<int16_t>(v.getBuffer(), arr1, k)) << "index:" << r << " element:" << k;
+    }
+    double expected = v.arr_dbl()[3];
+    double actual = layout.get<double>(v.getBuffer(), arr_dbl, 3);
+    EXPECT_EQ(0, memcmp(&expected, &actual, sizeof(double))) << "index:" << r;
+  }
+  std::vector<uint64_t> column(count);
+  layout.extract(x7, records.data(), count, column.data());
+  EXPECT_EQ(records[count - 1].x7(), static_cast<int64_t>(column[count - 1]));
+
+  // 37 bit layout
+  vstruct::DynamicLayout sensor;
+  ASSERT_TRUE(sensor.parse_json(text, "Sensor1"));
+  EXPECT_EQ(37u, sensor.record_bits());
+  EXPECT_FALSE(sensor.plan().back().word);  // a word load would read past the 5 byte record
+  outer_ns::inner_ns::Sensor1::Native n = {true, 3, -1000, 77};
+  vstruct::pbuf_type buf[5];
+  store(n, buf);
+  EXPECT_EQ(-1000, sensor.get<int32_t>(buf, sensor.find("value")));
+  EXPECT_EQ(77, sensor.get<int>(buf, sensor.find("stamp")));
+
+  // invalid schemas
+  EXPECT_FALSE(layout.parse_json(text, "NoSuchStruct"));
+  EXPECT_TRUE(layout.fields().empty());
+  EXPECT_FALSE(layout.parse_json("{\"name\": \"A\", \"record_bits\": 8, \"fields\": ["
+                                 "{\"name\": \"a\", \"kind\": \"le_item\", \"type\": \"uint8_t\","
+                                 " \"first_bit\": 4, \"Sz\": 8, \"N\": 1}]}"));  // past the record
+  EXPECT_FALSE(layout.parse_json("{\"name\": \"A\", \"record_bits\": 8, \"fields\": ["
+                                 "{\"name\": \"a\", \"kind\": \"le_item\", \"type\": \"uint8_t\","
+                                 " \"first_bit\": 18446744073709551615, \"Sz\": 2, \"N\": 1}]}"));  // wraps
+  EXPECT_FALSE(layout.parse_json("{\"name\": \"A\", \"record_bits\": 4294967296, \"fields\": []}"));  // over u32
+  EXPECT_FALSE(layout.parse_json("{\"name\": \"A\", \"record_bits\": 4294967295, \"fields\": ["
+                                 "{\"name\": \"a\", \"kind\": \"le_array\", \"type\": \"uint64_t\","
+                                 " \"first_bit\": 64, \"Sz\": 64, \"N\": 67108864}]}"));  // one element too many
+  EXPECT_TRUE(layout.fields().empty());
+  EXPECT_FALSE(layout.parse_json("[{\"name\": \"A\", \"record_bits\": 8,"));  // truncated
+  EXPECT_TRUE(layout.parse_json("{\"name\": \"A\", \"record_bits\": 8, \"extra\": [1.5, null, {}], \"fields\": ["
+                                "{\"name\": \"a\", \"kind\": \"le_item\", \"type\": \"int8_t\","
+                                " \"first_bit\": 2, \"Sz\": 5, \"N\": 1, \"is_signed\": true}]}"));
+  vstruct::pbuf_type one = 0x7C;  // 0b11111 at bit 2
+  EXPECT_EQ(-1, layout.get<int>(&one, 0));
+  EXPECT_FALSE(loaded.parse_binary(binary.data(), binary.size() - 1));
+}
+
+TEST(GenTest1, TestRecordStream){
+  const size_t count = 1050;  // last batch is partial
+  for (bool background : {false, true}) {
+    char path[] = "/tmp/vstruct_stream_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    {
+      vstruct::RecordWriter<TestStruct> writer(vstruct::FdSink{fd}, 100, 3, background);
+      for (size_t i = 0; i < count; i++) {
+        TestView v = writer.push_back();
+        v.x4() = static_cast<uint32_t>(i);
+        v.x7() = -static_cast<int64_t>(i);
+      }
+      EXPECT_TRUE(writer.close());
+      EXPECT_EQ(count, writer.records());
+    }
+    EXPECT_EQ(static_cast<off_t>(count * TestStruct::record_bytes), lseek(fd, 0, SEEK_CUR));
+    ASSERT_EQ(3, write(fd, "abc", 3));  // partial record at the end
+    lseek(fd, 0, SEEK_SET);
+    {
+      vstruct::RecordReader<TestStruct> reader(vstruct::FdSource{fd}, 64, 2, background);
+      size_t n = 0;
+      for (auto batch = reader.next(); !batch.empty(); batch = reader.next()) {
+        EXPECT_LE(batch.size(), 64u);
+        for (TestView v : batch) {
+          ASSERT_EQ(n, v.x4()) << "index:" << n;
+          ASSERT_EQ(-static_cast<int64_t>(n), v.x7()) << "index:" << n;
+          n++;
+        }
+      }
+      EXPECT_EQ(count, n);
+      EXPECT_EQ(count, reader.records());
+      EXPECT_TRUE(reader.truncated());
+      EXPECT_FALSE(reader.failed());
+      EXPECT_TRUE(reader.next().empty());  // stays at the end
+    }
+    close(fd);
+    unlink(path);
+  }
+
+  // iostreams, a reader stopped early
+  std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+  {
+    vstruct::RecordWriter<TestStruct, vstruct::OStreamSink> writer(vstruct::OStreamSink{stream}, 16);
+    for (size_t i = 0; i < 500; i++) {
+      writer.push_back().x5() = -static_cast<int32_t>(i);
+    }
+  }
+  EXPECT_EQ(500 * TestStruct::record_bytes, stream.str().size());
+  vstruct::RecordReader<TestStruct, vstruct::IStreamSource> reader(vstruct::IStreamSource{stream}, 32);
+  auto batch = reader.next();
+  ASSERT_EQ(32u, batch.size());
+  EXPECT_EQ(-31, batch[31].x5());
+  batch = reader.next();
+  EXPECT_EQ(-32, batch[0].x5());
+  EXPECT_FALSE(reader.truncated());
+}
+
+
+TEST(GenTest1, TestBigEndian){
+  using Packet = outer_ns::inner_ns::Packet1;
+  using PacketView = outer_ns::inner_ns::Packet1View;
+  static_assert(Packet::record_bytes == 29, "29 byte record");
+  vstruct::pbuf_type buf[Packet::record_bytes + vstruct::slack_bytes] = {0};
+  PacketView v(buf);
+  v.version() = 4;
+  v.flags() = 0xA;
+  v.length() = 0x1234;
+  v.seq() = 0x56789A;
+  v.offsets()[0] = -1;
+  v.offsets()[4] = 0x7FF;
+  v.payload() = 0x12345;
+  v.crc() = 0xDEADBEEF;
+  const vstruct::pbuf_type header[] = {0x4A, 0x12, 0x34, 0x56, 0x78, 0x9A, 0xFF, 0xF0};
+  EXPECT_EQ(0, memcmp(header, buf, sizeof(header)));
+  EXPECT_EQ(0x7F, buf[12]);  // last element, bits 96 to 107
+  EXPECT_EQ(0xF0, buf[13] & 0xF0);
+  EXPECT_EQ(0x45, buf[22]);  // little endian payload
+  EXPECT_EQ(0x23, buf[23]);
+  EXPECT_EQ(0x01, buf[24]);
+  const vstruct::pbuf_type crc[] = {0xDE, 0xAD, 0xBE, 0xEF};
+  EXPECT_EQ(0, memcmp(crc, &buf[25], sizeof(crc)));
+
+  // native round trip, the 61 bit stamp spills into a 9th byte
+  Packet::Native n;
+  load(buf, n);
+  EXPECT_EQ(0x56789Au, n.seq);
+  EXPECT_EQ(-1, n.offsets[0]);
+  EXPECT_EQ(0x7FF, n.offsets[4]);
+  n.stamp = 0x1023456789ABCDEFULL;
+  n.offsets[2] = -300;
+  vstruct::pbuf_type copy[Packet::record_bytes + vstruct::slack_bytes] = {0};
+  store(n, copy);
+  EXPECT_EQ(0x1023456789ABCDEFULL, v.stamp() = n.stamp);
+  EXPECT_EQ(-300, v.offsets()[2] = n.offsets[2]);
+  EXPECT_EQ(0, memcmp(buf, copy, Packet::record_bytes));
+
+  // the schema decodes the same values
+  std::ifstream file(VSTRUCT_GEN_DIR "/example1.json");
+  std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  vstruct::DynamicLayout layout;
+  ASSERT_TRUE(layout.parse_json(text, "Packet1"));
+  EXPECT_EQ(vstruct::FieldKind::be_array, layout.fields()[layout.find("offsets")].kind);
+  EXPECT_EQ(0x1234, layout.get<int>(buf, layout.find("length")));
+  EXPECT_EQ(-300, layout.get<int>(buf, layout.find("offsets"), 2));
+  EXPECT_EQ(0x1023456789ABCDEFULL, layout.get<uint64_t>(buf, layout.find("stamp")));
+  EXPECT_EQ(0x12345, layout.get<int>(buf, layout.find("payload")));
+  EXPECT_EQ(0xDEADBEEFu, layout.get<uint32_t>(buf, layout.find("crc")));  // at the end, decoded by bytes
+  vstruct::DynamicLayout loaded;
+  std::vector<vstruct::pbuf_type> binary = layout.to_binary();
+  ASSERT_TRUE(loaded.parse_binary(binary.data(), binary.size()));
+  EXPECT_EQ(0xA, loaded.get<int>(buf, loaded.find("flags")));
+}
 
 }  // namespace
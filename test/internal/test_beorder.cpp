@@ -0,0 +1,205 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+///
+///
+///
+#include <string.h>
+#include <limits>
+#include "vstruct/internals.h"
+#include "gtest/gtest.h"
+#include "../testlib.h"
+
+namespace {
+
+template <typename TypeArg, uint16_t offsetArg, uint16_t SzArg>
+struct TestArgs {
+  typedef TypeArg T;
+  enum : uint16_t {
+    offset = offsetArg,
+    Sz = SzArg
+  };
+};
+
+using testing::Types;
+typedef Types<
+TestArgs<uint8_t, 0, 1>,
+TestArgs<uint8_t, 7, 1>,
+TestArgs<uint8_t, 0, 4>,
+TestArgs<uint8_t, 4, 4>,
+TestArgs<uint8_t, 6, 4>,
+TestArgs<uint8_t, 0, 8>,
+TestArgs<uint8_t, 3, 8>,
+TestArgs<uint16_t, 0, 12>,
+TestArgs<uint16_t, 4, 12>,
+TestArgs<uint16_t, 7, 15>,
+TestArgs<uint16_t, 0, 16>,
+TestArgs<uint16_t, 5, 16>,
+TestArgs<uint32_t, 0, 24>,
+TestArgs<uint32_t, 3, 27>,
+TestArgs<uint32_t, 0, 32>,
+TestArgs<uint32_t, 7, 32>,
+TestArgs<uint64_t, 2, 40>,
+TestArgs<uint64_t, 0, 57>,
+TestArgs<uint64_t, 7, 57>,
+TestArgs<uint64_t, 1, 58>,
+TestArgs<uint64_t, 6, 63>,
+TestArgs<uint64_t, 0, 64>,
+TestArgs<uint64_t, 1, 64>,
+TestArgs<uint64_t, 7, 64>
+> AllTestArgs;
+
+template <typename TArgs>
+class BEOrderTestSuite : public testing::Test {
+ public:
+  typedef typename TArgs::T T;
+  enum : uint16_t {
+    offset = TArgs::offset,
+    Sz = TArgs::Sz
+  };
+  enum : size_t {
+    buf_bytes = 24
+  };
+  using Order = vstruct::internals::BEOrder<T, Sz>;
+  vstruct::pbuf_type pbuf[buf_bytes + vstruct::slack_bytes];
+  vstruct::pbuf_type expected[buf_bytes + vstruct::slack_bytes];
+
+  // bit i of the buffer, numbered MSB first
+  static unsigned bitAt(const vstruct::pbuf_type* p, size_t i) {
+    return (p[i >> 3] >> (7 - (i & 7))) & 1;
+  }
+
+  static uint64_t refGet(const vstruct::pbuf_type* p, size_t first_bit) {
+    uint64_t x = 0;
+    for (size_t k = 0; k < Sz; k++) {
+      x = (x << 1) | bitAt(p, first_bit + k);
+    }
+    return x;
+  }
+
+  static void refSet(vstruct::pbuf_type* p, size_t first_bit, uint64_t x) {
+    for (size_t k = 0; k < Sz; k++) {
+      size_t i = first_bit + k;
+      unsigned bit = (x >> (Sz - 1 - k)) & 1;
+      vstruct::pbuf_type m = static_cast<vstruct::pbuf_type>(0x80u >> (i & 7));
+      p[i >> 3] = static_cast<vstruct::pbuf_type>(bit ? (p[i >> 3] | m) : (p[i >> 3] & ~m));
+    }
+  }
+
+  void fill(uint64_t seed) {
+    for (size_t i = 0; i < sizeof(pbuf); i++) {
+      seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+      pbuf[i] = static_cast<vstruct::pbuf_type>(seed >> 56);
+    }
+    memcpy(expected, pbuf, sizeof(pbuf));
+  }
+
+  static T maxValue() {
+    return static_cast<T>(vstruct::internals::low_mask<uint64_t>(Sz));
+  }
+
+  // values with the top, bottom and alternating bits set
+  static T value(size_t i) {
+    const uint64_t patterns[] = {0, 1, 0xAAAAAAAAAAAAAAAAULL, 0x5555555555555555ULL, 0x8000000000000001ULL,
+                                 0x0123456789ABCDEFULL, ~uint64_t{0}};
+    return static_cast<T>(patterns[i % 7] & maxValue());
+  }
+};
+
+TYPED_TEST_CASE_P(BEOrderTestSuite);
+
+TYPED_TEST_P(BEOrderTestSuite, TestGet) {
+  using Suite = BEOrderTestSuite<TypeParam>;
+  using Order = typename Suite::Order;
+  for (size_t seed = 1; seed < 8; seed++) {
+    this->fill(seed);
+    for (size_t byte = 0; byte < 3; byte++) {
+      size_t bit = byte * 8 + Suite::offset;
+      auto expected = static_cast<typename Suite::T>(Suite::refGet(this->pbuf, bit));
+      EXPECT_EQ(expected, Order::get_word(this->pbuf, bit));
+      EXPECT_EQ(expected, Order::get_bytes(this->pbuf, bit));
+      EXPECT_EQ(expected, Order::get(this->pbuf, bit, Suite::buf_bytes));
+    }
+  }
+}
+
+TYPED_TEST_P(BEOrderTestSuite, TestSet) {
+  using Suite = BEOrderTestSuite<TypeParam>;
+  using Order = typename Suite::Order;
+  for (size_t i = 0; i < 7; i++) {
+    for (size_t byte = 0; byte < 3; byte++) {
+      size_t bit = byte * 8 + Suite::offset;
+      auto value = Suite::value(i);
+      // surrounding bits must not change
+      this->fill(i + 11);
+      Suite::refSet(this->expected, bit, value);
+      Order::set_word(this->pbuf, bit, value);
+      EXPECT_EQ(0, memcmp(this->expected, this->pbuf, Suite::buf_bytes));
+      this->fill(i + 11);
+      Suite::refSet(this->expected, bit, value);
+      Order::set_bytes(this->pbuf, bit, value);
+      EXPECT_EQ(0, memcmp(this->expected, this->pbuf, Suite::buf_bytes));
+      this->fill(i + 11);
+      Suite::refSet(this->expected, bit, value);
+      Order::set(this->pbuf, bit, value, Suite::buf_bytes);
+      EXPECT_EQ(0, memcmp(this->expected, this->pbuf, Suite::buf_bytes));
+      EXPECT_EQ(value, Order::get(this->pbuf, bit, Suite::buf_bytes));
+    }
+  }
+}
+
+TYPED_TEST_P(BEOrderTestSuite, TestFixedOffset) {
+  using Suite = BEOrderTestSuite<TypeParam>;
+  using At0 = vstruct::internals::BEOrderAt<typename Suite::T, Suite::Sz, Suite::offset>;
+  using At9 = vstruct::internals::BEOrderAt<typename Suite::T, Suite::Sz, Suite::offset + 72>;
+  for (size_t i = 0; i < 7; i++) {
+    auto value = Suite::value(i);
+    this->fill(i + 23);
+    EXPECT_EQ(Suite::refGet(this->pbuf, Suite::offset), At0::get(this->pbuf));
+    EXPECT_EQ(Suite::refGet(this->pbuf, Suite::offset + 72), At9::get(this->pbuf));
+    Suite::refSet(this->expected, Suite::offset, value);
+    At0::set(this->pbuf, value);
+    EXPECT_EQ(0, memcmp(this->expected, this->pbuf, Suite::buf_bytes));
+    Suite::refSet(this->expected, Suite::offset + 72, value);
+    At9::set(this->pbuf, value);
+    EXPECT_EQ(0, memcmp(this->expected, this->pbuf, Suite::buf_bytes));
+    EXPECT_EQ(value, At0::get(this->pbuf));
+    EXPECT_EQ(value, At9::get(this->pbuf));
+  }
+}
+
+REGISTER_TYPED_TEST_CASE_P
+(
+    BEOrderTestSuite,
+    TestGet,
+    TestSet,
+    TestFixedOffset
+);
+
+INSTANTIATE_TYPED_TEST_CASE_P
+(
+    TestBEOrder,
+    BEOrderTestSuite,
+    AllTestArgs
+);
+
+TEST(BEOrderTest, TestNetworkOrder) {
+  vstruct::pbuf_type pbuf[8 + vstruct::slack_bytes] = {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0};
+  EXPECT_EQ(0x12345678u, (vstruct::internals::BEOrderAt<uint32_t, 32, 0>::get(pbuf)));
+  EXPECT_EQ(0x3456u, (vstruct::internals::BEOrderAt<uint16_t, 16, 8>::get(pbuf)));
+  EXPECT_EQ(0x234u, (vstruct::internals::BEOrderAt<uint16_t, 12, 4>::get(pbuf)));
+  EXPECT_EQ(0x123456789ABCDEF0ULL, (vstruct::internals::BEOrderAt<uint64_t, 64, 0>::get(pbuf)));
+  EXPECT_EQ(0x2u, (vstruct::internals::BEOrder<uint8_t, 4>::get(pbuf, 4, 8)));
+  EXPECT_EQ(0x1u, (vstruct::internals::BEOrder<uint8_t, 1>::get(pbuf, 3, 8)));
+
+  vstruct::internals::BEOrderAt<uint16_t, 16, 16>::set(pbuf, 0xCAFE);
+  EXPECT_EQ(0xCA, pbuf[2]);
+  EXPECT_EQ(0xFE, pbuf[3]);
+  vstruct::internals::BEOrder<uint8_t, 4>::set(pbuf, 36, 0x7, 8);
+  EXPECT_EQ(0x97, pbuf[4]);
+}
+
+}  // namespace
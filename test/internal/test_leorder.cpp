@@ -176,6 +176,94 @@ class LEOrderTestSuite : public testing::Test {
     }
   }
 
+  // compare bounded access against the byte loop reference, buf_bytes selects word or byte path
+  template <class Order>
+  void checkSetBounded(T value, size_t buf_bytes, const char debug_str[]) {
+    vstruct::pbuf_type expected[16];
+    for (int i = 0; i < 16; i++) {
+      pbuf[i] = 0xa5;
+      expected[i] = 0xa5;
+    }
+    vstruct::internals::LEOrder<T, Sz>::set_bytes(expected, offset, value);
+    Order::set(pbuf, offset, value, buf_bytes);
+    for (int i = 0; i < 16; i++) {
+      EXPECT_EQ(expected[i], pbuf[i])
+          << "set bounded, "
+          << debug_str
+          << ", byte:" << i << " buf_bytes:" << buf_bytes
+          << ", value:" << static_cast<uint64_t>(value) << " Sz:" << Sz
+          << " offset:" << offset;
+    }
+  }
+
+  template <class Order>
+  void checkGetBounded(T value, size_t buf_bytes, const char debug_str[]) {
+    for (int i = 0; i < 16; i++) {
+      pbuf[i] = 0x5a;
+    }
+    vstruct::internals::LEOrder<T, Sz>::set_bytes(pbuf, offset, value);
+    T output = Order::get(pbuf, offset, buf_bytes);
+    T expected = value;
+    EXPECT_EQ(output, expected)
+        << "get bounded, "
+        << debug_str
+        << " buf_bytes:" << buf_bytes
+        << ", value:" << static_cast<uint64_t>(value) << " Sz:" << Sz
+        << " offset:" << offset;
+  }
+
+  template <class Order>
+  void testBounded() {
+    const size_t field_bytes = (offset + Sz + 7) / 8;  // byte loop fallback
+    const size_t word_bytes = 16;  // word access
+    T max_packed = PackerGuess<T, Sz>::maxPacked();
+    for (size_t buf_bytes : {field_bytes, word_bytes}) {
+      checkSetBounded<Order>(0, buf_bytes, "zero");
+      checkSetBounded<Order>(T{1u} << (Sz - 1), buf_bytes, "highest bit");
+      checkSetBounded<Order>(CodeGen<T>::value & max_packed, buf_bytes, "Testvalue");
+      checkSetBounded<Order>(max_packed, buf_bytes, "max packed");
+      checkGetBounded<Order>(0, buf_bytes, "zero");
+      checkGetBounded<Order>(T{1u} << (Sz - 1), buf_bytes, "highest bit");
+      checkGetBounded<Order>(CodeGen<T>::value & max_packed, buf_bytes, "Testvalue");
+      checkGetBounded<Order>(max_packed, buf_bytes, "max packed");
+    }
+  }
+
+  // fixed offset access must match the byte loop, at offset and one byte further
+  template <size_t starting_bit>
+  void checkFixedOffset(T value, const char debug_str[]) {
+    vstruct::pbuf_type expected[16];
+    for (int i = 0; i < 16; i++) {
+      pbuf[i] = 0x3c;
+      expected[i] = 0x3c;
+    }
+    vstruct::internals::LEOrder<T, Sz>::set_bytes(expected, starting_bit, value);
+    vstruct::internals::LEOrderAt<T, Sz, starting_bit>::set(pbuf, value);
+    for (int i = 0; i < 16; i++) {
+      EXPECT_EQ(expected[i], pbuf[i])
+          << "set fixed offset, "
+          << debug_str
+          << ", byte:" << i << " starting_bit:" << starting_bit
+          << ", value:" << static_cast<uint64_t>(value) << " Sz:" << Sz;
+    }
+    T output = vstruct::internals::LEOrderAt<T, Sz, starting_bit>::get(pbuf);
+    EXPECT_EQ(value, output)
+        << "get fixed offset, "
+        << debug_str
+        << " starting_bit:" << starting_bit
+        << ", value:" << static_cast<uint64_t>(value) << " Sz:" << Sz;
+  }
+
+  void testFixedOffset() {
+    T max_packed = PackerGuess<T, Sz>::maxPacked();
+    checkFixedOffset<offset>(0, "zero");
+    checkFixedOffset<offset>(T{1u} << (Sz - 1), "highest bit");
+    checkFixedOffset<offset>(CodeGen<T>::value & max_packed, "Testvalue");
+    checkFixedOffset<offset>(max_packed, "max packed");
+    checkFixedOffset<offset + 8>(CodeGen<T>::value & max_packed, "Testvalue");
+    checkFixedOffset<offset + 8>(max_packed, "max packed");
+  }
+
   void testSet() {
     T max_packed = PackerGuess<T, Sz>::maxPacked();
     T min_packed = PackerGuess<T, Sz>::minPacked();
@@ -221,11 +309,26 @@ TYPED_TEST_P(LEOrderTestSuite, TestGet) {
   this->testGet();
 }
 
+TYPED_TEST_P(LEOrderTestSuite, TestBounded) {
+  this->template testBounded<vstruct::internals::LEOrder<typename TestFixture::T, TestFixture::Sz>>();
+}
+
+TYPED_TEST_P(LEOrderTestSuite, TestPext) {
+  this->template testBounded<vstruct::internals::LEOrderPext<typename TestFixture::T, TestFixture::Sz>>();
+}
+
+TYPED_TEST_P(LEOrderTestSuite, TestFixedOffset) {
+  this->testFixedOffset();
+}
+
 REGISTER_TYPED_TEST_CASE_P
 (
     LEOrderTestSuite,
     TestSet,
-    TestGet
+    TestGet,
+    TestBounded,
+    TestPext,
+    TestFixedOffset
 );
 
 INSTANTIATE_TYPED_TEST_CASE_P
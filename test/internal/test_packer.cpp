@@ -92,6 +92,9 @@ class PackerTestSuite : public testing::Test {
     if (output != expected) {
       volatile packedT debugging = vstruct::internals::Packer<T, Sz>::pack(value);
     }
+    bool expected_saturates = (value > PackerGuess<T, Sz>::maxPacked()) || (value < PackerGuess<T, Sz>::minPacked());
+    EXPECT_EQ(expected_saturates, (vstruct::internals::Packer<T, Sz>::saturates(value)))
+        << debug_str << ", value:" << static_cast<int64_t>(value) << " Sz:" << Sz;
   }
 
   void checkUnpack(T value, const char debug_str[]) {
@@ -194,4 +197,32 @@ INSTANTIATE_TYPED_TEST_CASE_P
     SignedTestArgs
 );
 
+TEST(TestMaskMax, Values) {
+  using vstruct::internals::MaskMax;
+  using vstruct::internals::mask_max;
+  static_assert(MaskMax<uint8_t, 0>::value == 0, "no bits");
+  static_assert(MaskMax<int16_t, 0>::value == 0, "no bits");
+  static_assert(MaskMax<int32_t, 1>::value == 0, "sign bit only");
+  static_assert(MaskMax<uint8_t, 8>::value == std::numeric_limits<uint8_t>::max(), "full width");
+  static_assert(MaskMax<int8_t, 8>::value == std::numeric_limits<int8_t>::max(), "full width");
+  static_assert(MaskMax<uint64_t, 64>::value == std::numeric_limits<uint64_t>::max(), "full width");
+  static_assert(MaskMax<int64_t, 64>::value == std::numeric_limits<int64_t>::max(), "full width");
+  static_assert(MaskMax<int32_t, 20>::value == (1 << 19) - 1, "one bit is used for sign");
+  for (size_t Sz = 1; Sz < 64; Sz++) {
+    EXPECT_EQ(uint64_t(1) << Sz, mask_max<uint64_t>(Sz) + 1);
+    EXPECT_EQ(int64_t(1) << (Sz - 1), mask_max<int64_t>(Sz) + 1);
+  }
+}
+
+TEST(TestMakeIndexList, Values) {
+  using vstruct::internals::IndexList;
+  using vstruct::internals::MakeIndexList;
+  static_assert(std::is_same<MakeIndexList<0>::type, IndexList<>>::value, "empty");
+  static_assert(std::is_same<MakeIndexList<1>::type, IndexList<0>>::value, "one");
+  static_assert(std::is_same<MakeIndexList<7>::type, IndexList<0, 1, 2, 3, 4, 5, 6>>::value, "odd");
+  static_assert(std::is_same<MakeIndexList<8>::type, IndexList<0, 1, 2, 3, 4, 5, 6, 7>>::value, "even");
+  // deeper than the default template instantiation depth if built one index at a time
+  static_assert(std::is_same<MakeIndexList<2000>::type, MakeIndexList<2000>::type>::value, "deep");
+}
+
 }  // namespace
@@ -0,0 +1,257 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+///
+///
+///
+#include <string.h>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <typeinfo>
+#include "vstruct.h"
+#include "vstruct/dynamic.h"
+#include "gtest/gtest.h"
+#include "../testlib.h"
+
+namespace {
+
+using vstruct::BEItemType;  // test target
+using vstruct::BEArrayType;  // test target
+
+template <typename TArg, uint16_t bitsArg, uint16_t SzArg>
+struct TestArgs {
+  typedef TArg T;
+  enum : uint16_t {
+    bits = bitsArg,
+    Sz = SzArg
+  };
+};
+
+using testing::Types;
+typedef Types<
+TestArgs<uint8_t, 0, 1>,
+TestArgs<uint8_t, 3, 4>,
+TestArgs<uint8_t, 7, 8>,
+TestArgs<int8_t, 1, 3>,
+TestArgs<int8_t, 9, 8>,
+TestArgs<uint16_t, 4, 12>,
+TestArgs<int16_t, 13, 15>,
+TestArgs<uint16_t, 8, 16>,
+TestArgs<int32_t, 5, 27>,
+TestArgs<uint32_t, 7, 32>,
+TestArgs<int64_t, 3, 59>,
+TestArgs<uint64_t, 7, 64>,
+TestArgs<float, 3, 32>,
+TestArgs<double, 8, 64>
+> BEItemTestArgs;
+
+template <typename TArgs>
+class BEItemTestSuite : public testing::Test {
+ public:
+  typedef typename TArgs::T T;
+  enum : uint16_t {
+    bits = TArgs::bits,
+    Sz = TArgs::Sz
+  };
+  static const size_t kBufSize = 12;
+  test_helpers::PackerGuess<T, Sz> packer_;
+  test_helpers::RandomValue<T> random_;
+
+  vstruct::pbuf_type pBufInternal_[kBufSize + vstruct::slack_bytes];
+  vstruct::pbuf_type* pBuf_ = {pBufInternal_};
+  BEItemType<T, bits, Sz> item{pBuf_};
+
+  void initBuffers(vstruct::pbuf_type initial_value = 0) {
+    memset(pBufInternal_, initial_value, sizeof(pBufInternal_));
+  }
+  void checkSetGet(T value) {
+    T expected = packer_.expected(value);
+    item = value;
+    T output = item;
+    EXPECT_EQ(expected, output)
+        <<"checkGetSet, value:" << value << ", type:" << typeid(output).name()<< ", bits:" << bits << ", Sz:" << Sz;
+  }
+};
+
+TYPED_TEST_CASE_P(BEItemTestSuite);
+
+TYPED_TEST_P(BEItemTestSuite, TestSetGet) {
+  this->initBuffers(0xff);
+  this->checkSetGet(0);
+  this->initBuffers(0xaa);
+  this->checkSetGet(this->packer_.minUnpacked());
+  this->initBuffers(0);
+  this->checkSetGet(this->packer_.maxUnpacked());
+}
+
+TYPED_TEST_P(BEItemTestSuite, TestFuzz) {
+  this->initBuffers(0xaa);
+  for (int i=0; i < 200; i++) {
+    this->checkSetGet(this->random_.randomValue());
+  }
+}
+
+REGISTER_TYPED_TEST_CASE_P
+(
+    BEItemTestSuite,
+    TestSetGet,
+    TestFuzz
+);
+
+INSTANTIATE_TYPED_TEST_CASE_P
+(
+    TestBEItem,
+    BEItemTestSuite,
+    BEItemTestArgs
+);
+
+// IPv4 style header, most significant bit first
+struct Header : public vstruct::VStruct {
+  typename vstruct::BEItem<vstruct::Root, uint8_t, 4>::type version{*this};
+  typename vstruct::BEItem<decltype(version), uint8_t, 4>::type ihl{*this};
+  typename vstruct::BEItem<decltype(ihl), uint8_t, 6>::type dscp{*this};
+  typename vstruct::BEItem<decltype(dscp), uint8_t, 2>::type ecn{*this};
+  typename vstruct::BEItem<decltype(ecn), uint16_t, 16>::type length{*this};
+  typename vstruct::BEItem<decltype(length), uint16_t, 16>::type id{*this};
+  typename vstruct::BEItem<decltype(id), uint8_t, 3>::type flags{*this};
+  typename vstruct::BEItem<decltype(flags), uint16_t, 13>::type fragment{*this};
+  typename vstruct::BEArray<decltype(fragment), uint16_t, 12, 4>::type words{*this};
+  typename vstruct::BEItem<decltype(words), int32_t, 20>::type delta{*this};
+  typename vstruct::AlignPad<decltype(delta), 1>::type pad0;
+  typename vstruct::LEItem<decltype(pad0), uint16_t, 12>::type little{*this};
+  typename vstruct::AlignPad<decltype(little), 1>::type pad1;
+  typename vstruct::BEItem<decltype(pad1), float, 32>::type value{*this};
+  using field_types = vstruct::FieldList<decltype(length), decltype(fragment), decltype(words), decltype(delta)>;
+  enum : size_t {
+    record_bits = decltype(value)::next_bit
+  };
+  static constexpr const char* field_name(size_t i) {
+    return (i == 0) ? "length" : (i == 1) ? "fragment" : (i == 2) ? "words" : (i == 3) ? "delta" : "";
+  }
+};
+
+// record buffer of a Header, zero filled
+struct HeaderBuffer {
+  vstruct::pbuf_type buffer[Header::record_bits / 8 + vstruct::slack_bytes] = {};
+  Header h;
+  HeaderBuffer() {
+    h.setBuffer(buffer);
+  }
+};
+
+TEST(TestBEItem, TestNetworkOrder) {
+  HeaderBuffer record;
+  Header& h = record.h;
+  h.version = 4;
+  h.ihl = 5;
+  h.dscp = 0x2e;
+  h.ecn = 1;
+  h.length = 0x1234;
+  h.id = 0xabcd;
+  h.flags = 2;
+  h.fragment = 0x1fff;
+  const vstruct::pbuf_type expected[] = {0x45, 0xb9, 0x12, 0x34, 0xab, 0xcd, 0x5f, 0xff};
+  EXPECT_EQ(0, memcmp(expected, h.internal_buf_, sizeof(expected)));
+  EXPECT_EQ(4, h.version);
+  EXPECT_EQ(5, h.ihl);
+  EXPECT_EQ(0x2e, h.dscp);
+  EXPECT_EQ(1, h.ecn);
+  EXPECT_EQ(0x1234, h.length);
+  EXPECT_EQ(0xabcd, h.id);
+  EXPECT_EQ(2, h.flags);
+  EXPECT_EQ(0x1fff, h.fragment);
+}
+
+TEST(TestBEItem, TestArray) {
+  HeaderBuffer record;
+  Header& h = record.h;
+  static_assert(decltype(h.words)::first_bit == 64, "after the 8 byte header");
+  const uint16_t values[] = {0x123, 0x456, 0x789, 0xabc};
+  for (size_t i = 0; i < 4; i++) {
+    h.words[i] = values[i];
+  }
+  const vstruct::pbuf_type expected[] = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc};
+  EXPECT_EQ(0, memcmp(expected, &h.internal_buf_[8], sizeof(expected)));
+  EXPECT_TRUE(std::equal(h.words.begin(), h.words.end(), values));
+  const Header& c = h;
+  EXPECT_TRUE(std::equal(c.words.cbegin(), c.words.cend(), values));
+  EXPECT_EQ(0x789, c.words[2]);
+  h.words[1] = h.words[3];
+  EXPECT_EQ(0xabc, h.words[1]);
+  std::fill(h.words.begin(), h.words.end(), 0x7ff);
+  EXPECT_EQ(4, std::count(c.words.begin(), c.words.end(), 0x7ff));
+}
+
+TEST(TestBEItem, TestMixedOrder) {
+  HeaderBuffer record;
+  Header& h = record.h;
+  h.delta = -2;
+  h.little = 0xabc;
+  h.value = 1.5f;
+  static_assert(decltype(h.delta)::first_bit == 112, "delta");
+  static_assert(decltype(h.little)::first_bit == 136, "byte aligned after the big endian fields");
+  static_assert(decltype(h.value)::first_bit == 152, "byte aligned after the little endian field");
+  // 20 bits of -2, msb first, then 4 bits of padding
+  EXPECT_EQ(0xff, h.internal_buf_[14]);
+  EXPECT_EQ(0xff, h.internal_buf_[15]);
+  EXPECT_EQ(0xe0, h.internal_buf_[16]);
+  EXPECT_EQ(0xbc, h.internal_buf_[17]);
+  EXPECT_EQ(0x0a, h.internal_buf_[18]);
+  // 1.5f is 0x3fc00000
+  EXPECT_EQ(0x3f, h.internal_buf_[19]);
+  EXPECT_EQ(0xc0, h.internal_buf_[20]);
+  EXPECT_EQ(-2, h.delta);
+  EXPECT_EQ(0xabc, h.little);
+  EXPECT_EQ(1.5f, h.value);
+}
+
+TEST(TestBEItem, TestViewField) {
+  vstruct::pbuf_type buffer[8 + vstruct::slack_bytes] = {0x45, 0xb9, 0x12, 0x34};
+  vstruct::ViewField<decltype(Header::length)> length(buffer);
+  vstruct::ConstViewField<decltype(Header::length)> read_only(buffer);
+  EXPECT_EQ(0x1234, read_only);
+  length = 0x5678;
+  EXPECT_EQ(0x56, buffer[2]);
+  EXPECT_EQ(0x78, buffer[3]);
+  EXPECT_EQ(0x5678, read_only);
+  static_assert(vstruct::IsBigEndian<decltype(length)>::value, "view of a big endian field");
+  static_assert(!vstruct::IsBigEndian<decltype(Header::little)>::value, "little endian field");
+}
+
+TEST(TestBEItem, TestNative) {
+  HeaderBuffer record;
+  Header& h = record.h;
+  uint16_t words[4] = {1, 2, 3, 0xfff};
+  vstruct::store_field<decltype(Header::words)>(h.internal_buf_, words);
+  vstruct::store_field<decltype(Header::length)>(h.internal_buf_, 0x0102);
+  EXPECT_EQ(0x01, h.internal_buf_[2]);
+  EXPECT_EQ(0x02, h.internal_buf_[3]);
+  EXPECT_EQ(0xfff, h.words[3]);
+  uint16_t out[4];
+  vstruct::load_field<decltype(Header::words)>(h.internal_buf_, out);
+  EXPECT_TRUE(std::equal(out, out + 4, words));
+}
+
+TEST(TestBEItem, TestDescribe) {
+  using Table = vstruct::FieldTable<Header>;
+  static_assert(Table::fields[0].kind == vstruct::FieldKind::be_item, "be_item");
+  static_assert(Table::fields[2].kind == vstruct::FieldKind::be_array, "be_array");
+
+  vstruct::DynamicLayout layout = vstruct::DynamicLayout::from_table<Header>();
+  HeaderBuffer record;
+  Header& h = record.h;
+  h.length = 0xbeef;
+  h.fragment = 0x1234;
+  h.words[2] = 0xa5a;
+  h.delta = -5;
+  EXPECT_EQ(0xbeef, layout.get<uint16_t>(h.internal_buf_, layout.find("length")));
+  EXPECT_EQ(0x1234, layout.get<uint16_t>(h.internal_buf_, layout.find("fragment")));
+  EXPECT_EQ(0xa5a, layout.get<uint16_t>(h.internal_buf_, layout.find("words"), 2));
+  EXPECT_EQ(-5, layout.get<int32_t>(h.internal_buf_, layout.find("delta")));
+}
+
+}  // namespace
@@ -7,6 +7,7 @@
 ///
 ///
 ///
+#include <algorithm>
 #include <string>
 #include <limits>
 #include "vstruct/itemtypes.h"
@@ -190,5 +191,169 @@ INSTANTIATE_TYPED_TEST_CASE_P
     BoolArrayTestArgs
 );
 
-}  // namespace
+// word wise operations, sizes around the 64 bit word boundaries
+typedef Types<
+TestArgs<0, 1>,
+TestArgs<3, 7>,
+TestArgs<0, 63>,
+TestArgs<5, 64>,
+TestArgs<0, 65>,
+TestArgs<7, 129>,
+TestArgs<1, 512>,
+TestArgs<13, 1000>,
+TestArgs<6, 4096>
+> BoolArrayWordsTestArgs;
+
+template <typename TArgs>
+class BoolArrayWordsTestSuite : public testing::Test {
+ public:
+  enum : uint16_t {
+    b = TArgs::b,
+    N = TArgs::N
+  };
+  enum : uint16_t {
+    other_b = (b + 3) % 11  // other array at a different bit offset
+  };
+  static const size_t kBufSize = (b + N + 7) / 8;  // no slack after the array
+  static const size_t kOtherBufSize = (other_b + N + 7) / 8;
+  vstruct::pbuf_type pBufInternal_[kBufSize];
+  vstruct::pbuf_type pOtherInternal_[kOtherBufSize];
+  vstruct::pbuf_type* pBuf_ = {pBufInternal_};
+  vstruct::pbuf_type* pOther_ = {pOtherInternal_};
+  BoolArrayType<b, N> item{pBuf_};
+  BoolArrayType<other_b, N> other{pOther_};
+  bool expected_[N];
+
+  // random bits, density is the chance of a bit being true in 1/16
+  void initBuffers(int density) {
+    for (size_t i=0; i < kBufSize; i++) {
+      pBufInternal_[i] = static_cast<vstruct::pbuf_type>(rand_r(&test_helpers::rand_seed));
+    }
+    for (size_t i=0; i < kOtherBufSize; i++) {
+      pOtherInternal_[i] = static_cast<vstruct::pbuf_type>(rand_r(&test_helpers::rand_seed));
+    }
+    for (size_t i=0; i < N; i++) {
+      item[i] = (rand_r(&test_helpers::rand_seed) & 15) < density;
+      expected_[i] = item[i];
+    }
+  }
+
+  void checkQueries(int density) {
+    size_t expected_count = 0;
+    for (size_t i=0; i < N; i++) {
+      expected_count += expected_[i] ? 1 : 0;
+    }
+    EXPECT_EQ(expected_count, item.count()) << "count, density:" << density;
+    EXPECT_EQ(expected_count > 0, item.any()) << "any, density:" << density;
+    EXPECT_EQ(expected_count == 0, item.none()) << "none, density:" << density;
+    EXPECT_EQ(expected_count == N, item.all()) << "all, density:" << density;
+    for (bool value : {true, false}) {
+      size_t pos = item.find_first(value);
+      for (size_t i=0; i < N; i++) {
+        if (expected_[i] == value) {
+          ASSERT_EQ(i, pos) << "find, value:" << value << ", density:" << density;
+          pos = item.find_next(pos, value);
+        }
+      }
+      EXPECT_EQ(N, pos) << "find end, value:" << value << ", density:" << density;
+    }
+  }
+
+  template <typename Op, typename Ref>
+  void checkCombine(Op op, Ref ref, const char debug_str[]) {
+    initBuffers(8);
+    bool other_expected[N];
+    for (size_t i=0; i < N; i++) {
+      other_expected[i] = other[i];
+    }
+    vstruct::pbuf_type first_byte = pBufInternal_[0];
+    vstruct::pbuf_type last_byte = pBufInternal_[kBufSize - 1];
+    op();
+    for (size_t i=0; i < N; i++) {
+      ASSERT_EQ(ref(expected_[i], other_expected[i]), item[i]) << debug_str << ", index:" << i;
+      ASSERT_EQ(other_expected[i], other[i]) << debug_str << ", other changed, index:" << i;
+    }
+    // bits outside the array are unchanged
+    vstruct::pbuf_type low_mask = static_cast<vstruct::pbuf_type>((1u << b) - 1);
+    EXPECT_EQ(first_byte & low_mask, pBufInternal_[0] & low_mask) << debug_str;
+    size_t end_bit = (b + N) & 7;
+    if (end_bit) {
+      vstruct::pbuf_type high_mask = static_cast<vstruct::pbuf_type>(~((1u << end_bit) - 1));
+      EXPECT_EQ(last_byte & high_mask, pBufInternal_[kBufSize - 1] & high_mask) << debug_str;
+    }
+  }
+};
+
+TYPED_TEST_CASE_P(BoolArrayWordsTestSuite);
+TYPED_TEST_P(BoolArrayWordsTestSuite, TestQueries) {
+  for (int density : {0, 1, 8, 15, 16}) {
+    for (int i=0; i < 5; i++) {
+      this->initBuffers(density);
+      this->checkQueries(density);
+    }
+  }
+}
+
+TYPED_TEST_P(BoolArrayWordsTestSuite, TestCombine) {
+  auto& item = this->item;
+  auto& other = this->other;
+  for (int i=0; i < 5; i++) {
+    this->checkCombine([&]() { item.and_with(other); }, [](bool x, bool y) { return x && y; }, "and_with");
+    this->checkCombine([&]() { item.or_with(other); }, [](bool x, bool y) { return x || y; }, "or_with");
+    this->checkCombine([&]() { item.xor_with(other); }, [](bool x, bool y) { return x != y; }, "xor_with");
+  }
+}
+
+TYPED_TEST_P(BoolArrayWordsTestSuite, TestIterators) {
+  const size_t N = this->N;
+  auto& item = this->item;
+  const auto& constItem = this->item;
+  for (int i=0; i < 5; i++) {
+    this->initBuffers(8);
+    EXPECT_EQ(static_cast<ptrdiff_t>(N), constItem.end() - constItem.begin());
+    EXPECT_EQ(item.count(), static_cast<size_t>(std::count(constItem.begin(), constItem.end(), true)));
+    size_t k = 0;
+    for (bool x : constItem) {
+      ASSERT_EQ(this->expected_[k], x) << "index:" << k;
+      k++;
+    }
+    EXPECT_EQ(N, k);
+    // read only proxy over a const buffer
+    BoolArrayType<TestFixture::b, TestFixture::N, vstruct::ConstBufferPtr> readOnly{this->pBufInternal_};
+    EXPECT_TRUE(std::equal(readOnly.begin(), readOnly.end(), this->expected_));
+    EXPECT_EQ(this->expected_[N - 1], readOnly[N - 1]);
+    EXPECT_EQ(item.count(), readOnly.count());
+    auto it = constItem.end();
+    for (k = N; k > 0; k--) {
+      ASSERT_EQ(this->expected_[k - 1], *--it) << "reverse, index:" << k - 1;
+    }
 
+    // write through the mutable iterator, then sort puts the false elements first
+    std::fill(item.begin(), item.begin() + N / 2, true);
+    for (k = 0; k < N / 2; k++) {
+      this->expected_[k] = true;
+    }
+    size_t count = item.count();
+    std::sort(item.begin(), item.end());
+    for (k = 0; k < N; k++) {
+      ASSERT_EQ(k >= N - count, item[k]) << "sort, index:" << k;
+    }
+  }
+}
+
+REGISTER_TYPED_TEST_CASE_P
+(
+    BoolArrayWordsTestSuite,
+    TestQueries,
+    TestCombine,
+    TestIterators
+);
+
+INSTANTIATE_TYPED_TEST_CASE_P
+(
+    TestBoolArrayWords,
+    BoolArrayWordsTestSuite,
+    BoolArrayWordsTestArgs
+);
+
+}  // namespace
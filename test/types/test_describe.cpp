@@ -0,0 +1,90 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+///
+///
+///
+#include <string.h>
+#include "vstruct/itemtypes.h"
+#include "vstruct/describe.h"
+#include "gtest/gtest.h"
+#include "../testlib.h"
+
+namespace {
+
+using vstruct::FieldDescriptor;  // test target
+using vstruct::FieldKind;
+using vstruct::FieldTable;
+
+// hand written struct with names
+struct Named : public vstruct::VStruct {
+  typename vstruct::LEItem<vstruct::Root, uint16_t, 12>::type a{*this};
+  typename vstruct::BoolItem<decltype(a)>::type b{*this};
+  typename vstruct::AlignPad<decltype(b), 1>::type pad;
+  typename vstruct::LEArray<decltype(pad), int8_t, 5, 3>::type c{*this};
+  typename vstruct::BoolArray<decltype(c), 10>::type d{*this};
+  using field_types = vstruct::FieldList<decltype(a), decltype(b), decltype(c), decltype(d)>;
+  static constexpr const char* field_name(size_t i) {
+    return (i == 0) ? "a" : (i == 1) ? "b" : (i == 2) ? "c" : (i == 3) ? "d" : "";
+  }
+};
+
+// hand written struct without names
+struct Unnamed : public vstruct::VStruct {
+  typename vstruct::LEItem<vstruct::Root, double, 64>::type x{*this};
+  using field_types = vstruct::FieldList<decltype(x)>;
+};
+
+TEST(TestDescribe, HandWritten) {
+  using Table = FieldTable<Named>;
+  static_assert(Table::size == 4, "one descriptor per field");
+  static_assert(Table::fields[2].first_bit == 16, "c is after the padding");
+  static_assert(Table::find("d") == 3, "lookup by name");
+  static_assert(Table::find("e") == Table::size, "no such field");
+
+  const FieldDescriptor& a = Table::fields[0];
+  EXPECT_STREQ("a", a.name);
+  EXPECT_EQ(FieldKind::le_item, a.kind);
+  EXPECT_STREQ("uint16_t", a.type);
+  EXPECT_EQ(0u, a.first_bit);
+  EXPECT_EQ(12u, a.Sz);
+  EXPECT_EQ(1u, a.N);
+  EXPECT_FALSE(a.is_signed);
+
+  const FieldDescriptor& b = Table::fields[1];
+  EXPECT_EQ(FieldKind::bool_item, b.kind);
+  EXPECT_STREQ("bool", b.type);
+  EXPECT_EQ(12u, b.first_bit);
+
+  const FieldDescriptor& c = Table::fields[2];
+  EXPECT_EQ(FieldKind::le_array, c.kind);
+  EXPECT_STREQ("int8_t", c.type);
+  EXPECT_EQ(5u, c.Sz);
+  EXPECT_EQ(3u, c.N);
+  EXPECT_TRUE(c.is_signed);
+  EXPECT_EQ(31u, c.next_bit());
+
+  const FieldDescriptor& d = Table::fields[3];
+  EXPECT_EQ(FieldKind::bool_array, d.kind);
+  EXPECT_EQ(10u, d.bit_size());
+
+  size_t count = 0;
+  for (const FieldDescriptor& f : Table()) {
+    EXPECT_EQ(&Table::fields[count], &f);
+    count++;
+  }
+  EXPECT_EQ(4u, count);
+}
+
+TEST(TestDescribe, WithoutNames) {
+  using Table = FieldTable<Unnamed>;
+  EXPECT_STREQ("", Table::fields[0].name);
+  EXPECT_STREQ("double", Table::fields[0].type);
+  EXPECT_EQ(64u, Table::fields[0].Sz);
+  EXPECT_EQ(Table::size, Table::find("x"));
+}
+
+}  // namespace
@@ -0,0 +1,179 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+///
+///
+///
+#include <string.h>
+#include <string>
+#include <limits>
+#include "vstruct/itemtypes.h"
+#include "vstruct/fieldgroup.h"
+#include "gtest/gtest.h"
+#include "../testlib.h"
+
+namespace {
+
+using vstruct::FieldGroup;  // test target
+using vstruct::LEItemType;
+using vstruct::BoolItemType;
+
+template <uint16_t baseArg>
+struct TestArgs {
+  enum : uint16_t {
+    base = baseArg
+  };
+};
+using testing::Types;
+typedef Types<
+TestArgs<0>,
+TestArgs<1>,
+TestArgs<8>,
+TestArgs<9>,
+TestArgs<17>
+> FieldGroupTestArgs;
+
+template <typename TArgs>
+class FieldGroupTestSuite : public testing::Test {
+ public:
+  enum : uint16_t {
+    base = TArgs::base
+  };
+  static const size_t kBufSize = 16;
+  vstruct::pbuf_type pBufInternal_[kBufSize];
+  vstruct::pbuf_type pBufExpected_[kBufSize];
+  vstruct::pbuf_type* pBuf_ = {pBufInternal_};
+  vstruct::pbuf_type* pExpected_ = {pBufExpected_};
+
+  // 8 bit lanes, fields with gaps between them
+  BoolItemType<base> b0{pBuf_};
+  LEItemType<uint8_t, base + 1, 2> x0{pBuf_};
+  LEItemType<int8_t, base + 3, 3> x1{pBuf_};
+  LEItemType<int16_t, base + 9, 8> x2{pBuf_};
+  LEItemType<uint8_t, base + 20, 5> x3{pBuf_};
+  BoolItemType<base + 40> b1{pBuf_};
+  using Group8 = FieldGroup<uint8_t, decltype(b0), decltype(x0), decltype(x1), decltype(x2), decltype(x3),
+                            decltype(b1)>;
+  LEItemType<uint8_t, base, 1> e_b0{pExpected_};  // bool fields written as 1 bit integers
+  LEItemType<uint8_t, base + 1, 2> e_x0{pExpected_};
+  LEItemType<int8_t, base + 3, 3> e_x1{pExpected_};
+  LEItemType<int16_t, base + 9, 8> e_x2{pExpected_};
+  LEItemType<uint8_t, base + 20, 5> e_x3{pExpected_};
+  LEItemType<uint8_t, base + 40, 1> e_b1{pExpected_};
+
+  // 16 bit lanes, adjacent fields
+  LEItemType<uint16_t, base, 11> y0{pBuf_};
+  LEItemType<int16_t, base + 11, 9> y1{pBuf_};
+  LEItemType<uint32_t, base + 20, 16> y2{pBuf_};
+  using Group16 = FieldGroup<uint16_t, decltype(y0), decltype(y1), decltype(y2)>;
+  LEItemType<uint16_t, base, 11> e_y0{pExpected_};
+  LEItemType<int16_t, base + 11, 9> e_y1{pExpected_};
+  LEItemType<uint32_t, base + 20, 16> e_y2{pExpected_};
+
+  void initBuffers() {
+    for (size_t i=0; i < kBufSize; i++) {
+      pBufInternal_[i] = static_cast<vstruct::pbuf_type>(rand_r(&test_helpers::rand_seed));
+      pBufExpected_[i] = pBufInternal_[i];
+    }
+  }
+
+  uint64_t randomLanes() {
+    uint64_t x = static_cast<uint64_t>(rand_r(&test_helpers::rand_seed));
+    x = (x << 31) ^ static_cast<uint64_t>(rand_r(&test_helpers::rand_seed));
+    x = (x << 31) ^ static_cast<uint64_t>(rand_r(&test_helpers::rand_seed));
+    return x;
+  }
+
+  // extract must match the individual field getters
+  void checkExtract() {
+    initBuffers();
+    uint64_t lanes8 = Group8::extract(pBuf_);
+    EXPECT_EQ(static_cast<bool>(b0), Group8::template get<0>(lanes8)) << "base:" << base;
+    EXPECT_EQ(static_cast<uint8_t>(x0), Group8::template get<1>(lanes8)) << "base:" << base;
+    EXPECT_EQ(static_cast<int8_t>(x1), Group8::template get<2>(lanes8)) << "base:" << base;
+    EXPECT_EQ(static_cast<int16_t>(x2), Group8::template get<3>(lanes8)) << "base:" << base;
+    EXPECT_EQ(static_cast<uint8_t>(x3), Group8::template get<4>(lanes8)) << "base:" << base;
+    EXPECT_EQ(static_cast<bool>(b1), Group8::template get<5>(lanes8)) << "base:" << base;
+    EXPECT_EQ(0u, lanes8 & ~static_cast<uint64_t>(Group8::lane_mask)) << "base:" << base;
+
+    uint64_t lanes16 = Group16::extract(pBuf_);
+    EXPECT_EQ(static_cast<uint16_t>(y0), Group16::template get<0>(lanes16)) << "base:" << base;
+    EXPECT_EQ(static_cast<int16_t>(y1), Group16::template get<1>(lanes16)) << "base:" << base;
+    EXPECT_EQ(static_cast<uint32_t>(y2), Group16::template get<2>(lanes16)) << "base:" << base;
+    EXPECT_EQ(0u, lanes16 & ~static_cast<uint64_t>(Group16::lane_mask)) << "base:" << base;
+  }
+
+  // insert must match the individual field setters and keep the bits between fields
+  void checkInsert() {
+    initBuffers();
+    uint64_t lanes8 = randomLanes() & Group8::lane_mask;
+    Group8::insert(pBuf_, lanes8);
+    e_b0 = Group8::template get<0>(lanes8);
+    e_x0 = Group8::template get<1>(lanes8);
+    e_x1 = Group8::template get<2>(lanes8);
+    e_x2 = Group8::template get<3>(lanes8);
+    e_x3 = Group8::template get<4>(lanes8);
+    e_b1 = Group8::template get<5>(lanes8);
+    EXPECT_EQ(0, memcmp(pBufExpected_, pBufInternal_, kBufSize)) << "insert 8 bit lanes, base:" << base;
+
+    uint64_t lanes16 = randomLanes() & Group16::lane_mask;
+    Group16::insert(pBuf_, lanes16);
+    e_y0 = Group16::template get<0>(lanes16);
+    e_y1 = Group16::template get<1>(lanes16);
+    e_y2 = Group16::template get<2>(lanes16);
+    EXPECT_EQ(0, memcmp(pBufExpected_, pBufInternal_, kBufSize)) << "insert 16 bit lanes, base:" << base;
+  }
+
+  // BMI2 and portable paths must agree
+  template <class Group>
+  void checkPaths() {
+#if VSTRUCT_X86_BMI2
+    if (!vstruct::internals::CpuFeatures::get().bmi2) {
+      return;
+    }
+    uint64_t word = randomLanes();
+    EXPECT_EQ(Group::Lanes_::spread(word), Group::spread_bmi2(word)) << "spread, base:" << base;
+    uint64_t lanes = randomLanes();
+    EXPECT_EQ(Group::Lanes_::gather(lanes), Group::gather_bmi2(lanes)) << "gather, base:" << base;
+#endif
+  }
+};
+
+TYPED_TEST_CASE_P(FieldGroupTestSuite);
+TYPED_TEST_P(FieldGroupTestSuite, TestExtract) {
+  for (int i=0; i < 20; i++) {
+    this->checkExtract();
+  }
+}
+
+TYPED_TEST_P(FieldGroupTestSuite, TestInsert) {
+  for (int i=0; i < 20; i++) {
+    this->checkInsert();
+  }
+}
+
+TYPED_TEST_P(FieldGroupTestSuite, TestPaths) {
+  for (int i=0; i < 20; i++) {
+    this->template checkPaths<typename TestFixture::Group8>();
+    this->template checkPaths<typename TestFixture::Group16>();
+  }
+}
+
+REGISTER_TYPED_TEST_CASE_P
+(
+    FieldGroupTestSuite,
+    TestExtract,
+    TestInsert,
+    TestPaths
+);
+
+INSTANTIATE_TYPED_TEST_CASE_P
+(
+    TestFieldGroup,
+    FieldGroupTestSuite,
+    FieldGroupTestArgs
+);
+}  // namespace
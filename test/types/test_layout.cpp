@@ -0,0 +1,161 @@
+///
+/// Copyright (c) 2019 Joseph Lee Yuan Sheng
+///
+/// This file is part of vstruct which is released under MIT license.
+/// See LICENSE file or go to https://github.com/joseph-lys/vstruct for full license details.
+///
+///
+///
+///
+#include <string.h>
+#include <type_traits>
+#include "vstruct/itemtypes.h"
+#include "vstruct/describe.h"
+#include "vstruct/layout.h"
+#include "gtest/gtest.h"
+#include "../testlib.h"
+
+namespace {
+
+using vstruct::Layout;  // test target
+using vstruct::LayoutFieldList;
+using vstruct::FieldTable;
+
+// chain form
+struct Chain : public vstruct::VStruct {
+  typename vstruct::AlignPad<vstruct::Root, 4>::type pad0;
+  typename vstruct::BoolItem<decltype(pad0)>::type b0{*this};
+  typename vstruct::LEItem<decltype(b0), int8_t, 3>::type x0{*this};
+  typename vstruct::LEItem<decltype(x0), uint32_t, 26>::type x1{*this};
+  typename vstruct::AlignPad<decltype(x1), 2>::type pad1;
+  typename vstruct::LEArray<decltype(pad1), uint16_t, 11, 8>::type a0{*this};
+  typename vstruct::BoolArray<decltype(a0), 5>::type b1{*this};
+  typename vstruct::LEItem<decltype(b1), double, 64>::type d0{*this};
+  typename vstruct::LEItem<decltype(d0), int64_t, 59>::type x2{*this};
+  using field_types = vstruct::FieldList<decltype(x0), decltype(x1), decltype(a0), decltype(b1), decltype(d0),
+                                         decltype(x2)>;
+};
+
+struct x1_tag;
+struct d0_tag;
+
+// the same layout in flat form
+using Flat = Layout<
+    vstruct::Pad<4>,
+    vstruct::Bool,
+    vstruct::Field<int8_t, 3>,
+    vstruct::Named<x1_tag, vstruct::Field<uint32_t, 26>>,
+    vstruct::Pad<2>,
+    vstruct::Array<uint16_t, 11, 8>,
+    vstruct::Bools<5>,
+    vstruct::Named<d0_tag, vstruct::Field<double>>,
+    vstruct::Field<int64_t, 59>>;
+
+TEST(TestLayout, SameTypesAsChain) {
+  static_assert(std::is_same<Flat::type<1>, decltype(Chain::b0)>::value, "b0");
+  static_assert(std::is_same<Flat::type<2>, decltype(Chain::x0)>::value, "x0");
+  static_assert(std::is_same<Flat::type<3>, decltype(Chain::x1)>::value, "x1");
+  static_assert(std::is_same<Flat::type<4>, decltype(Chain::pad1)>::value, "pad1");
+  static_assert(std::is_same<Flat::type<5>, decltype(Chain::a0)>::value, "a0");
+  static_assert(std::is_same<Flat::type<6>, decltype(Chain::b1)>::value, "b1");
+  static_assert(std::is_same<Flat::type<7>, decltype(Chain::d0)>::value, "d0");
+  static_assert(std::is_same<Flat::type<8>, decltype(Chain::x2)>::value, "x2");
+  static_assert(static_cast<size_t>(Flat::record_bits) == static_cast<size_t>(decltype(Chain::x2)::next_bit),
+                "same record size");
+  static_assert(Flat::first_bit(5) == 32, "a0 after the 2 byte padding");
+  static_assert(Flat::index_of<x1_tag>::value == 3, "lookup by tag");
+  static_assert(Flat::index_of<d0_tag>::value == 7, "lookup by tag");
+  static_assert(std::is_same<decltype(std::declval<Flat>().get<d0_tag>()),
+                             vstruct::ViewField<decltype(Chain::d0)>>::value, "get by tag");
+}
+
+// spec I of Wide: 3 bit fields with a 2 byte padding at 300
+template <size_t I>
+struct WideSpec {
+  using type = typename std::conditional<I == 300, vstruct::Pad<2>, vstruct::Field<uint8_t, 3>>::type;
+};
+
+template <typename Indices>
+struct WideLayout;
+
+template <size_t... I>
+struct WideLayout<vstruct::internals::IndexList<I...>> {
+  using type = Layout<typename WideSpec<I>::type...>;
+};
+
+// more specs than the default constexpr and template depth limits
+using Wide = WideLayout<vstruct::internals::MakeIndexList<600>::type>::type;
+
+TEST(TestLayout, ManySpecs) {
+  static_assert(Wide::size == 600, "600 specs");
+  static_assert(Wide::first_bit(299) == 897, "before the padding");
+  static_assert(Wide::first_bit(301) == 912, "2 byte aligned after the padding");
+  static_assert(Wide::first_bit(599) == 912 + 298 * 3, "last spec");
+  static_assert(Wide::record_bits == 912 + 299 * 3, "record size");
+  static_assert(Wide::type<599>::first_bit == 912 + 298 * 3, "storage type of the last spec");
+  static_assert(LayoutFieldList<Wide>::size == 599, "padding excluded");
+
+  uint8_t buffer[Wide::record_bytes + vstruct::slack_bytes];
+  memset(buffer, 0, sizeof(buffer));
+  Wide wide(buffer);
+  wide.get<0>() = 5;
+  wide.get<299>() = 7;
+  wide.get<301>() = 6;
+  wide.get<599>() = 3;
+  EXPECT_EQ(5, wide.get<0>());
+  EXPECT_EQ(7, wide.get<299>());
+  EXPECT_EQ(6, wide.get<301>());
+  EXPECT_EQ(3, wide.get<599>());
+  EXPECT_EQ(0, wide.get<598>());
+  EXPECT_EQ(0, wide.get<302>());
+}
+
+TEST(TestLayout, PaddingExcludedFromFields) {
+  using Fields = LayoutFieldList<Flat>;
+  static_assert(Fields::size == 7, "two pads excluded");
+  using Table = FieldTable<Flat, Fields>;
+  using ChainTable = FieldTable<Chain>;
+  static_assert(Table::fields[1].first_bit == ChainTable::fields[0].first_bit, "x0");
+  static_assert(Table::fields[6].first_bit == ChainTable::fields[5].first_bit, "x2");
+  EXPECT_EQ(vstruct::FieldKind::bool_item, Table::fields[0].kind);
+  EXPECT_EQ(vstruct::FieldKind::le_array, Table::fields[3].kind);
+  EXPECT_EQ(8u, Table::fields[3].N);
+  EXPECT_STREQ("double", Table::fields[5].type);
+}
+
+TEST(TestLayout, ReadWriteSameBuffer) {
+  alignas(8) uint8_t buffer[Flat::record_bytes + vstruct::slack_bytes];
+  memset(buffer, 0, sizeof(buffer));
+  Chain chain;
+  chain.setBuffer(buffer);
+  Flat flat(buffer);
+
+  flat.get<1>() = true;
+  flat.get<2>() = -3;
+  flat.get<x1_tag>() = 12345678;
+  for (size_t i = 0; i < 8; i++) {
+    flat.get<5>()[i] = static_cast<uint16_t>(100 * i + 1);
+  }
+  flat.get<6>()[4] = true;
+  flat.get<d0_tag>() = 2.5;
+  flat.get<8>() = -1234567890123LL;
+
+  EXPECT_TRUE(chain.b0);
+  EXPECT_EQ(-3, chain.x0);
+  EXPECT_EQ(12345678u, chain.x1);
+  for (size_t i = 0; i < 8; i++) {
+    EXPECT_EQ(100 * i + 1, chain.a0[i]);
+  }
+  EXPECT_FALSE(chain.b1[3]);
+  EXPECT_TRUE(chain.b1[4]);
+  EXPECT_EQ(2.5, chain.d0);
+  EXPECT_EQ(-1234567890123LL, chain.x2);
+
+  chain.x1 = 7;
+  chain.a0[7] = 2047;
+  EXPECT_EQ(7u, flat.get<3>());
+  EXPECT_EQ(2047, flat.get<5>()[7]);
+  EXPECT_EQ(-3, flat.get<2>());
+}
+
+}  // namespace
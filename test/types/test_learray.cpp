@@ -16,6 +16,8 @@
 ///
 ///
 ///
+#include <string.h>
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include <limits>
@@ -232,5 +234,249 @@ INSTANTIATE_TYPED_TEST_CASE_P
     LEArrayTestSuite,
     LEArraySmokeTestArgs
 );
-}  // namespace
 
+// bulk access, arrays long enough for the simd kernels
+template <typename TArg, uint16_t bitsArg, uint16_t SzArg>
+struct BulkTestArgs {
+  typedef TArg T;
+  enum : uint16_t {
+    bits = bitsArg,
+    Sz = SzArg,
+    N = 301
+  };
+};
+
+typedef Types<
+BulkTestArgs<uint8_t, 0, 1>,
+BulkTestArgs<int8_t, 3, 3>,
+BulkTestArgs<uint8_t, 0, 4>,
+BulkTestArgs<int8_t, 4, 4>,
+BulkTestArgs<uint16_t, 12, 4>,
+BulkTestArgs<int32_t, 8, 4>,
+BulkTestArgs<int64_t, 4, 4>,
+BulkTestArgs<int8_t, 1, 8>,
+BulkTestArgs<uint8_t, 7, 8>,
+BulkTestArgs<uint16_t, 2, 11>,
+BulkTestArgs<int16_t, 15, 11>,
+BulkTestArgs<int16_t, 0, 12>,
+BulkTestArgs<uint16_t, 4, 12>,
+BulkTestArgs<int16_t, 3, 16>,
+BulkTestArgs<uint16_t, 8, 16>,
+BulkTestArgs<uint32_t, 1, 25>,
+BulkTestArgs<int32_t, 6, 25>,
+BulkTestArgs<uint64_t, 2, 9>,
+BulkTestArgs<int64_t, 5, 19>,
+BulkTestArgs<int32_t, 3, 31>,
+BulkTestArgs<float, 5, 32>,
+BulkTestArgs<int64_t, 3, 60>
+> LEArrayBulkTestArgs;
+
+template <typename TArgs>
+class LEArrayBulkTestSuite : public testing::Test {
+ public:
+  typedef typename TArgs::T T;
+  enum : uint16_t {
+    bits = TArgs::bits,
+    Sz = TArgs::Sz,
+    N = TArgs::N
+  };
+  static const size_t kBufSize = (bits + Sz * N + 7) / 8;  // no slack after the array
+  using Unpack = vstruct::internals::LEArrayUnpack<T, Sz, bits & 7>;
+
+  using Packer = vstruct::internals::Packer<T, Sz>;
+
+  vstruct::pbuf_type pBufInternal_[kBufSize];
+  vstruct::pbuf_type* pBuf_ = {pBufInternal_};
+  LEArrayType<T, bits, Sz, N> item{pBuf_};
+  vstruct::pbuf_type pRefInternal_[kBufSize];
+  vstruct::pbuf_type* pRef_ = {pRefInternal_};
+  LEArrayType<T, bits, Sz, N> refItem{pRef_};
+  T expected_[N];
+  T output_[N];
+  T input_[N];
+
+  void initBuffers() {
+    for (size_t i=0; i < kBufSize; i++) {
+      pBufInternal_[i] = static_cast<vstruct::pbuf_type>(rand_r(&test_helpers::rand_seed));
+    }
+    for (size_t i=0; i < N; i++) {
+      expected_[i] = item[i];
+    }
+  }
+
+  void initInput() {
+    uint8_t* p = reinterpret_cast<uint8_t*>(input_);
+    for (size_t i=0; i < sizeof(input_); i++) {
+      p[i] = static_cast<uint8_t>(rand_r(&test_helpers::rand_seed));
+    }
+    for (size_t i=0; i < N; i += 2) {  // half of the inputs in range
+      input_[i] = expected_[(i * 7) % N];
+    }
+  }
+
+  void checkPack(size_t first, size_t count) {
+    initBuffers();
+    initInput();
+    memcpy(pRefInternal_, pBufInternal_, kBufSize);
+    size_t expected_saturated = 0;
+    for (size_t i=0; i < count; i++) {
+      refItem[first + i] = input_[i];
+      if (!std::is_floating_point<T>::value && Packer::unpack(Packer::pack(input_[i])) != input_[i]) {
+        expected_saturated++;
+      }
+    }
+    size_t saturated = item.pack_from(input_, first, count);
+    EXPECT_EQ(expected_saturated, saturated) << "first:" << first << ", count:" << count
+        << ", bits:" << bits << ", Sz:" << Sz;
+    for (size_t i=0; i < kBufSize; i++) {
+      EXPECT_EQ(pRefInternal_[i], pBufInternal_[i]) << "first:" << first << ", count:" << count
+          << ", byte:" << i << ", bits:" << bits << ", Sz:" << Sz;
+    }
+  }
+
+  void checkOutput(size_t first, size_t count, const char debug_str[]) {
+    for (size_t i=0; i < count; i++) {  // compare bytes, random floats may be nan
+      EXPECT_EQ(0, memcmp(&expected_[first + i], &output_[i], sizeof(T)))
+          << debug_str << ", first:" << first << ", count:" << count << ", index:" << first + i
+          << ", bits:" << bits << ", Sz:" << Sz;
+    }
+  }
+
+  void checkUnpack(size_t first, size_t count) {
+    item.unpack_to(output_, first, count);
+    checkOutput(first, count, "unpack_to");
+  }
+
+  template <class Kernel>
+  void checkKernel(size_t first, size_t count, bool supported, const char debug_str[]) {
+    if (!Kernel::enabled || !supported) {
+      return;
+    }
+    const vstruct::pbuf_type* pData = &pBufInternal_[bits >> 3];
+    bool used = Unpack::template run_kernel<Kernel>(pData, kBufSize - (bits >> 3), first, count, output_);
+    EXPECT_TRUE(used || count < 2 * Kernel::lanes) << debug_str << ", kernel not used";
+    if (used) {
+      checkOutput(first, count, debug_str);
+    }
+  }
+};
+
+TYPED_TEST_CASE_P(LEArrayBulkTestSuite);
+TYPED_TEST_P(LEArrayBulkTestSuite, TestUnpack) {
+  const size_t N = this->N;
+  for (int i=0; i < 10; i++) {
+    this->initBuffers();
+    this->checkUnpack(0, N);
+    this->checkUnpack(1, N - 1);
+    this->checkUnpack(7, 100);
+    this->checkUnpack(33, 200);
+    this->checkUnpack(N - 3, 3);
+    this->checkUnpack(13, 0);
+  }
+}
+
+TYPED_TEST_P(LEArrayBulkTestSuite, TestUnpackKernels) {
+#if VSTRUCT_X86_SIMD
+  typedef typename TestFixture::T T;
+  const vstruct::internals::CpuFeatures& cpu = vstruct::internals::CpuFeatures::get();
+  using Avx2 = vstruct::internals::UnpackAvx2<T, TestFixture::Sz, TestFixture::bits & 7>;
+  using NibbleSse2 = vstruct::internals::UnpackNibbleSse2<T, TestFixture::Sz, TestFixture::bits & 7>;
+  const size_t N = this->N;
+  for (int i=0; i < 10; i++) {
+    this->initBuffers();
+    this->template checkKernel<Avx2>(0, N, cpu.avx2, "avx2");
+    this->template checkKernel<Avx2>(3, N - 3, cpu.avx2, "avx2");
+    this->template checkKernel<Avx2>(9, 64, cpu.avx2, "avx2");
+    this->template checkKernel<NibbleSse2>(0, N, cpu.sse2, "nibble sse2");
+    this->template checkKernel<NibbleSse2>(5, N - 5, cpu.sse2, "nibble sse2");
+    this->template checkKernel<NibbleSse2>(1, 96, cpu.sse2, "nibble sse2");
+  }
+#endif
+}
+
+TYPED_TEST_P(LEArrayBulkTestSuite, TestPack) {
+  const size_t N = this->N;
+  for (int i=0; i < 10; i++) {
+    this->checkPack(0, N);
+    this->checkPack(1, N - 1);
+    this->checkPack(7, 100);
+    this->checkPack(33, 200);
+    this->checkPack(N - 3, 3);
+    this->checkPack(13, 0);
+  }
+}
+
+TYPED_TEST_P(LEArrayBulkTestSuite, TestIterators) {
+  typedef typename TestFixture::T T;
+  const size_t N = this->N;
+  for (int i=0; i < 10; i++) {
+    this->initBuffers();
+    const auto& constItem = this->item;
+    EXPECT_EQ(static_cast<ptrdiff_t>(N), constItem.end() - constItem.begin());
+    std::copy(constItem.begin(), constItem.end(), this->output_);  // forward walk on the cached word
+    this->checkOutput(0, N, "const_iterator");
+    auto it = constItem.end();
+    for (size_t k = N; k > 0; k--) {  // backward walk
+      T x = *--it;
+      EXPECT_EQ(0, memcmp(&this->expected_[k - 1], &x, sizeof(T))) << "reverse, index:" << k - 1;
+    }
+    for (size_t k = 0; k < N; k += 37) {  // random access
+      T x = constItem.begin()[k];
+      EXPECT_EQ(0, memcmp(&this->expected_[k], &x, sizeof(T))) << "random, index:" << k;
+    }
+
+    // read only proxy over a const buffer
+    LEArrayType<T, TestFixture::bits, TestFixture::Sz, TestFixture::N, vstruct::ConstBufferPtr> readOnly{
+        this->pBufInternal_};
+    for (size_t k = 0; k < N; k += 13) {
+      T x = readOnly[k];
+      EXPECT_EQ(0, memcmp(&this->expected_[k], &x, sizeof(T))) << "read only, index:" << k;
+    }
+
+    // write through the mutable iterator
+    this->initInput();
+    std::copy(this->input_, this->input_ + N, this->item.begin());
+    for (size_t k = 0; k < N; k++) {
+      this->refItem[k] = this->input_[k];
+    }
+    for (size_t k = 0; k < N; k++) {
+      T x = this->item[k];
+      T y = this->refItem[k];
+      EXPECT_EQ(0, memcmp(&y, &x, sizeof(T))) << "write, index:" << k;
+    }
+  }
+}
+
+TYPED_TEST_P(LEArrayBulkTestSuite, TestSort) {
+  typedef typename TestFixture::T T;
+  if (std::is_floating_point<T>::value) {
+    return;  // random floats may be nan
+  }
+  const size_t N = this->N;
+  this->initBuffers();
+  std::sort(this->item.begin(), this->item.end());
+  std::sort(this->expected_, this->expected_ + N);
+  for (size_t k = 0; k < N; k++) {
+    EXPECT_EQ(this->expected_[k], this->item[k]) << "index:" << k;
+  }
+  std::reverse(this->item.begin(), this->item.end());
+  EXPECT_TRUE(std::is_sorted(this->item.cbegin(), this->item.cend(), [](T x, T y) { return x > y; }));
+}
+
+REGISTER_TYPED_TEST_CASE_P
+(
+    LEArrayBulkTestSuite,
+    TestUnpack,
+    TestUnpackKernels,
+    TestPack,
+    TestIterators,
+    TestSort
+);
+
+INSTANTIATE_TYPED_TEST_CASE_P
+(
+    TestLEArrayBulk,
+    LEArrayBulkTestSuite,
+    LEArrayBulkTestArgs
+);
+}  // namespace